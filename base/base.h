@@ -5,6 +5,8 @@
 #   include <intrin.h>
 #else
 #   include <time.h> // NOTE(rune): For clock_getttime
+#   include <pthread.h>
+#   include <unistd.h> // NOTE(rune): For sysconf
 #endif
 
 #include <stdint.h>
@@ -45,6 +47,10 @@
 #include "base_os.h"
 #include "base_os.c"
 
+// rune: [h,c] jobs
+#include "base_job.h"
+#include "base_job.c"
+
 // rune: [h,c] testing
 #include "base_test.h"
 #include "base_test.c"
@@ -517,6 +517,25 @@ static inline bool f64_is_nan(f64 f) { return ((u64_from_f64(f) & F64_EXPONENT_M
 static inline f32 f32_mod(f32 a, f32 b) { return fmodf(a, b); }
 static inline f32 f32_sqrt(f32 a) { return sqrtf(a); }
 
+////////////////////////////////////////////////////////////////
+// rune: Atomics
+
+// NOTE(rune): Loads acquire, stores release, and read-modify-write operations are sequentially consistent.
+// atomic_add_i64 returns the new value, and atomic_cas_i64 returns true if *p was expect and is now desired.
+#if _WIN32
+static inline i64  atomic_load_i64(volatile i64 *p)                         { i64 v = *p; _ReadWriteBarrier(); return v; }
+static inline void atomic_store_i64(volatile i64 *p, i64 v)                 { _ReadWriteBarrier(); *p = v; }
+static inline i64  atomic_add_i64(volatile i64 *p, i64 v)                   { return InterlockedExchangeAdd64(p, v) + v; }
+static inline bool atomic_cas_i64(volatile i64 *p, i64 expect, i64 desired) { return InterlockedCompareExchange64(p, desired, expect) == expect; }
+static inline void atomic_fence(void)                                       { MemoryBarrier(); }
+#else
+static inline i64  atomic_load_i64(volatile i64 *p)                         { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void atomic_store_i64(volatile i64 *p, i64 v)                 { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline i64  atomic_add_i64(volatile i64 *p, i64 v)                   { return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST); }
+static inline bool atomic_cas_i64(volatile i64 *p, i64 expect, i64 desired) { return __atomic_compare_exchange_n(p, &expect, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED); }
+static inline void atomic_fence(void)                                       { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#endif
+
 ////////////////////////////////////////////////////////////////
 // rune: Floating point vectors
 
@@ -0,0 +1,259 @@
+////////////////////////////////////////////////////////////////
+// rune: Deque
+
+// NOTE(rune): Only called by the owning worker. Returns false when the deque is full.
+static bool job_deque_push(job_deque *deque, job *job) {
+    i64 b = deque->bottom;
+    i64 t = atomic_load_i64(&deque->top);
+    if (b - t >= JOB_DEQUE_CAPACITY) {
+        return false;
+    }
+
+    atomic_store_i64(&deque->slots[b & (JOB_DEQUE_CAPACITY - 1)], i64(job));
+    atomic_store_i64(&deque->bottom, b + 1);
+    return true;
+}
+
+// NOTE(rune): Only called by the owning worker. Races with thieves for the last job.
+static job *job_deque_pop(job_deque *deque) {
+    i64 b = deque->bottom - 1;
+    atomic_store_i64(&deque->bottom, b);
+    atomic_fence();
+    i64 t = atomic_load_i64(&deque->top);
+
+    job *ret = null;
+    if (t <= b) {
+        ret = (job *)atomic_load_i64(&deque->slots[b & (JOB_DEQUE_CAPACITY - 1)]);
+        if (t == b) {
+            if (!atomic_cas_i64(&deque->top, t, t + 1)) {
+                ret = null;
+            }
+            atomic_store_i64(&deque->bottom, b + 1);
+        }
+    } else {
+        atomic_store_i64(&deque->bottom, b + 1);
+    }
+    return ret;
+}
+
+// NOTE(rune): Called by any thread. Returns null when the deque is empty or another thread won the race.
+static job *job_deque_steal(job_deque *deque) {
+    i64 t = atomic_load_i64(&deque->top);
+    atomic_fence();
+    i64 b = atomic_load_i64(&deque->bottom);
+
+    job *ret = null;
+    if (t < b) {
+        ret = (job *)atomic_load_i64(&deque->slots[t & (JOB_DEQUE_CAPACITY - 1)]);
+        if (!atomic_cas_i64(&deque->top, t, t + 1)) {
+            ret = null;
+        }
+    }
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Scheduling
+
+static thread_local job_worker *job_tls_worker;
+
+static job_worker *job_current_worker(job_system *system) {
+    job_worker *worker = job_tls_worker;
+    if (worker && worker->system != system) {
+        worker = null;
+    }
+    return worker;
+}
+
+static job *job_take_injected(job_system *system) {
+    job *ret = null;
+    if (atomic_load_i64(&system->injected_count) > 0) {
+        os_mutex_scope(system->mutex) {
+            ret = system->injected_first;
+            if (ret) {
+                system->injected_first = ret->next;
+                if (system->injected_first == null) {
+                    system->injected_last = null;
+                }
+                atomic_add_i64(&system->injected_count, -1);
+            }
+        }
+    }
+    return ret;
+}
+
+// NOTE(rune): Own deque first, then the injection list, then steal from the other workers starting at a random one.
+static job *job_next(job_system *system, job_worker *self, u64 *rng) {
+    job *ret = null;
+    if (self) {
+        ret = job_deque_pop(&self->deque);
+    }
+
+    if (!ret) {
+        ret = job_take_injected(system);
+    }
+
+    if (!ret) {
+        *rng ^= *rng << 13;
+        *rng ^= *rng >> 7;
+        *rng ^= *rng << 17;
+
+        i64 first = i64(*rng % u64(system->worker_count));
+        for (i64 i = 0; i < system->worker_count && !ret; i++) {
+            job_worker *victim = &system->workers[(first + i) % system->worker_count];
+            if (victim != self) {
+                ret = job_deque_steal(&victim->deque);
+            }
+        }
+    }
+
+    return ret;
+}
+
+static void job_run(job *job) {
+    job_group *group = job->group;
+    job->proc(job->param);
+    heap_free(job);
+    atomic_add_i64(&group->pending, -1);
+}
+
+static void job_worker_proc(void *param) {
+    job_worker *self = param;
+    job_system *system = self->system;
+    job_tls_worker = self;
+
+    while (atomic_load_i64(&system->running)) {
+        i64 epoch = atomic_load_i64(&system->epoch);
+        job *job = job_next(system, self, &self->rng);
+        if (job) {
+            job_run(job);
+        } else {
+            os_mutex_scope(system->mutex) {
+                atomic_add_i64(&system->sleeping, 1);
+                atomic_fence();
+                if (atomic_load_i64(&system->running) && atomic_load_i64(&system->epoch) == epoch) {
+                    os_cond_wait(system->cond, system->mutex, U32_MAX);
+                }
+                atomic_add_i64(&system->sleeping, -1);
+            }
+        }
+    }
+
+    job_tls_worker = null;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: System
+
+static job_system *job_system_create(i64 worker_count) {
+    if (worker_count <= 0) {
+        worker_count = os_get_processor_count();
+    }
+
+    job_system *system = heap_alloc(sizeof(job_system));
+    memset(system, 0, sizeof(job_system));
+    system->workers      = heap_alloc(sizeof(job_worker) * worker_count);
+    system->worker_count = worker_count;
+    system->running      = 1;
+    system->mutex        = os_mutex_create();
+    system->cond         = os_cond_create();
+    memset(system->workers, 0, sizeof(job_worker) * worker_count);
+
+    for_n (i64, i, worker_count) {
+        job_worker *worker = &system->workers[i];
+        worker->system = system;
+        worker->index  = i;
+        worker->rng    = u64(i + 1) * 0x9e3779b97f4a7c15;
+    }
+
+    return system;
+}
+
+static void job_system_start(job_system *system) {
+    os_mutex_scope(system->mutex) {
+        if (!atomic_load_i64(&system->started)) {
+            for_n (i64, i, system->worker_count) {
+                job_worker *worker = &system->workers[i];
+                worker->thread = os_thread_create(job_worker_proc, worker);
+            }
+            atomic_store_i64(&system->started, 1);
+        }
+    }
+}
+
+// NOTE(rune): All groups must be waited on before the system is destroyed.
+static void job_system_destroy(job_system *system) {
+    if (system) {
+        atomic_store_i64(&system->running, 0);
+        atomic_add_i64(&system->epoch, 1);
+        os_mutex_scope(system->mutex) {
+            os_cond_signal_all(system->cond);
+        }
+
+        if (atomic_load_i64(&system->started)) {
+            for_n (i64, i, system->worker_count) {
+                os_thread_join(system->workers[i].thread);
+            }
+        }
+
+        os_cond_destroy(system->cond);
+        os_mutex_destroy(system->mutex);
+        heap_free(system->workers);
+        heap_free(system);
+    }
+}
+
+static void job_push(job_system *system, job_group *group, job_proc *proc, void *param) {
+    if (!atomic_load_i64(&system->started)) {
+        job_system_start(system);
+    }
+
+    atomic_add_i64(&group->pending, 1);
+
+    job *job = heap_alloc(sizeof(*job));
+    job->proc  = proc;
+    job->param = param;
+    job->group = group;
+    job->next  = null;
+
+    job_worker *self = job_current_worker(system);
+    if (self) {
+        if (!job_deque_push(&self->deque, job)) {
+            job_run(job); // NOTE(rune): Deque is full, so run the job inline instead.
+            return;
+        }
+    } else {
+        os_mutex_scope(system->mutex) {
+            if (system->injected_last) {
+                system->injected_last->next = job;
+            } else {
+                system->injected_first = job;
+            }
+            system->injected_last = job;
+            atomic_add_i64(&system->injected_count, 1);
+        }
+    }
+
+    atomic_add_i64(&system->epoch, 1);
+    atomic_fence();
+    if (atomic_load_i64(&system->sleeping) > 0) {
+        os_mutex_scope(system->mutex) {
+            os_cond_signal(system->cond);
+        }
+    }
+}
+
+// NOTE(rune): Runs other jobs while waiting, so a job can wait on a group of jobs it pushed itself.
+static void job_wait(job_system *system, job_group *group) {
+    job_worker *self = job_current_worker(system);
+    u64 rng = u64(group) | 1;
+
+    while (atomic_load_i64(&group->pending) > 0) {
+        job *job = job_next(system, self, self ? &self->rng : &rng);
+        if (job) {
+            job_run(job);
+        } else {
+            os_thread_sleep(0);
+        }
+    }
+}
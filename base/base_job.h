@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////
+// rune: Jobs
+
+// NOTE(rune): Work-stealing job system. Every worker thread owns a deque, pushes and pops at the bottom of it,
+// and steals from the top of other workers' deques when its own is empty. Jobs pushed from threads that are not
+// workers go to a shared injection list. Waiting on a group helps run jobs instead of blocking, so jobs may push
+// and wait on nested groups.
+
+typedef void job_proc(void *param);
+
+typedef struct job_group job_group;
+struct job_group {
+    volatile i64 pending;
+};
+
+typedef struct job job;
+struct job {
+    job_proc *proc;
+    void *param;
+    job_group *group;
+    job *next; // NOTE(rune): Only used in the injection list.
+};
+
+////////////////////////////////////////////////////////////////
+// rune: Deque
+
+#define JOB_DEQUE_CAPACITY 4096 // NOTE(rune): Must be a power of two.
+
+// NOTE(rune): Chase-Lev deque with a fixed capacity. Slots hold job pointers as i64, so they can be accessed with
+// the atomics from base_core.h. Padded so top and bottom don't share a cache line.
+typedef struct job_deque job_deque;
+struct job_deque {
+    volatile i64 top;
+    u8 pad0[56];
+    volatile i64 bottom;
+    u8 pad1[56];
+    volatile i64 slots[JOB_DEQUE_CAPACITY];
+};
+
+static bool job_deque_push(job_deque *deque, job *job);
+static job *job_deque_pop(job_deque *deque);
+static job *job_deque_steal(job_deque *deque);
+
+////////////////////////////////////////////////////////////////
+// rune: System
+
+typedef struct job_system job_system;
+
+typedef struct job_worker job_worker;
+struct job_worker {
+    job_system *system;
+    i64 index;
+    u64 rng;
+    os_handle thread;
+    job_deque deque;
+};
+
+struct job_system {
+    job_worker *workers;
+    i64 worker_count;
+    volatile i64 running;
+    volatile i64 started; // NOTE(rune): Worker threads are started by the first push, so unused systems are cheap.
+
+    // rune: Sleeping workers.
+    // NOTE(rune): Every push bumps epoch. A worker only sleeps if epoch didn't change since it last looked for
+    // work, and a push only takes the mutex to wake workers when some are sleeping.
+    volatile i64 epoch;
+    volatile i64 sleeping;
+
+    // rune: Injection list, protected by mutex.
+    os_handle mutex;
+    os_handle cond;
+    job *injected_first;
+    job *injected_last;
+    volatile i64 injected_count;
+};
+
+static job_system *job_system_create(i64 worker_count); // NOTE(rune): Zero means one worker per processor.
+static void        job_system_destroy(job_system *system);
+
+static void        job_push(job_system *system, job_group *group, job_proc *proc, void *param);
+static void        job_wait(job_system *system, job_group *group);
@@ -107,6 +107,20 @@ static void arena_destroy(arena *arena) {
     }
 }
 
+// NOTE(rune): Moves all blocks of other into arena, so they are freed together with arena. The blocks are linked
+// in after the current block, and the last of them becomes the current block, so memory allocated from other is
+// not reused until arena is rewound past it. Space left in the previous current block is not used again.
+static void arena_adopt(arena *arena, struct arena *other) {
+    struct arena *last = other;
+    while (last->next) {
+        last = last->next;
+    }
+
+    last->next = arena->curr->next;
+    arena->curr->next = other;
+    arena->curr = last;
+}
+
 static void arena_reset(arena *arena) {
     arena->curr = arena;
     arena->pos = sizeof(struct arena);
@@ -78,6 +78,7 @@ struct arena_scope {
 static arena *arena_create(i64 cap, arena_kind kind);
 static arena *arena_create_default(void);
 static void   arena_destroy(arena *arena);
+static void   arena_adopt(arena *arena, struct arena *other);
 
 // rune: Push
 static void *arena_push_size(arena *arena, i64 size, i64 align);
@@ -170,6 +170,12 @@ static void os_thread_sleep(i32 millis) {
     Sleep((DWORD)millis);
 }
 
+static i64 os_get_processor_count(void) {
+    SYSTEM_INFO info = { 0 };
+    GetSystemInfo(&info);
+    return i64(info.dwNumberOfProcessors);
+}
+
 ////////////////////////////////////////////////////////////////
 // rune: Mutexes
 
@@ -413,30 +419,178 @@ static void os_init(void) {
 static void os_deinit(void) {
 }
 
+////////////////////////////////////////////////////////////////
+// rune: Objects and handles
+
+static os_object *os_object_alloc(os_handle_kind kind) {
+    os_object *object = heap_alloc(sizeof(os_object));
+    if (object) {
+        memset(object, 0, sizeof(os_object));
+        object->kind = kind;
+    }
+    return object;
+}
+
+static void os_object_free(os_object *object) {
+    heap_free(object);
+}
+
+static os_handle os_handle_from_object(os_object *object) {
+    os_handle handle = { 0 };
+    if (object) {
+        handle.kind = object->kind;
+        handle.gen  = 1;
+        handle.data = object;
+    }
+    return handle;
+}
+
+static os_object *os_object_from_handle(os_handle handle) {
+    os_object *object = handle.data;
+    return object;
+}
+
 ////////////////////////////////////////////////////////////////
 // rune: Threads
 
-static os_handle os_thread_create(os_thread_proc *proc, void *param) { return (os_handle) { 0 }; } // TODO(rune): Implement with pthreads
-static void os_thread_destroy(os_handle thread) {} // TODO(rune): Implement with pthreads
-static void os_thread_join(os_handle thread) {} // TODO(rune): Implement with pthreads
-static void os_thread_sleep(i32 millis) {} // TODO(rune): Implement with pthreads
+static void *os_thread_start_routine(void *arg) {
+    os_object *object = arg;
+    object->proc(object->param);
+    return null;
+}
+
+static os_handle os_thread_create(os_thread_proc *proc, void *param) {
+    os_handle handle = { 0 };
+    os_object *object = os_object_alloc(OS_HANDLE_KIND_THREAD);
+    if (object) {
+        object->proc  = proc;
+        object->param = param;
+        if (pthread_create(&object->thread, null, os_thread_start_routine, object) == 0) {
+            handle = os_handle_from_object(object);
+        } else {
+            os_object_free(object);
+        }
+    }
+    return handle;
+}
+
+static void os_thread_destroy(os_handle thread) {
+    os_object *object = os_object_from_handle(thread);
+    if (object) {
+        pthread_detach(object->thread);
+        os_object_free(object);
+    }
+}
+
+static void os_thread_join(os_handle thread) {
+    os_object *object = os_object_from_handle(thread);
+    if (object) {
+        pthread_join(object->thread, null);
+        os_object_free(object);
+    }
+}
+
+static void os_thread_sleep(i32 millis) {
+    struct timespec t = { 0 };
+    t.tv_sec  = millis / 1000;
+    t.tv_nsec = (millis % 1000) * 1000000;
+    nanosleep(&t, null);
+}
+
+static i64 os_get_processor_count(void) {
+    i64 ret = i64(sysconf(_SC_NPROCESSORS_ONLN));
+    return max(ret, 1);
+}
 
 ////////////////////////////////////////////////////////////////
 // rune: Mutexes
 
-static os_handle os_mutex_create(void) { return (os_handle) { 0 }; } // TODO(rune): Implement with pthreads
-static void os_mutex_destroy(os_handle mutex) {} // TODO(rune): Implement with pthreads
-static void os_mutex_acquire(os_handle mutex) {} // TODO(rune): Implement with pthreads
-static void os_mutex_release(os_handle mutex) {} // TODO(rune): Implement with pthreads
+static os_handle os_mutex_create(void) {
+    os_handle mutex = { 0 };
+    os_object *object = os_object_alloc(OS_HANDLE_KIND_MUTEX);
+    if (object) {
+        pthread_mutex_init(&object->mutex, null);
+        mutex = os_handle_from_object(object);
+    }
+    return mutex;
+}
+
+static void os_mutex_destroy(os_handle mutex) {
+    os_object *object = os_object_from_handle(mutex);
+    if (object) {
+        pthread_mutex_destroy(&object->mutex);
+        os_object_free(object);
+    }
+}
+
+static void os_mutex_acquire(os_handle mutex) {
+    os_object *object = os_object_from_handle(mutex);
+    if (object) {
+        pthread_mutex_lock(&object->mutex);
+    }
+}
+
+static void os_mutex_release(os_handle mutex) {
+    os_object *object = os_object_from_handle(mutex);
+    if (object) {
+        pthread_mutex_unlock(&object->mutex);
+    }
+}
 
 ////////////////////////////////////////////////////////////////
 // rune: Condition variables
 
-static os_handle os_cond_create(void) { return (os_handle) { 0 }; } // TODO(rune): Implement with pthreads
-static void os_cond_destroy(os_handle cond) {} // TODO(rune): Implement with pthreads
-static void os_cond_wait(os_handle cond, os_handle mutex, u32 timeout_ms) {} // TODO(rune): Implement with pthreads
-static void os_cond_signal(os_handle cond) {} // TODO(rune): Implement with pthreads
-static void os_cond_signal_all(os_handle cond) {} // TODO(rune): Implement with pthreads
+static os_handle os_cond_create(void) {
+    os_handle cond = { 0 };
+    os_object *object = os_object_alloc(OS_HANDLE_KIND_COND);
+    if (object) {
+        pthread_cond_init(&object->cond, null);
+        cond = os_handle_from_object(object);
+    }
+    return cond;
+}
+
+static void os_cond_destroy(os_handle cond) {
+    os_object *object = os_object_from_handle(cond);
+    if (object) {
+        pthread_cond_destroy(&object->cond);
+        os_object_free(object);
+    }
+}
+
+// NOTE(rune): Same as SleepConditionVariableSRW, a timeout of U32_MAX waits forever.
+static void os_cond_wait(os_handle cond, os_handle mutex, u32 timeout_ms) {
+    if (timeout_ms > 0) {
+        os_object *cond_object = os_object_from_handle(cond);
+        os_object *mutex_object = os_object_from_handle(mutex);
+        if (cond_object && mutex_object) {
+            if (timeout_ms == U32_MAX) {
+                pthread_cond_wait(&cond_object->cond, &mutex_object->mutex);
+            } else {
+                struct timespec t = { 0 };
+                clock_gettime(CLOCK_REALTIME, &t);
+                u64 ns = u64(t.tv_nsec) + u64(timeout_ms) * 1000000;
+                t.tv_sec  += ns / 1000000000;
+                t.tv_nsec  = ns % 1000000000;
+                pthread_cond_timedwait(&cond_object->cond, &mutex_object->mutex, &t);
+            }
+        }
+    }
+}
+
+static void os_cond_signal(os_handle cond) {
+    os_object *object = os_object_from_handle(cond);
+    if (object) {
+        pthread_cond_signal(&object->cond);
+    }
+}
+
+static void os_cond_signal_all(os_handle cond) {
+    os_object *object = os_object_from_handle(cond);
+    if (object) {
+        pthread_cond_broadcast(&object->cond);
+    }
+}
 
 ////////////////////////////////////////////////////////////////
 // rune: Entire file
@@ -489,8 +643,8 @@ static os_file_info_list os_get_files_from_path(str path, i64 max, arena *arena)
 
 static u64 os_get_performance_timestamp(void) {
     struct timespec t = { 0 };
-    clock_gettime(CLOCK_REALTIME, &t);
-    return t.tv_nsec;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return u64(t.tv_sec) * 1000000000 + u64(t.tv_nsec);
 }
 
 static f64 os_get_millis_between(u64 t_begin, u64 t_end) {
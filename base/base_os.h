@@ -35,6 +35,7 @@ static os_handle os_thread_create(os_thread_proc *proc, void *param);
 static void      os_thread_destroy(os_handle thread);
 static void      os_thread_join(os_handle thread);
 static void      os_thread_sleep(i32 millis);
+static i64       os_get_processor_count(void);
 
 ////////////////////////////////////////////////////////////////
 // rune: Mutexes
@@ -146,6 +147,35 @@ static os_object *os_object_from_handle(os_handle handle);
 
 static DWORD os_thread_start_address(void *lpParameter);
 
+#else
+
+////////////////////////////////////////////////////////////////
+// rune: Objects
+
+// NOTE(rune): Heap allocated, and freed when the handle is destroyed. Generations are not checked, so handles
+// must not be used after they are destroyed.
+typedef struct os_object os_object;
+struct os_object {
+    os_handle_kind kind;
+
+    void *param;
+    os_thread_proc *proc;
+    pthread_t thread;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+static os_object *os_object_alloc(os_handle_kind kind);
+static void       os_object_free(os_object *object);
+static os_handle  os_handle_from_object(os_object *object);
+static os_object *os_object_from_handle(os_handle handle);
+
+////////////////////////////////////////////////////////////////
+// rune: Threads
+
+static void *os_thread_start_routine(void *arg);
+
 #endif
 
 
@@ -7,6 +7,7 @@ static void test_ctx_begin(test_ctx *ctx) {
     ctx->failed_count = 0;
     ctx->passed_count = 0;
     ctx->duration_total = 0.0;
+    ctx->duration_wall = 0.0;
     ctx->arena = arena_create(kilobytes(64), ARENA_KIND_LINEAR);
 }
 
@@ -29,6 +30,9 @@ static void test_ctx_end(test_ctx *ctx) {
     // rune: Duration
     print(ANSI_FG_GRAY);
     print("% ms", ctx->duration_total);
+    if (ctx->duration_wall > 0.0) {
+        print(" (% ms wall)", ctx->duration_wall);
+    }
 
     // rune: Seperator
     print("\n");
@@ -46,6 +50,12 @@ static arena *test_arena(void) {
     return ctx->arena;
 }
 
+static void test_set_duration(f64 millis) {
+    test_ctx *ctx = test_g_ctx;
+    ctx->curr_test.has_duration = true;
+    ctx->curr_test.duration     = millis;
+}
+
 ////////////////////////////////////////////////////////////////
 // rune: Test scope
 
@@ -65,6 +75,7 @@ static void test_scope_begin(str loc, args name_args) {
     ctx->curr_test.failed_assertions.first = null;
     ctx->curr_test.failed_assertions.last  = null;
     ctx->curr_test.in_progress             = true;
+    ctx->curr_test.has_duration            = false;
     ctx->curr_test.loc                     = loc;
     ctx->curr_test.name                    = arena_print_args(ctx->arena, name_args);
     ctx->curr_test.timestamp_begin         = os_get_performance_timestamp();
@@ -77,6 +88,9 @@ static void test_scope_end(void) {
     ctx->curr_test.in_progress   = false;
     ctx->curr_test.timestamp_end = os_get_performance_timestamp();
     f64 elapsed_millis           = os_get_millis_between(ctx->curr_test.timestamp_begin, ctx->curr_test.timestamp_end);
+    if (ctx->curr_test.has_duration) {
+        elapsed_millis = ctx->curr_test.duration;
+    }
     ctx->duration_total         += elapsed_millis;
 
     // rune: Run user defined teardown.
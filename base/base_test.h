@@ -31,6 +31,7 @@ struct test_ctx {
     i64 passed_count;
     i64 failed_count;
     f64 duration_total;
+    f64 duration_wall; // NOTE(rune): Only set by runners, which run tests in parallel.
 
     // rune: Per-test data.
     struct {
@@ -39,6 +40,8 @@ struct test_ctx {
         u64 timestamp_begin;
         u64 timestamp_end;
         bool in_progress;
+        bool has_duration;
+        f64 duration;
         test_assertion_list failed_assertions;
     } curr_test;
 };
@@ -62,6 +65,10 @@ static void test_scope_end(void);
 // NOTE(rune): Allocations within a test_scope are only valid until the end of the test_scope.
 static arena *test_arena(void);
 
+// NOTE(rune): For tests which ran on another thread, and are only reported in the test_scope. Overrides the
+// duration measured by the test_scope.
+static void test_set_duration(f64 millis);
+
 ////////////////////////////////////////////////////////////////
 // rune: Assertions
 
@@ -1,2 +1,2 @@
 mkdir -p build
-cc main.c -o build/dansk -lm
+cc main.c -o build/dansk -lm -pthread
@@ -1,9 +1,8 @@
 ////////////////////////////////////////////////////////////////
 // rune: Errors
 
-#define dk_tprint(...) dk_tprint_args(argsof(__VA_ARGS__))
-static str dk_tprint_args(args args) {
-    str ret = arena_print_args(temp_arena, args);
+static str dk_tprint_args(dk_ctx *ctx, args args) {
+    str ret = arena_print_args(ctx->arena, args);
     return ret;
 }
 
@@ -14,8 +13,8 @@ static dk_err *dk_err_list_add(dk_err_list *list, arena *arena) {
     return node;
 }
 
-static void dk_report_err(dk_err_sink *sink, dk_loc loc, str msg) {
-    dk_err *node = dk_err_list_add(&sink->err_list, temp_arena);
+static void dk_report_err(dk_ctx *ctx, dk_loc loc, str msg) {
+    dk_err *node = dk_err_list_add(&ctx->err->err_list, ctx->arena);
     node->msg = msg;
     node->loc = loc;
 }
@@ -90,7 +89,43 @@ static void dk_print_err(dk_err *err, arena *arena) {
     println(ret);
 }
 
-static dk_err_sink *dk_global_err = null; // TODO(rune): Remove global.
+////////////////////////////////////////////////////////////////
+// rune: Parallel compilation
+
+// NOTE(rune): Runs proc once for each of the count params, which are param_size bytes apart. Without a job system,
+// or with a single job, they run directly on the calling thread.
+static void dk_run_jobs(job_system *jobs, job_proc *proc, void *params, i64 param_size, i64 count) {
+    if (jobs == null || count == 1) {
+        for_n (i64, i, count) {
+            proc((u8 *)params + i * param_size);
+        }
+    } else if (count > 1) {
+        job_group group = { 0 };
+        for_n (i64, i, count) {
+            job_push(jobs, &group, proc, (u8 *)params + i * param_size);
+        }
+        job_wait(jobs, &group);
+    }
+}
+
+// NOTE(rune): Only user functions have bodies, so builtins are left out, and don't count towards the number of jobs.
+static dk_func **dk_user_func_array_from_list(dk_func_list funcs, i64 *count, arena *arena) {
+    *count = 0;
+    for_list (dk_func, func, funcs) {
+        if (func->kind == DK_FUNC_KIND_USER) {
+            *count += 1;
+        }
+    }
+
+    dk_func **ret = arena_push_array(arena, dk_func *, *count);
+    i64 i = 0;
+    for_list (dk_func, func, funcs) {
+        if (func->kind == DK_FUNC_KIND_USER) {
+            ret[i++] = func;
+        }
+    }
+    return ret;
+}
 
 ////////////////////////////////////////////////////////////////
 // rune: Number spelling
@@ -178,6 +213,7 @@ static i64 dk_number_from_str(str s) {
 static dk_literal dk_make_literal_int(i64 v) { return (dk_literal) { .kind = DK_LITERAL_KIND_INT, .int_ = v }; }
 static dk_literal dk_make_literal_float(f64 v) { return (dk_literal) { .kind = DK_LITERAL_KIND_FLOAT, .float_ = v }; }
 static dk_literal dk_make_literal_bool(bool v) { return (dk_literal) { .kind = DK_LITERAL_KIND_BOOL, .bool_ = v }; }
+static dk_literal dk_make_literal_text(str v) { return (dk_literal) { .kind = DK_LITERAL_KIND_TEXT, .text_ = v }; }
 
 static void dk_tokenizer_eat(dk_tokenizer *t) {
     t->loc.pos += 1;
@@ -192,8 +228,9 @@ static void dk_tokenizer_eat(dk_tokenizer *t) {
     t->peek1 = (t->loc.pos + 1 < t->src.len) ? (t->src.v[t->loc.pos + 1]) : ('\0');
 }
 
-static void dk_tokenizer_init(dk_tokenizer *t, str src, i64 pos) {
+static void dk_tokenizer_init(dk_tokenizer *t, str src, i64 pos, dk_ctx *ctx) {
     t->src     = src;
+    t->ctx     = ctx;
     t->loc.pos = pos - 1;
     dk_tokenizer_eat(t);
 }
@@ -223,8 +260,24 @@ static bool dk_next_token(dk_tokenizer *t, dk_token *token) {
     dk_token_kind kind = 0;
     dk_loc begin_loc = t->loc;
 
+    // rune: Text literal token
+    if (t->peek0 == '"') {
+        dk_tokenizer_eat(t);
+        while (t->peek0 != '"' && t->loc.pos < t->src.len) {
+            dk_tokenizer_eat(t);
+        }
+
+        if (t->peek0 == '"') {
+            kind = DK_TOKEN_KIND_LITERAL;
+            token->literal = dk_make_literal_text(substr_len(t->src, begin_loc.pos + 1, t->loc.pos - begin_loc.pos - 1));
+            dk_tokenizer_eat(t);
+        } else {
+            dk_report_err(t->ctx, begin_loc, str("Unterminated text literal."));
+        }
+    }
+
     // rune: Punctuation token
-    if (u8_is_punct(t->peek0)) {
+    else if (u8_is_punct(t->peek0)) {
         u8 c = t->peek0;
         dk_tokenizer_eat(t);
 
@@ -237,7 +290,7 @@ static bool dk_next_token(dk_tokenizer *t, dk_token *token) {
 
         str s = substr_len(t->src, begin_loc.pos, t->loc.pos - begin_loc.pos);
         if (kind == 0) {
-            dk_report_err(dk_global_err, t->loc, dk_tprint("Invalid operator"));
+            dk_report_err(t->ctx, t->loc, dk_tprint(t->ctx, "Invalid operator"));
         }
     }
 
@@ -333,19 +386,17 @@ static bool dk_next_token(dk_tokenizer *t, dk_token *token) {
                 kind = DK_TOKEN_KIND_LITERAL;
                 token->literal = dk_make_literal_float(value);
             } else {
-                dk_report_err(dk_global_err, t->loc, str("Invalid floating point literal.")); // TODO(rune): Better error message.
+                dk_report_err(t->ctx, t->loc, str("Invalid floating point literal.")); // TODO(rune): Better error message.
             }
         } else {
             // rune: Parse integer.
-            // TODO(rune): Check for overflow
-            kind = DK_TOKEN_KIND_LITERAL;
             i64 value = 0;
-            for_n (i64, i, s.len) {
-                u8 c = s.v[i];
-                value *= 10;
-                value += c - '0';
+            if (dk_parse_int(s, &value)) {
+                kind = DK_TOKEN_KIND_LITERAL;
+                token->literal = dk_make_literal_int(value);
+            } else {
+                dk_report_err(t->ctx, t->loc, str("Integer literal is too large."));
             }
-            token->literal = dk_make_literal_int(value);
         }
     }
 
@@ -356,12 +407,13 @@ static bool dk_next_token(dk_tokenizer *t, dk_token *token) {
     return kind != 0;
 }
 
-static dk_token_list dk_token_list_from_str(str s, arena *arena) {
+static dk_token_list dk_token_list_from_str(str s, dk_ctx *ctx) {
     dk_token_list list = { 0 };
     dk_token token = { 0 };
+    arena *arena = ctx->arena;
 
     dk_tokenizer tokenizer = { 0 };
-    dk_tokenizer_init(&tokenizer, s, 0);
+    dk_tokenizer_init(&tokenizer, s, 0, ctx);
     while (dk_next_token(&tokenizer, &token)) {
         dk_token *node = arena_push_struct(arena, dk_token);
         *node = token;
@@ -407,8 +459,9 @@ static dk_pattern_part *dk_pattern_push_type(dk_pattern *p, arena *arena, str na
 // rune: Parser
 
 // rune: Initialization
-static void dk_parser_init(dk_parser *p, dk_token_list tokens, arena *arena) {
-    p->arena = arena;
+static void dk_parser_init(dk_parser *p, dk_token_list tokens, dk_ctx *ctx) {
+    p->arena = ctx->arena;
+    p->ctx   = ctx;
     p->peek = tokens.first;
     if (p->peek && p->peek->kind == DK_TOKEN_KIND_COMMENT) {
         dk_eat_token(p);
@@ -452,7 +505,7 @@ static dk_token *dk_eat_token(dk_parser *p) {
 static dk_token *dk_eat_token_kind(dk_parser *p, dk_token_kind kind) {
     dk_token *eaten = dk_eat_token(p);
     if (eaten->kind != kind) {
-        dk_report_err(dk_global_err, eaten->loc, dk_tprint(
+        dk_report_err(p->ctx, eaten->loc, dk_tprint(p->ctx,
             "Unexpected token\n"
             "    Wanted: %\n"
             "    Given:  %\n",
@@ -471,7 +524,7 @@ static dk_token *dk_eat_token_text(dk_parser *p, str text) {
             given = dk_str_from_token_kind(eaten->kind);
         }
 
-        dk_report_err(dk_global_err, eaten->loc, dk_tprint(
+        dk_report_err(p->ctx, eaten->loc, dk_tprint(p->ctx,
             "Unexpected token\n"
             "    Wanted: %\n"
             "    Given:  %\n",
@@ -502,12 +555,21 @@ static bool dk_eat_token_text_maybe(dk_parser *p, str text) {
 // rune: Parsing
 
 static dk_clause *dk_parse_clause(dk_parser *p) {
+    return dk_parse_clause_until(p, str(""));
+}
+
+// NOTE(rune): Stops before the word stop, e.g. the "til" of "Samtidig for hver I fra 1 til N."
+static dk_clause *dk_parse_clause_until(dk_parser *p, str stop) {
     dk_clause *clause = arena_push_struct(p->arena, dk_clause);
     clause->token = p->peek;
     while (p->peek->kind != 0) {
         dk_clause_part *part = null;
         switch (p->peek->kind) {
             case DK_TOKEN_KIND_WORD: {
+                if (stop.len > 0 && str_eq_nocase(p->peek->text, stop)) {
+                    break;
+                }
+
                 part       = arena_push_struct(p->arena, dk_clause_part);
                 part->kind = DK_CLAUSE_PART_KIND_WORD;
                 part->word = dk_eat_token(p)->text;
@@ -562,6 +624,7 @@ static dk_clause_list dk_parse_clause_list(dk_parser *p) {
 
 static dk_stmt *dk_parse_stmt(dk_parser *p) {
     dk_stmt *stmt = arena_push_struct(p->arena, dk_stmt);
+    stmt->token = p->peek;
 
     // rune: Declaration statement
     if (dk_peek_token_text(p, str("lad"))) {
@@ -570,12 +633,44 @@ static dk_stmt *dk_parse_stmt(dk_parser *p) {
         dk_eat_token_text(p, str("være"));
         dk_eat_token_text_maybe(p, str("en"));
         dk_eat_token_text_maybe(p, str("et"));
-        dk_token *type_token = dk_eat_token_kind(p, DK_TOKEN_KIND_WORD);
-        dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
 
-        stmt->kind      = DK_STMT_KIND_DECL;
-        stmt->name      = name_token->text;
-        stmt->type_name = type_token->text;
+        // rune: Constant declaration e.g. "Lad N være konstant 1000."
+        if (dk_eat_token_text_maybe(p, str("konstant"))) {
+            dk_token *value_token = dk_eat_token_kind(p, DK_TOKEN_KIND_LITERAL);
+            dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+
+            stmt->kind    = DK_STMT_KIND_CONST;
+            stmt->name    = name_token->text;
+            stmt->literal = value_token->literal;
+        } else {
+            // rune: List declaration e.g. "Lad L være en liste af 10 heltal." or "Lad L være en søjlevis liste af 10 Punkt."
+            // The length can also be a constant e.g. "Lad L være en liste af N heltal."
+            stmt->list_soa = dk_eat_token_text_maybe(p, str("søjlevis"));
+            if (stmt->list_soa) {
+                dk_eat_token_text(p, str("liste"));
+            }
+
+            if (stmt->list_soa || dk_eat_token_text_maybe(p, str("liste"))) {
+                dk_eat_token_text(p, str("af"));
+                if (p->peek->kind == DK_TOKEN_KIND_WORD) {
+                    stmt->list_count_name = dk_eat_token_kind(p, DK_TOKEN_KIND_WORD)->text;
+                } else {
+                    dk_token *count_token = dk_eat_token_kind(p, DK_TOKEN_KIND_LITERAL);
+                    if (count_token->kind == DK_TOKEN_KIND_LITERAL &&
+                        (count_token->literal.kind != DK_LITERAL_KIND_INT || count_token->literal.int_ <= 0)) {
+                        dk_report_err(p->ctx, count_token->loc, str("List length must be a positive integer."));
+                    }
+                    stmt->list_count = count_token->literal.int_;
+                }
+            }
+
+            dk_token *type_token = dk_eat_token_kind(p, DK_TOKEN_KIND_WORD);
+            dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+
+            stmt->kind      = DK_STMT_KIND_DECL;
+            stmt->name      = name_token->text;
+            stmt->type_name = type_token->text;
+        }
     }
 
     // rune: If statement
@@ -605,6 +700,63 @@ static dk_stmt *dk_parse_stmt(dk_parser *p) {
         stmt->then = dk_parse_stmt_list(p);
     }
 
+    // rune: Samtidig loop e.g. "Samtidig for hver I fra 1 til N."
+    else if (dk_peek_token_text(p, str("samtidig"))) {
+        dk_eat_token(p);
+        dk_eat_token_text(p, str("for"));
+        dk_eat_token_text(p, str("hver"));
+        dk_token *name_token = dk_eat_token_kind(p, DK_TOKEN_KIND_WORD);
+        dk_eat_token_text(p, str("fra"));
+
+        dk_clause *first = dk_parse_clause_until(p, str("til"));
+        dk_eat_token_text(p, str("til"));
+
+        stmt->kind = DK_STMT_KIND_PFOR;
+        stmt->name = name_token->text;
+        slist_push(&stmt->clauses, first);
+        stmt->end_clauses = dk_parse_clause_list(p);
+
+        dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+        stmt->then = dk_parse_stmt_list(p);
+    }
+
+    // rune: Switch statement
+    else if (dk_peek_token_text(p, str("vælg"))) {
+        dk_eat_token(p);
+        stmt->kind = DK_STMT_KIND_SWITCH;
+        stmt->clauses = dk_parse_clause_list(p);
+        dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+
+        dk_eat_token_text(p, str("goddag"));
+        dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+        bool has_else = false;
+        while (p->peek->kind != 0) {
+            if (dk_peek_token_text(p, str("tilfælde"))) {
+                dk_eat_token(p);
+                dk_stmt *case_ = arena_push_struct(p->arena, dk_stmt);
+                case_->kind    = DK_STMT_KIND_CASE;
+                case_->clauses = dk_parse_clause_list(p);
+                dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+                case_->then    = dk_parse_stmt_list(p);
+
+                slist_push(&stmt->then, case_);
+            } else if (dk_peek_token_text(p, str("ellers"))) {
+                dk_token *else_token = dk_eat_token(p);
+                if (has_else) {
+                    dk_report_err(p->ctx, else_token->loc, str("Duplicate Ellers."));
+                }
+                has_else = true;
+
+                dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+                stmt->else_ = dk_parse_stmt_list(p);
+            } else {
+                break;
+            }
+        }
+        dk_eat_token_text(p, str("farvel"));
+        dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+    }
+
     // rune: Return statement
     else if (dk_peek_token_text(p, str("tilbagegiv"))) {
         dk_eat_token(p);
@@ -696,7 +848,8 @@ static dk_stmt_list dk_parse_stmt_list(dk_parser *p) {
 
 static dk_func *dk_parse_func(dk_parser *p) {
     dk_func *func = arena_push_struct(p->arena, dk_func);
-    func->kind = DK_FUNC_KIND_USER;
+    func->kind  = DK_FUNC_KIND_USER;
+    func->token = p->peek;
 
     static readonly str return_spelling = STR("tilbagegiver");
 
@@ -736,10 +889,46 @@ static dk_func *dk_parse_func(dk_parser *p) {
     return func;
 }
 
+static dk_type *dk_parse_type(dk_parser *p) {
+    dk_type *type = arena_push_struct(p->arena, dk_type);
+    type->kind = DK_TYPE_KIND_RECORD;
+
+    dk_token *name_token = dk_eat_token_kind(p, DK_TOKEN_KIND_WORD);
+    dk_eat_token_kind(p, DK_TOKEN_KIND_DOT);
+    type->name = name_token->text;
+    type->loc  = name_token->loc;
+
+    // rune: Fields e.g. "Lad X være et heltal."
+    dk_stmt_list stmts = dk_parse_stmt_list(p);
+    for_list (dk_stmt, stmt, stmts) {
+        if (stmt->kind != DK_STMT_KIND_DECL) {
+            dk_report_err(p->ctx, stmt->token->loc, str("Only field declarations are allowed in a type."));
+        } else if (stmt->list_count > 0 || stmt->list_count_name.len > 0) {
+            dk_report_err(p->ctx, stmt->token->loc, str("Fields can't be lists."));
+        } else {
+            dk_field *field = arena_push_struct(p->arena, dk_field);
+            field->name      = stmt->name;
+            field->type_name = stmt->type_name;
+            field->loc       = stmt->token->loc;
+            slist_push(&type->fields, field);
+            type->fields.count++;
+        }
+    }
+
+    return type;
+}
+
 static dk_tree *dk_parse_tree(dk_parser *p) {
     dk_tree *tree = arena_push_struct(p->arena, dk_tree);
 
-    while (p->peek->kind != 0 && dk_global_err->err_list.count == 0) {
+    while (p->peek->kind != 0 && p->ctx->err->err_list.count == 0) {
+        // rune: Global declaration e.g. "Lad G være et heltal."
+        if (dk_peek_token_text(p, str("lad"))) {
+            dk_stmt *stmt = dk_parse_stmt(p);
+            slist_push(&tree->globals, stmt);
+            continue;
+        }
+
         // rune: Visibilty
         dk_eat_token_text(p, str("offentlig")); // TODO(rune): Parse visibilty properly.
 
@@ -750,7 +939,10 @@ static dk_tree *dk_parse_tree(dk_parser *p) {
         }
 
         // rune: Type declaration
-        // TODO(rune): Type declaration
+        else if (dk_eat_token_text_maybe(p, str("type"))) {
+            dk_type *type = dk_parse_type(p);
+            slist_push(&tree->types, type);
+        }
     }
 
 #if DK_DEBUG_PRINT_PARSE
@@ -810,34 +1002,63 @@ static dk_local *dk_resolve_local(dk_checker *c, str name) {
     return ret;
 }
 
+static dk_constant *dk_resolve_constant(dk_checker *c, str name) {
+    dk_constant *ret = null;
+    for (dk_constant *it = c->constants; it; it = it->next) {
+        if (str_eq_nocase(it->name, name)) {
+            ret = it;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+static dk_local *dk_resolve_global(dk_checker *c, str name) {
+    dk_local *ret = null;
+    for_list (dk_local, global, c->globals) {
+        if (str_eq_nocase(global->name, name)) {
+            ret = global;
+            break;
+        }
+    }
+
+    return ret;
+}
+
 static dk_func *dk_resolve_func(dk_checker *c, dk_pattern want_pattern, dk_loc loc) {
+    // NOTE(rune): The first pass requires exact argument types. The second pass also lets integer arguments
+    // match integer parameters of another width, e.g. a byte passed to "læg A:heltal sammen med B:heltal".
     dk_func *ret = null;
-    for_list (dk_func, func, c->tree->funcs) {
-        if (func->pattern.parts.count == want_pattern.parts.count) {
-            dk_pattern_part *want = want_pattern.parts.first;
-            dk_pattern_part *cand = func->pattern.parts.first;
-
-            bool match = true;
-            for_n (i64, i, want_pattern.parts.count) {
-                if (want->type) {
-                    if (cand->type != c->builtin_any) {
-                        match &= str_eq_nocase(want->type->name, cand->type_name);
+    for (i64 pass = 0; pass < 2 && ret == null; pass++) {
+        for_list (dk_func, func, c->tree->funcs) {
+            if (func->pattern.parts.count == want_pattern.parts.count) {
+                dk_pattern_part *want = want_pattern.parts.first;
+                dk_pattern_part *cand = func->pattern.parts.first;
+
+                bool match = true;
+                for_n (i64, i, want_pattern.parts.count) {
+                    if (want->type) {
+                        if (cand->type != c->builtin_any) {
+                            match &= str_eq_nocase(want->type->name, cand->type_name) ||
+                                     (pass == 1 && cand->type && dk_types_compatible(cand->type, want->type));
+                        }
+                    } else {
+                        match &= str_eq_nocase(want->name, cand->name);
                     }
-                } else {
-                    match &= str_eq_nocase(want->name, cand->name);
+
+                    if (match == false) {
+                        break;
+                    }
+
+                    want = want->next;
+                    cand = cand->next;
                 }
 
-                if (match == false) {
+                if (match) {
+                    ret = func;
                     break;
                 }
-
-                want = want->next;
-                cand = cand->next;
-            }
-
-            if (match) {
-                ret = func;
-                break;
             }
         }
     }
@@ -845,13 +1066,13 @@ static dk_func *dk_resolve_func(dk_checker *c, dk_pattern want_pattern, dk_loc l
     if (ret == null) {
 
         // TODO(rune): Better error reporting.
-        str msg =  dk_tprint(
+        str msg = dk_tprint(c->ctx,
             "Unresolved function\n"
             "   Pattern: %\n",
-            dk_str_from_pattern(want_pattern, temp_arena)
+            dk_str_from_pattern(want_pattern, c->arena)
         );
 
-        dk_report_err(dk_global_err, loc, msg);
+        dk_report_err(c->ctx, loc, msg);
 
         static readonly dk_type dk_null_type = { 0 };
         static readonly dk_func dk_null_func = { .type = &dk_null_type };
@@ -861,184 +1082,1407 @@ static dk_func *dk_resolve_func(dk_checker *c, dk_pattern want_pattern, dk_loc l
     return ret;
 }
 
+static i64 dk_slot_count_from_type(dk_type *type) {
+    return (type->size + 7) / 8;
+}
+
+static bool dk_type_is_int(dk_type *type) {
+    return (type->flags & DK_TYPE_FLAG_INTEGER) != 0;
+}
+
+// NOTE(rune): Largest value of an integer type. Values of narrow types wrap around above it.
+static i64 dk_int_type_max(dk_type *type) {
+    i64 bits = type->size * 8 - ((type->flags & DK_TYPE_FLAG_SIGNED) ? 1 : 0);
+    return bits >= 63 ? I64_MAX : (i64(1) << bits) - 1;
+}
+
+static i64 dk_int_type_min(dk_type *type) {
+    return (type->flags & DK_TYPE_FLAG_SIGNED) ? -dk_int_type_max(type) - 1 : 0;
+}
+
+// NOTE(rune): Packed values are smaller than a slot, and are stored tightly in lists and records.
+static bool dk_type_is_packed(dk_type *type) {
+    return type->kind == DK_TYPE_KIND_BASIC && type->size < 8;
+}
+
+static bool dk_types_compatible(dk_type *want, dk_type *given) {
+    return want == given || (dk_type_is_int(want) && dk_type_is_int(given));
+}
+
 static dk_local *dk_push_local(dk_checker *c, str name, dk_type *type) {
     // TODO(rune): Check for duplicate symbol name.
 
     dk_local *local = arena_push_struct(c->arena, dk_local);
     local->name = name;
     local->type = type;
-    local->off  = c->locals.count;
+    local->off  = c->frame_size;
 
     slist_push(&c->locals, local);
     c->locals.count++;
+    c->frame_size += dk_slot_count_from_type(type); // TODO(rune): Properly sized locals (no more *8)
 
     return local;
 }
 
-static dk_expr *dk_check_clause(dk_checker *c, dk_clause *clause) {
-    // rune: Check arguments
-    dk_pattern want_pattern = { 0 };
-    dk_expr_list args = { 0 };
-    for_list (dk_clause_part, part, clause->parts) {
-        dk_expr *arg = null;
-        switch (part->kind) {
-            case DK_CLAUSE_PART_KIND_WORD: {
-                dk_local *local = dk_resolve_local(c, part->word);
-                if (local) {
-                    arg = arena_push_struct(c->arena, dk_expr);
-                    arg->kind = DK_EXPR_KIND_LOCAL;
-                    arg->local = local;
-                    arg->type = local->type;
-                }
-            } break;
-
-            case DK_CLAUSE_PART_KIND_LIST: {
-                arg = dk_check_clause_list(c, part->list);
-            } break;
-
-            case DK_CLAUSE_PART_KIND_LITERAL: {
-                arg = arena_push_struct(c->arena, dk_expr);
-                arg->kind = DK_EXPR_KIND_LITERAL;
-                arg->literal = part->literal;
-
-                switch (part->literal.kind) {
-                    case DK_LITERAL_KIND_INT:   arg->type = c->builtin_int;     break;
-                    case DK_LITERAL_KIND_FLOAT: arg->type = c->builtin_float;   break;
-                    case DK_LITERAL_KIND_BOOL:  arg->type = c->builtin_bool;    break;
-                    default:                    assert(false && "Invalid literal kind.");
-                }
-            } break;
+////////////////////////////////////////////////////////////////
+// rune: Lists
+
+static dk_type *dk_make_list_type(dk_checker *c, dk_type *elem, i64 count, bool soa) {
+    // NOTE(rune): List types are not added to the tree's type list, since they can't be named in patterns.
+    // They are only ever matched by $any pattern parts, and identified by pointer.
+    dk_type *type = arena_push_struct(c->arena, dk_type);
+    type->name  = arena_print(c->arena, "%liste af % %", soa ? "søjlevis " : "", count, elem->name);
+    type->size  = 8 + align_to_pow2(count * elem->size, 8);
+    type->kind  = DK_TYPE_KIND_LIST;
+    type->flags = soa ? DK_TYPE_FLAG_SOA : 0;
+    type->elem  = elem;
+    type->count = count;
+    return type;
+}
 
-            default: {
-                assert(false && "Invalid clause part kind.");
-            } break;
-        }
+static dk_expr *dk_unwrap_list_expr(dk_expr *expr) {
+    while (expr->kind == DK_EXPR_KIND_LIST) {
+        expr = expr->list.last;
+    }
+    return expr;
+}
 
-        if (arg) {
-            assert(arg->type != null);
-            slist_push(&args, arg);
+// NOTE(rune): Is the value assigned to local non-negative, given that the local itself is non-negative.
+static bool dk_is_nonneg_assign(dk_checker *c, dk_local *local, dk_expr *rvalue) {
+    rvalue = dk_unwrap_list_expr(rvalue);
 
-            // TODO(rune): Cleanup
-            dk_pattern_part *arg_part = dk_pattern_push_part(&want_pattern, c->arena);
-            arg_part->type = arg->type;
-        } else {
-            assert(part->kind == DK_CLAUSE_PART_KIND_WORD);
-            dk_pattern_push_word(&want_pattern, c->arena, part->word);
-        }
+    if (!dk_type_is_int(local->type)) {
+        return false;
     }
 
-    dk_expr *expr = null;
-    if ((clause->parts.first == clause->parts.last) &&
-        (args.first == args.last) &&
-        (args.first != null)) {
-        expr = args.first;
-    } else {
-        dk_func *func = dk_resolve_func(c, want_pattern, clause->token->loc);
-        if (func->kind == DK_FUNC_KIND_ASSIGN) {
-            // rune: Assignment e.g. "Gem det i A"
-            expr = arena_push_struct(c->arena, dk_expr);
-            expr->kind = DK_EXPR_KIND_ASSIGN;
-            expr->type = c->builtin_int; // TODO(rune): Void type
-            expr->func_args = args;
-
-            // TODO(rune): Check valid lvalue
+    // NOTE(rune): A literal which doesn't fit wraps around, e.g. 200 is -56 as a småtal.
+    i64 type_max = dk_int_type_max(local->type);
+    bool ret = false;
+    if (rvalue->kind == DK_EXPR_KIND_LITERAL) {
+        ret = rvalue->literal.kind == DK_LITERAL_KIND_INT && rvalue->literal.int_ >= 0 && rvalue->literal.int_ <= type_max;
+    }
 
-            dk_expr *rvalue = args.first;
-            dk_expr *lvalue = args.last;
-            if (lvalue->type != rvalue->type) {
-                dk_report_err(dk_global_err, clause->token->loc, dk_tprint(
-                    "Type mismtach\n"
-                    "    Wanted: %\n"
-                    "    Given:  %\n",
-                    lvalue->type->name,
-                    rvalue->type->name)
-                );
+    // rune: Increment e.g. "Læg I sammen med 1, og gem det i I."
+    if (rvalue->kind == DK_EXPR_KIND_FUNC &&
+        rvalue->func->kind == DK_FUNC_KIND_OPCODE &&
+        rvalue->func->opcode == DK_BC_OPCODE_ADD) {
+        dk_expr *a = rvalue->func_args.first;
+        dk_expr *b = rvalue->func_args.last;
+        if (a->kind == DK_EXPR_KIND_LITERAL) swap(dk_expr *, &a, &b);
+        if ((a->kind == DK_EXPR_KIND_LOCAL && a->local == local) &&
+            (b->kind == DK_EXPR_KIND_LITERAL && b->literal.kind == DK_LITERAL_KIND_INT &&
+             b->literal.int_ >= 0 && b->literal.int_ <= type_max)) {
+            // NOTE(rune): Checked heltal additions trap instead of wrapping around.
+            ret = !(c->flags & DK_BUILD_FLAG_UNCHECKED) && local->type->size == 8;
+
+            // NOTE(rune): Otherwise the sum must stay in range of the type, which a live range fact "I < N" proves,
+            // when N - 1 + the increment is at most the largest value of the type.
+            for (dk_range_fact *fact = c->range_facts; fact && !ret; fact = fact->next) {
+                if (fact->local == local && !fact->killed) {
+                    ret = fact->max <= 0 || fact->max - 1 <= type_max - b->literal.int_;
+                }
             }
-
-        } else {
-            // rune: Normal function call
-            expr = arena_push_struct(c->arena, dk_expr);
-            expr->kind = DK_EXPR_KIND_FUNC;
-            expr->func = func;
-            expr->type = func->type;
-            expr->func_args = args;
         }
     }
 
-
-    assert(expr->type);
-    return expr;
+    return ret;
 }
 
-static dk_expr *dk_check_clause_list(dk_checker *c, dk_clause_list clauses) {
-    dk_expr *expr = null;
+static void dk_note_assign(dk_checker *c, dk_local *local, dk_expr *rvalue) {
+    if (!dk_is_nonneg_assign(c, local, rvalue)) {
+        local->flags |= DK_LOCAL_FLAG_MAYBE_NEGATIVE;
+    }
 
-    if (clauses.first == clauses.last) {
-        expr = dk_check_clause(c, clauses.first);
-    } else {
-        expr = arena_push_struct(c->arena, dk_expr);
-        expr->kind = DK_EXPR_KIND_LIST;
-        for_list (dk_clause, subclause, clauses) {
-            dk_expr *subexpr = dk_check_clause(c, subclause);
-            slist_push(&expr->list, subexpr);
+    for (dk_range_fact *fact = c->range_facts; fact; fact = fact->next) {
+        if (fact->local == local) {
+            fact->killed = true;
         }
-        expr->type = expr->list.last->type;
     }
-
-    assert(expr->type);
-    return expr;
 }
 
-static void dk_check_stmt(dk_checker *c, dk_stmt *stmt) {
-    switch (stmt->kind) {
-        case DK_STMT_KIND_DECL: {
-            dk_type *type = dk_resolve_type(c, stmt->type_name);
-            dk_push_local(c, stmt->name, type);
-        } break;
-
-        case DK_STMT_KIND_EXPR:
-        case DK_STMT_KIND_IF:
-        case DK_STMT_KIND_WHILE:
-        case DK_STMT_KIND_RETURN: {
-            stmt->expr = dk_check_clause_list(c, stmt->clauses);;
-            dk_check_stmt_list(c, stmt->then);
-            dk_check_stmt_list(c, stmt->else_);
-        } break;
+// NOTE(rune): Conservative syntactic check, used before checking a loop body, since an assignment
+// late in the body invalidates range facts for the next iteration as well.
+static bool dk_clause_list_may_assign(dk_clause_list clauses, str name) {
+    bool ret = false;
+    for_list (dk_clause, clause, clauses) {
+        bool is_gem = false;
+        for_list (dk_clause_part, part, clause->parts) {
+            if (part->kind == DK_CLAUSE_PART_KIND_WORD) {
+                if (str_eq_nocase(part->word, str("gem"))) is_gem = true;
+                if (str_eq_nocase(part->word, name) && is_gem) ret = true;
+            }
 
-        default: {
-            assert(false && "Invalid stmt kind.");
-        } break;
+            if (part->kind == DK_CLAUSE_PART_KIND_LIST) {
+                ret |= dk_clause_list_may_assign(part->list, name);
+            }
+        }
     }
+    return ret;
 }
 
-static void dk_check_stmt_list(dk_checker *c, dk_stmt_list stmts) {
+static bool dk_stmt_list_may_assign(dk_stmt_list stmts, str name) {
+    bool ret = false;
     for_list (dk_stmt, stmt, stmts) {
-        dk_check_stmt(c, stmt);
+        ret |= dk_clause_list_may_assign(stmt->clauses, name);
+        ret |= dk_clause_list_may_assign(stmt->end_clauses, name);
+        ret |= dk_stmt_list_may_assign(stmt->then, name);
+        ret |= dk_stmt_list_may_assign(stmt->else_, name);
     }
+    return ret;
 }
 
-static void dk_check_func_sig(dk_checker *c, dk_func *func) {
-    // rune: Symbol id
-    if (func->kind == DK_FUNC_KIND_USER) {
-        func->symbol_id = ++c->symbol_id_counter;
+static void dk_check_index_in_range(dk_checker *c, dk_expr *expr, dk_loc loc) {
+    dk_expr *list  = expr->func_args.first;
+    dk_expr *index = expr->func_args.last;
+    i64 count = list->type->count;
+
+    // rune: Constant index.
+    if (index->kind == DK_EXPR_KIND_LITERAL) {
+        if (index->literal.int_ >= 0 && index->literal.int_ < count) {
+            expr->flags |= DK_EXPR_FLAG_UNCHECKED;
+        } else {
+            dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "Index % is out of bounds for list of length %.", index->literal.int_, count));
+        }
     }
 
-    // rune: Return type
-    func->type = dk_resolve_type(c, func->type_name);
+    // rune: Loop index.
+    if (index->kind == DK_EXPR_KIND_LOCAL) {
+        for (dk_range_fact *fact = c->range_facts; fact; fact = fact->next) {
+            if (fact->local == index->local && !fact->killed && fact->max <= count) {
+                expr->flags |= DK_EXPR_FLAG_UNCHECKED;
 
-    // rune: Arguments
-    for_list (dk_pattern_part, part, func->pattern.parts) {
-        if (part->type_name.len > 0) {
-            part->type = dk_resolve_type(c, part->type_name);
+                dk_unchecked_index *unchecked = arena_push_struct(c->arena, dk_unchecked_index);
+                unchecked->expr  = expr;
+                unchecked->local = index->local;
+                slstack_push(&c->unchecked_indices, unchecked);
+                break;
+            }
         }
     }
 }
 
-static void dk_check_func_body(dk_checker *c, dk_func *func) {
-    // TODO(rune): Cleanup
-    dk_local_list restore_locals = c->locals;
-    c->locals.first = null;
-    c->locals.last  = null;
+static dk_expr *dk_check_list_access(dk_checker *c, dk_func *func, dk_expr_list args, dk_loc loc) {
+    dk_expr *list = func->kind == DK_FUNC_KIND_LIST_STORE ? args.last : args.first;
+    if (list->kind != DK_EXPR_KIND_LOCAL || list->type->kind != DK_TYPE_KIND_LIST) {
+        dk_report_err(c->ctx, loc, dk_tprint(c->ctx,
+            "Type mismtach\n"
+            "    Wanted: liste\n"
+            "    Given:  %\n",
+            list->type->name)
+        );
+
+        dk_expr *dummy = arena_push_struct(c->arena, dk_expr);
+        dummy->kind    = DK_EXPR_KIND_LITERAL;
+        dummy->literal = dk_make_literal_int(0);
+        dummy->type    = c->builtin_int;
+        return dummy;
+    }
+
+    // NOTE(rune): Whole records don't fit in a single slot, so they are accessed one field at a time, e.g. "X af L på plads I".
+    if (list->type->elem->kind == DK_TYPE_KIND_RECORD && func->kind != DK_FUNC_KIND_LIST_LENGTH) {
+        dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "Elements of % must be accessed through their fields.", list->type->name));
+    }
+
+    dk_expr *expr = arena_push_struct(c->arena, dk_expr);
+    switch (func->kind) {
+        // rune: Length is known at compile time e.g. "Længden af L".
+        case DK_FUNC_KIND_LIST_LENGTH: {
+            expr->kind    = DK_EXPR_KIND_LITERAL;
+            expr->literal = dk_make_literal_int(list->type->count);
+            expr->type    = c->builtin_int;
+        } break;
+
+        // rune: Load e.g. "L på plads I".
+        case DK_FUNC_KIND_LIST_LOAD: {
+            expr->kind      = DK_EXPR_KIND_INDEX;
+            expr->type      = list->type->elem;
+            expr->func_args = args;
+            dk_check_index_in_range(c, expr, loc);
+        } break;
+
+        // rune: Store e.g. "Gem 5 på plads I i L".
+        case DK_FUNC_KIND_LIST_STORE: {
+            dk_expr *rvalue = args.first;
+            dk_expr *index  = rvalue->next;
+            if (!dk_types_compatible(list->type->elem, rvalue->type)) {
+                dk_report_err(c->ctx, loc, dk_tprint(c->ctx,
+                    "Type mismtach\n"
+                    "    Wanted: %\n"
+                    "    Given:  %\n",
+                    list->type->elem->name,
+                    rvalue->type->name)
+                );
+            }
+
+            rvalue->next = null;
+            index->next  = null;
+
+            dk_expr *lvalue = arena_push_struct(c->arena, dk_expr);
+            lvalue->kind = DK_EXPR_KIND_INDEX;
+            lvalue->type = list->type->elem;
+            slist_push(&lvalue->func_args, list);
+            slist_push(&lvalue->func_args, index);
+            dk_check_index_in_range(c, lvalue, loc);
+
+            expr->kind = DK_EXPR_KIND_ASSIGN;
+            expr->type = c->builtin_int; // TODO(rune): Void type
+            slist_push(&expr->func_args, rvalue);
+            slist_push(&expr->func_args, lvalue);
+        } break;
+
+        default: {
+            assert(false && "Invalid func kind.");
+        } break;
+    }
+
+    return expr;
+}
+
+static bool dk_is_bulk_list(dk_checker *c, dk_expr *expr) {
+    return (expr->kind == DK_EXPR_KIND_LOCAL) &&
+           (expr->type->kind == DK_TYPE_KIND_LIST) &&
+           (expr->type->elem == c->builtin_int || expr->type->elem == c->builtin_float);
+}
+
+static dk_expr *dk_check_bulk(dk_checker *c, dk_func *func, dk_expr_list args, dk_loc loc) {
+    // rune: Normalize arguments to (dst, src) or (dst, scalar).
+    dk_expr *dst = args.first;
+    dk_expr *src = args.first->next;
+    if (func->bulk_op == DK_BULK_OP_ADD) {
+        swap(dk_expr *, &dst, &src); // NOTE(rune): "Læg A til B elementvis" updates B.
+    }
+
+    dk_expr *expr = arena_push_struct(c->arena, dk_expr);
+    expr->kind = DK_EXPR_KIND_BULK;
+    expr->func = func;
+    expr->type = c->builtin_int; // TODO(rune): Void type
+
+    if (!dk_is_bulk_list(c, dst)) {
+        dk_report_err(c->ctx, loc, dk_tprint(c->ctx,
+            "Type mismtach\n"
+            "    Wanted: liste af heltal eller flyder\n"
+            "    Given:  %\n",
+            dst->type->name)
+        );
+        return expr;
+    }
+
+    switch (func->bulk_op) {
+        case DK_BULK_OP_SUM:
+        case DK_BULK_OP_DOT:
+        case DK_BULK_OP_MIN:
+        case DK_BULK_OP_MAX: {
+            expr->type = dst->type->elem;
+        } break;
+    }
+
+    if (src) {
+        dk_type *want = func->bulk_op == DK_BULK_OP_SCALE ? dst->type->elem : dst->type;
+        bool match = func->bulk_op == DK_BULK_OP_SCALE
+            ? src->type == want
+            : dk_is_bulk_list(c, src) && src->type->elem == dst->type->elem && src->type->count == dst->type->count;
+
+        if (!match) {
+            dk_report_err(c->ctx, loc, dk_tprint(c->ctx,
+                "Type mismtach\n"
+                "    Wanted: %\n"
+                "    Given:  %\n",
+                want->name,
+                src->type->name)
+            );
+        }
+    }
+
+    expr->bulk_kernel = dk_bulk_kernel_from_op(func->bulk_op, dst->type->elem == c->builtin_float);
+
+    dst->next = null;
+    slist_push(&expr->func_args, dst);
+    if (src) {
+        src->next = null;
+        slist_push(&expr->func_args, src);
+    }
+
+    return expr;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Records
+
+static void dk_layout_type(dk_checker *c, dk_type *type) {
+    if (type->kind != DK_TYPE_KIND_RECORD || (type->flags & DK_TYPE_FLAG_LAID_OUT)) {
+        return;
+    }
+
+    if (type->flags & DK_TYPE_FLAG_LAYING_OUT) {
+        dk_report_err(c->ctx, type->loc, dk_tprint(c->ctx, "Type % contains itself.", type->name));
+        return;
+    }
+
+    type->flags |= DK_TYPE_FLAG_LAYING_OUT;
+
+    // rune: Fields are placed in declaration order. Packed fields are aligned to their size, and fields of a slot
+    // or larger start at a new slot.
+    i64 size = 0;
+    for_list (dk_field, field, type->fields) {
+        for_list (dk_field, prev, type->fields) {
+            if (prev == field) break;
+            if (str_eq_nocase(prev->name, field->name)) {
+                dk_report_err(c->ctx, field->loc, dk_tprint(c->ctx, "Duplicate field %.", field->name));
+            }
+        }
+
+        field->type = dk_resolve_type(c, field->type_name);
+        dk_layout_type(c, field->type);
+        if (field->type == c->builtin_map) {
+            dk_report_err(c->ctx, field->loc, dk_tprint(c->ctx, "Fields can't be of type %.", field->type->name));
+        }
+
+        i64 align   = dk_type_is_packed(field->type) ? field->type->size : 8;
+        field->off  = align_to_pow2(size, align);
+        size        = field->off + field->type->size;
+    }
+
+    type->size   = align_to_pow2(size, 8);
+    type->flags &= ~DK_TYPE_FLAG_LAYING_OUT;
+    type->flags |= DK_TYPE_FLAG_LAID_OUT;
+}
+
+static dk_field *dk_resolve_field(dk_type *type, str name) {
+    dk_field *ret = null;
+    for_list (dk_field, field, type->fields) {
+        if (str_eq_nocase(field->name, name)) {
+            ret = field;
+            break;
+        }
+    }
+    return ret;
+}
+
+static bool dk_clause_part_is_word(dk_clause_part *part, str word) {
+    return part && part->kind == DK_CLAUSE_PART_KIND_WORD && str_eq_nocase(part->word, word);
+}
+
+// NOTE(rune): Field access is matched directly on the clause parts, since field names are not values, and can't
+// be matched by function patterns. Recognizes "X af P" where P is a record local, and "X af L på plads I" where L
+// is a list of records. On a match, *part is advanced to the last part of the field access.
+static dk_expr *dk_check_field_access(dk_checker *c, dk_clause_part **part, dk_loc loc) {
+    dk_clause_part *name_part = *part;
+    dk_clause_part *af_part   = name_part->next;
+    if (name_part->kind != DK_CLAUSE_PART_KIND_WORD || !dk_clause_part_is_word(af_part, str("af")) ||
+        af_part->next == null || af_part->next->kind != DK_CLAUSE_PART_KIND_WORD) {
+        return null;
+    }
+
+    dk_clause_part *base_part = af_part->next;
+    dk_local *base = dk_resolve_local(c, base_part->word);
+    if (base == null) {
+        return null;
+    }
+
+    dk_type *record = base->type->kind == DK_TYPE_KIND_LIST ? base->type->elem : base->type;
+    dk_field *field = record->kind == DK_TYPE_KIND_RECORD ? dk_resolve_field(record, name_part->word) : null;
+    if (field == null) {
+        return null;
+    }
+
+    dk_expr *base_expr = arena_push_struct(c->arena, dk_expr);
+    base_expr->kind  = DK_EXPR_KIND_LOCAL;
+    base_expr->local = base;
+    base_expr->type  = base->type;
+
+    dk_expr *expr = arena_push_struct(c->arena, dk_expr);
+    expr->kind  = DK_EXPR_KIND_FIELD;
+    expr->field = field;
+    expr->type  = field->type;
+    slist_push(&expr->func_args, base_expr);
+
+    // rune: Record local e.g. "X af P".
+    if (base->type->kind == DK_TYPE_KIND_RECORD) {
+        *part = base_part;
+        return expr;
+    }
+
+    // rune: Record in list e.g. "X af L på plads I".
+    dk_clause_part *index_part = base_part->next;
+    if (!dk_clause_part_is_word(index_part, str("på")) || !dk_clause_part_is_word(index_part->next, str("plads")) ||
+        index_part->next->next == null) {
+        return null;
+    }
+    index_part = index_part->next->next;
+
+    dk_expr *index = dk_check_clause_part(c, index_part);
+    if (index == null || !dk_type_is_int(index->type)) {
+        dk_report_err(c->ctx, loc, dk_tprint(c->ctx,
+            "Type mismtach\n"
+            "    Wanted: %\n"
+            "    Given:  %\n",
+            c->builtin_int->name,
+            index ? index->type->name : index_part->word)
+        );
+        return null;
+    }
+
+    if (dk_slot_count_from_type(field->type) > 1) {
+        dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "Field % of type % can't be accessed in a list.", field->name, field->type->name));
+    }
+
+    slist_push(&expr->func_args, index);
+    dk_check_index_in_range(c, expr, loc);
+
+    *part = index_part;
+    return expr;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Checked arithmetic
+
+// NOTE(rune): Each returns true on overflow, and stores the wrapped result. Used both by constant folding and by
+// the checked instructions at runtime, so they always agree.
+static bool dk_add_overflow(i64 a, i64 b, i64 *result) {
+#if _WIN32
+    *result = i64(u64(a) + u64(b));
+    return ((a ^ *result) & (b ^ *result)) < 0;
+#else
+    return __builtin_add_overflow(a, b, result);
+#endif
+}
+
+static bool dk_sub_overflow(i64 a, i64 b, i64 *result) {
+#if _WIN32
+    *result = i64(u64(a) - u64(b));
+    return ((a ^ b) & (a ^ *result)) < 0;
+#else
+    return __builtin_sub_overflow(a, b, result);
+#endif
+}
+
+static bool dk_mul_overflow(i64 a, i64 b, i64 *result) {
+#if _WIN32
+    i64 hi = 0;
+    *result = _mul128(a, b, &hi);
+    return hi != (*result >> 63);
+#else
+    return __builtin_mul_overflow(a, b, result);
+#endif
+}
+
+// NOTE(rune): Checked version of the integer bulk kernels. Runs element by element in the same order as the
+// interpreted loop would, and stops at the first overflow, so earlier elements are updated like they would be there.
+// The vector kernels have no cheap overflow check, so they are only used in unchecked builds.
+static bool dk_bulk_overflow(dk_bulk_kernel kernel, u64 *dst, u64 *src, i64 count, u64 scalar, u64 *result) {
+    i64 *d   = (i64 *)dst;
+    i64 *s   = (i64 *)src;
+    i64 acc  = 0;
+    i64 prod = 0;
+    bool ret = false;
+
+    switch (dk_bulk_op_from_kernel(kernel)) {
+        case DK_BULK_OP_SUM: {
+            for (i64 i = 0; i < count && !ret; i++) ret = dk_add_overflow(acc, d[i], &acc);
+        } break;
+
+        case DK_BULK_OP_DOT: {
+            for (i64 i = 0; i < count && !ret; i++) ret = dk_mul_overflow(d[i], s[i], &prod) || dk_add_overflow(acc, prod, &acc);
+        } break;
+
+        case DK_BULK_OP_ADD: {
+            for (i64 i = 0; i < count && !ret; i++) ret = dk_add_overflow(d[i], s[i], &d[i]);
+        } break;
+
+        case DK_BULK_OP_MUL: {
+            for (i64 i = 0; i < count && !ret; i++) ret = dk_mul_overflow(d[i], s[i], &d[i]);
+        } break;
+
+        case DK_BULK_OP_SCALE: {
+            for (i64 i = 0; i < count && !ret; i++) ret = dk_mul_overflow(d[i], i64(scalar), &d[i]);
+        } break;
+
+        default: {
+            assert(false && "Kernel cannot overflow.");
+        } break;
+    }
+
+    *result = u64(acc);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Constant folding
+
+static u64 dk_u64_from_literal(dk_literal literal) {
+    u64 ret = 0;
+    switch (literal.kind) {
+        case DK_LITERAL_KIND_INT:   ret = u64(literal.int_);            break;
+        case DK_LITERAL_KIND_FLOAT: ret = u64_from_f64(literal.float_); break;
+        case DK_LITERAL_KIND_BOOL:  ret = u64(literal.bool_);           break;
+        default:                    assert(false && "Invalid literal kind."); break;
+    }
+    return ret;
+}
+
+static bool dk_fold_opcode(dk_bc_opcode opcode, u64 a, u64 b, bool checked, u64 *result) {
+    // NOTE(rune): Must match the semantics of dk_run_program() exactly.
+    // Divisions by zero are not folded, so that they fail at runtime like they would without folding.
+    // In checked builds, overflows are not folded either, so that they trap at runtime.
+    f64 fa = f64_from_u64(a);
+    f64 fb = f64_from_u64(b);
+    i64 r  = 0;
+    bool div_ok = b != 0 && !(i64(a) == I64_MIN && i64(b) == -1);
+    bool ret = true;
+    switch (opcode) {
+        case DK_BC_OPCODE_ADD:  ret = !dk_add_overflow(i64(a), i64(b), &r) || !checked; *result = u64(r); break;
+        case DK_BC_OPCODE_SUB:  ret = !dk_sub_overflow(i64(a), i64(b), &r) || !checked; *result = u64(r); break;
+        case DK_BC_OPCODE_UMUL: *result = a * b;                                    break;
+        case DK_BC_OPCODE_IMUL: ret = !dk_mul_overflow(i64(a), i64(b), &r) || !checked; *result = u64(r); break;
+        case DK_BC_OPCODE_UDIV: if (b) *result = a / b;                  else ret = false; break;
+        case DK_BC_OPCODE_IDIV: if (div_ok) *result = u64(i64(a) / i64(b)); else ret = false; break;
+        case DK_BC_OPCODE_MOD:  if (div_ok) *result = u64(i64(a) % i64(b)); else ret = false; break;
+
+        case DK_BC_OPCODE_BAND: *result = a & b;                                    break;
+        case DK_BC_OPCODE_BOR:  *result = a | b;                                    break;
+        case DK_BC_OPCODE_BXOR: *result = a ^ b;                                    break;
+        case DK_BC_OPCODE_SHL:  *result = a << (b & 63);                            break;
+        case DK_BC_OPCODE_SHR:  *result = u64(i64(a) >> (b & 63));                  break;
+
+        case DK_BC_OPCODE_FADD: *result = u64_from_f64(fa + fb);                    break;
+        case DK_BC_OPCODE_FSUB: *result = u64_from_f64(fa - fb);                    break;
+        case DK_BC_OPCODE_FMUL: *result = u64_from_f64(fa * fb);                    break;
+        case DK_BC_OPCODE_FDIV: *result = u64_from_f64(fa / fb);                    break;
+
+        case DK_BC_OPCODE_IABS: *result = i64(a) < 0 ? 0 - a : a;                   break;
+        case DK_BC_OPCODE_IMIN: *result = i64(a) < i64(b) ? a : b;                  break;
+        case DK_BC_OPCODE_IMAX: *result = i64(a) > i64(b) ? a : b;                  break;
+
+        case DK_BC_OPCODE_FSQRT:  *result = u64_from_f64(sqrt(fa));                 break;
+        case DK_BC_OPCODE_FFLOOR: *result = u64_from_f64(floor(fa));                break;
+        case DK_BC_OPCODE_FABS:   *result = u64_from_f64(fabs(fa));                 break;
+        case DK_BC_OPCODE_FMIN:   *result = u64_from_f64(fmin(fa, fb));             break;
+        case DK_BC_OPCODE_FMAX:   *result = u64_from_f64(fmax(fa, fb));             break;
+        case DK_BC_OPCODE_FPOW:   *result = u64_from_f64(pow(fa, fb));              break;
+
+        case DK_BC_OPCODE_AND:  *result = a && b;                                   break;
+        case DK_BC_OPCODE_OR:   *result = a || b;                                   break;
+        case DK_BC_OPCODE_NOT:  *result = !a;                                       break;
+
+        case DK_BC_OPCODE_EQ:   *result = i64(a) == i64(b);                         break;
+        case DK_BC_OPCODE_LT:   *result = i64(a) < i64(b);                          break;
+        case DK_BC_OPCODE_GT:   *result = i64(a) > i64(b);                          break;
+
+        case DK_BC_OPCODE_FEQ:  *result = fa == fb;                                 break;
+        case DK_BC_OPCODE_FLT:  *result = fa < fb;                                  break;
+        case DK_BC_OPCODE_FGT:  *result = fa > fb;                                  break;
+
+        case DK_BC_OPCODE_I2F:  *result = u64_from_f64(f64(i64(a)));                break;
+        case DK_BC_OPCODE_F2I:  *result = u64(i64(fa));                             break;
+
+        default:                ret = false;                                        break;
+    }
+    return ret;
+}
+
+// NOTE(rune): Replaces an opcode intrinsic with a literal, when all its arguments are literals.
+static dk_expr *dk_fold_expr(dk_checker *c, dk_expr *expr) {
+    dk_expr *ret = expr;
+    if (expr->kind == DK_EXPR_KIND_FUNC && expr->func->kind == DK_FUNC_KIND_OPCODE) {
+        u64 args[2] = { 0 };
+        i64 arg_count = 0;
+        bool all_literal = true;
+        for_list (dk_expr, arg, expr->func_args) {
+            if (arg->kind != DK_EXPR_KIND_LITERAL || arg->literal.kind == DK_LITERAL_KIND_TEXT || arg_count >= countof(args)) {
+                all_literal = false;
+                break;
+            }
+            args[arg_count++] = dk_u64_from_literal(arg->literal);
+        }
+
+        u64 result = 0;
+        bool checked = !(c->flags & DK_BUILD_FLAG_UNCHECKED);
+        if (all_literal && dk_fold_opcode(expr->func->opcode, args[0], args[1], checked, &result)) {
+            dk_literal literal = { 0 };
+            if (expr->type == c->builtin_int)   literal = dk_make_literal_int(i64(result));
+            if (expr->type == c->builtin_float) literal = dk_make_literal_float(f64_from_u64(result));
+            if (expr->type == c->builtin_bool)  literal = dk_make_literal_bool(result != 0);
+
+            if (literal.kind != DK_LITERAL_KIND_NONE) {
+                ret = arena_push_struct(c->arena, dk_expr);
+                ret->kind    = DK_EXPR_KIND_LITERAL;
+                ret->literal = literal;
+                ret->type    = expr->type;
+            }
+        }
+    }
+    return ret;
+}
+
+static dk_expr *dk_expr_from_literal(dk_checker *c, dk_literal literal) {
+    dk_expr *expr = arena_push_struct(c->arena, dk_expr);
+    expr->kind = DK_EXPR_KIND_LITERAL;
+    expr->literal = literal;
+
+    switch (literal.kind) {
+        case DK_LITERAL_KIND_INT:   expr->type = c->builtin_int;     break;
+        case DK_LITERAL_KIND_FLOAT: expr->type = c->builtin_float;   break;
+        case DK_LITERAL_KIND_BOOL:  expr->type = c->builtin_bool;    break;
+        case DK_LITERAL_KIND_TEXT:  expr->type = c->builtin_text;    break;
+        default:                    assert(false && "Invalid literal kind.");
+    }
+
+    return expr;
+}
+
+// NOTE(rune): Returns null for words, which are not locals, since they are part of a function pattern.
+static dk_expr *dk_check_clause_part(dk_checker *c, dk_clause_part *part) {
+    dk_expr *arg = null;
+    switch (part->kind) {
+        case DK_CLAUSE_PART_KIND_WORD: {
+            // NOTE(rune): Locals shadow globals with the same name.
+            dk_local *local       = dk_resolve_local(c, part->word);
+            dk_constant *constant = local ? null : dk_resolve_constant(c, part->word);
+            dk_local *global      = local || constant ? null : dk_resolve_global(c, part->word);
+            if (local) {
+                arg = arena_push_struct(c->arena, dk_expr);
+                arg->kind = DK_EXPR_KIND_LOCAL;
+                arg->local = local;
+                arg->type = local->type;
+            } else if (constant) {
+                arg = dk_expr_from_literal(c, constant->literal);
+            } else if (global) {
+                arg = arena_push_struct(c->arena, dk_expr);
+                arg->kind = DK_EXPR_KIND_GLOBAL;
+                arg->local = global;
+                arg->type = global->type;
+            }
+        } break;
+
+        case DK_CLAUSE_PART_KIND_LIST: {
+            arg = dk_check_clause_list(c, part->list);
+        } break;
+
+        case DK_CLAUSE_PART_KIND_LITERAL: {
+            arg = dk_expr_from_literal(c, part->literal);
+        } break;
+
+        default: {
+            assert(false && "Invalid clause part kind.");
+        } break;
+    }
+
+    return arg;
+}
+
+static dk_expr *dk_check_clause(dk_checker *c, dk_clause *clause) {
+    // rune: Check arguments
+    dk_pattern want_pattern = { 0 };
+    dk_expr_list args = { 0 };
+    for (dk_clause_part *part = clause->parts.first; part; part = part->next) {
+        dk_expr *arg = dk_check_field_access(c, &part, clause->token->loc);
+        if (arg == null) {
+            arg = dk_check_clause_part(c, part);
+        }
+
+        if (arg) {
+            assert(arg->type != null);
+            slist_push(&args, arg);
+
+            // TODO(rune): Cleanup
+            dk_pattern_part *arg_part = dk_pattern_push_part(&want_pattern, c->arena);
+            arg_part->type = arg->type;
+        } else {
+            assert(part->kind == DK_CLAUSE_PART_KIND_WORD);
+            dk_pattern_push_word(&want_pattern, c->arena, part->word);
+        }
+    }
+
+    dk_expr *expr = null;
+    if ((want_pattern.parts.count == 1) &&
+        (args.first == args.last) &&
+        (args.first != null)) {
+        expr = args.first;
+    } else {
+        dk_func *func = dk_resolve_func(c, want_pattern, clause->token->loc);
+        if (func->kind == DK_FUNC_KIND_ASSIGN) {
+            // rune: Assignment e.g. "Gem det i A"
+            expr = arena_push_struct(c->arena, dk_expr);
+            expr->kind = DK_EXPR_KIND_ASSIGN;
+            expr->type = c->builtin_int; // TODO(rune): Void type
+            expr->func_args = args;
+
+            // TODO(rune): Check valid lvalue
+
+            dk_expr *rvalue = args.first;
+            dk_expr *lvalue = args.last;
+            if (!dk_types_compatible(lvalue->type, rvalue->type)) {
+                dk_report_err(c->ctx, clause->token->loc, dk_tprint(c->ctx,
+                    "Type mismtach\n"
+                    "    Wanted: %\n"
+                    "    Given:  %\n",
+                    lvalue->type->name,
+                    rvalue->type->name)
+                );
+            }
+
+            if (lvalue->kind == DK_EXPR_KIND_LOCAL) {
+                dk_note_assign(c, lvalue->local, rvalue);
+            }
+
+            if (lvalue->kind == DK_EXPR_KIND_LITERAL) {
+                dk_report_err(c->ctx, clause->token->loc, str("Can't assign to a constant."));
+            }
+
+            // NOTE(rune): Each ordbog local owns its map, so copying one would free it twice.
+            if (lvalue->type == c->builtin_map) {
+                dk_report_err(c->ctx, clause->token->loc, dk_tprint(c->ctx, "A value of type % can't be copied.", lvalue->type->name));
+            }
+
+        } else if (func->kind == DK_FUNC_KIND_LIST_LOAD ||
+                   func->kind == DK_FUNC_KIND_LIST_STORE ||
+                   func->kind == DK_FUNC_KIND_LIST_LENGTH) {
+            // rune: List access
+            expr = dk_check_list_access(c, func, args, clause->token->loc);
+        } else if (func->kind == DK_FUNC_KIND_BULK) {
+            // rune: Bulk operation on whole lists
+            expr = dk_check_bulk(c, func, args, clause->token->loc);
+            expr->token = clause->token;
+        } else {
+            // rune: Normal function call
+            expr = arena_push_struct(c->arena, dk_expr);
+            expr->kind = DK_EXPR_KIND_FUNC;
+            expr->func = func;
+            expr->type = func->type;
+            expr->func_args = args;
+            expr->token = clause->token;
+            expr = dk_fold_expr(c, expr);
+        }
+    }
+
+
+    assert(expr->type);
+    return expr;
+}
+
+static dk_expr *dk_check_clause_list(dk_checker *c, dk_clause_list clauses) {
+    dk_expr *expr = null;
+
+    if (clauses.first == clauses.last) {
+        expr = dk_check_clause(c, clauses.first);
+    } else {
+        expr = arena_push_struct(c->arena, dk_expr);
+        expr->kind = DK_EXPR_KIND_LIST;
+        for_list (dk_clause, subclause, clauses) {
+            dk_expr *subexpr = dk_check_clause(c, subclause);
+            slist_push(&expr->list, subexpr);
+        }
+        expr->type = expr->list.last->type;
+    }
+
+    assert(expr->type);
+    return expr;
+}
+
+static void dk_check_stmt(dk_checker *c, dk_stmt *stmt) {
+    switch (stmt->kind) {
+        case DK_STMT_KIND_CONST: {
+            // NOTE(rune): Constants are assigned exactly once, so a name can't be declared again.
+            if (dk_resolve_constant(c, stmt->name) || dk_resolve_local(c, stmt->name)) {
+                dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "% is already declared.", stmt->name));
+            }
+
+            dk_constant *constant = arena_push_struct(c->arena, dk_constant);
+            constant->name    = stmt->name;
+            constant->literal = stmt->literal;
+            slstack_push(&c->constants, constant);
+        } break;
+
+        case DK_STMT_KIND_DECL: {
+            if (dk_resolve_constant(c, stmt->name)) {
+                dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "% is already declared as a constant.", stmt->name));
+            }
+
+            // rune: List length given by a constant.
+            if (stmt->list_count_name.len > 0) {
+                dk_constant *constant = dk_resolve_constant(c, stmt->list_count_name);
+                if (constant && constant->literal.kind == DK_LITERAL_KIND_INT && constant->literal.int_ > 0) {
+                    stmt->list_count = constant->literal.int_;
+                } else {
+                    dk_report_err(c->ctx, stmt->token->loc, str("List length must be a positive integer."));
+                    break;
+                }
+            }
+
+            dk_type *type = dk_resolve_type(c, stmt->type_name);
+            if (stmt->list_count > 0) {
+                if ((dk_slot_count_from_type(type) > 1 && type->kind != DK_TYPE_KIND_RECORD) || type == c->builtin_map) {
+                    dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "Lists of % are not supported.", type->name));
+                }
+                if (stmt->list_soa && type->kind != DK_TYPE_KIND_RECORD) {
+                    dk_report_err(c->ctx, stmt->token->loc, str("Only lists of records can be columnar."));
+                }
+                type = dk_make_list_type(c, type, stmt->list_count, stmt->list_soa);
+            }
+            dk_push_local(c, stmt->name, type);
+        } break;
+
+        case DK_STMT_KIND_WHILE: {
+            // rune: Kill range facts from outer loops, if this loop may reassign their local.
+            for (dk_range_fact *fact = c->range_facts; fact; fact = fact->next) {
+                if (dk_clause_list_may_assign(stmt->clauses, fact->local->name) ||
+                    dk_stmt_list_may_assign(stmt->then, fact->local->name)) {
+                    fact->killed = true;
+                }
+            }
+
+            stmt->expr = dk_check_clause_list(c, stmt->clauses);
+
+            // rune: Condition "I er mindre end N" gives a range fact for the body.
+            dk_range_fact *fact = null;
+            dk_expr *cond = stmt->expr;
+            if (cond->kind == DK_EXPR_KIND_FUNC &&
+                cond->func->kind == DK_FUNC_KIND_OPCODE &&
+                cond->func->opcode == DK_BC_OPCODE_LT &&
+                cond->func_args.first->kind == DK_EXPR_KIND_LOCAL &&
+                cond->func_args.last->kind == DK_EXPR_KIND_LITERAL) {
+                fact = arena_push_struct(c->arena, dk_range_fact);
+                fact->local = cond->func_args.first->local;
+                fact->max   = cond->func_args.last->literal.int_;
+                slstack_push(&c->range_facts, fact);
+            }
+
+            dk_check_stmt_list(c, stmt->then);
+
+            if (fact) {
+                slstack_pop(&c->range_facts);
+            }
+        } break;
+
+        case DK_STMT_KIND_EXPR:
+        case DK_STMT_KIND_IF:
+        case DK_STMT_KIND_RETURN: {
+            stmt->expr = dk_check_clause_list(c, stmt->clauses);;
+            dk_check_stmt_list(c, stmt->then);
+            dk_check_stmt_list(c, stmt->else_);
+        } break;
+
+        case DK_STMT_KIND_SWITCH: {
+            stmt->expr = dk_check_clause_list(c, stmt->clauses);
+            if (!dk_type_is_int(stmt->expr->type)) {
+                dk_report_err(c->ctx, stmt->clauses.first->token->loc, dk_tprint(c->ctx,
+                    "Type mismtach\n"
+                    "    Wanted: %\n"
+                    "    Given:  %\n",
+                    c->builtin_int->name,
+                    stmt->expr->type->name)
+                );
+            }
+
+            for_list (dk_stmt, case_, stmt->then) {
+                assert(case_->kind == DK_STMT_KIND_CASE);
+
+                // rune: Case labels must be integer constants, and each label may only appear once in the switch.
+                for_list (dk_clause, clause, case_->clauses) {
+                    dk_expr *label = dk_check_clause(c, clause);
+                    if (label->kind != DK_EXPR_KIND_LITERAL || label->literal.kind != DK_LITERAL_KIND_INT) {
+                        dk_report_err(c->ctx, clause->token->loc, str("Case label must be a constant integer."));
+                        continue;
+                    }
+
+                    for_list (dk_stmt, prev_case, stmt->then) {
+                        for_list (dk_expr, prev_label, prev_case->labels) {
+                            if (prev_label->literal.int_ == label->literal.int_) {
+                                dk_report_err(c->ctx, clause->token->loc, dk_tprint(c->ctx, "Duplicate case label %.", label->literal.int_));
+                            }
+                        }
+                        if (prev_case == case_) break;
+                    }
+
+                    slist_push(&case_->labels, label);
+                }
+
+                dk_check_stmt_list(c, case_->then);
+            }
+
+            dk_check_stmt_list(c, stmt->else_);
+        } break;
+
+        case DK_STMT_KIND_PFOR: {
+            dk_check_pfor(c, stmt);
+        } break;
+
+        default: {
+            assert(false && "Invalid stmt kind.");
+        } break;
+    }
+}
+
+static void dk_check_stmt_list(dk_checker *c, dk_stmt_list stmts) {
+    for_list (dk_stmt, stmt, stmts) {
+        dk_check_stmt(c, stmt);
+    }
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Samtidig loops
+
+// NOTE(rune): Iterations run in chunks on different vms, each with its own copy of the call frame, so the body may
+// only write to locals declared inside of it, and to reductions. Locals declared before the loop can still be read.
+static void dk_check_pfor(dk_checker *c, dk_stmt *stmt) {
+    // rune: Kill range facts from outer loops, if this loop may reassign their local.
+    for (dk_range_fact *fact = c->range_facts; fact; fact = fact->next) {
+        if (dk_stmt_list_may_assign(stmt->then, fact->local->name)) {
+            fact->killed = true;
+        }
+    }
+
+    // rune: Bounds
+    stmt->expr     = dk_check_clause_list(c, stmt->clauses);
+    stmt->end_expr = dk_check_clause_list(c, stmt->end_clauses);
+    dk_expr *bounds[] = { stmt->expr, stmt->end_expr };
+    for_sarray (dk_expr *, bound, bounds) {
+        if (!dk_type_is_int((*bound)->type)) {
+            dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx,
+                "Type mismtach\n"
+                "    Wanted: %\n"
+                "    Given:  %\n",
+                c->builtin_int->name,
+                (*bound)->type->name)
+            );
+        }
+    }
+
+    // rune: Index, which is declared by the loop, unless a heltal of the same name already is.
+    dk_local *index = dk_resolve_local(c, stmt->name);
+    if (dk_resolve_constant(c, stmt->name)) {
+        dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "% is already declared as a constant.", stmt->name));
+    } else if (index && index->type != c->builtin_int) {
+        dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "The index of a Samtidig loop must be a heltal, but % is a %.", stmt->name, index->type->name));
+    }
+
+    if (index == null) {
+        index = dk_push_local(c, stmt->name, c->builtin_int);
+    }
+
+    stmt->index     = index;
+    stmt->index_end = dk_push_local(c, str(""), c->builtin_int); // NOTE(rune): Last index of the chunk, which can't be named.
+
+    dk_expr *first = stmt->expr;
+    if (first->kind != DK_EXPR_KIND_LITERAL || first->literal.kind != DK_LITERAL_KIND_INT || first->literal.int_ < 0) {
+        index->flags |= DK_LOCAL_FLAG_MAYBE_NEGATIVE;
+    }
+
+    // rune: Constant last index gives a range fact for the body.
+    dk_range_fact *fact = null;
+    dk_expr *last = stmt->end_expr;
+    if (last->kind == DK_EXPR_KIND_LITERAL && last->literal.kind == DK_LITERAL_KIND_INT && last->literal.int_ < I64_MAX) {
+        fact = arena_push_struct(c->arena, dk_range_fact);
+        fact->local = index;
+        fact->max   = last->literal.int_ + 1;
+        slstack_push(&c->range_facts, fact);
+    }
+
+    // rune: Body
+    dk_stmt *restore_pfor      = c->pfor;
+    i64 restore_pfor_frame_size = c->pfor_frame_size;
+    c->pfor            = stmt;
+    c->pfor_frame_size = c->frame_size;
+
+    dk_check_stmt_list(c, stmt->then);
+
+    // NOTE(rune): Writes are checked first, so every reduction is known, when reads are checked.
+    dk_check_pfor_stmt_list(c, stmt->then, false);
+    dk_check_pfor_stmt_list(c, stmt->then, true);
+
+    c->pfor            = restore_pfor;
+    c->pfor_frame_size = restore_pfor_frame_size;
+
+    if (fact) {
+        slstack_pop(&c->range_facts);
+    }
+}
+
+static void dk_check_pfor_stmt_list(dk_checker *c, dk_stmt_list stmts, bool reads) {
+    for_list (dk_stmt, stmt, stmts) {
+        if (stmt->kind == DK_STMT_KIND_PFOR) {
+            if (!reads) {
+                dk_report_err(c->ctx, stmt->token->loc, str("Samtidig loops can't be nested."));
+            }
+            continue;
+        }
+
+        if (stmt->kind == DK_STMT_KIND_RETURN && !reads) {
+            dk_report_err(c->ctx, stmt->token->loc, str("Can't return from inside a Samtidig loop."));
+        }
+
+        if (stmt->expr) {
+            dk_check_pfor_expr(c, stmt->expr, stmt->token->loc, reads);
+        }
+
+        dk_check_pfor_stmt_list(c, stmt->then, reads);
+        dk_check_pfor_stmt_list(c, stmt->else_, reads);
+    }
+}
+
+// NOTE(rune): Returns the other argument, if rvalue updates local as a reduction e.g. "Læg S sammen med J".
+static dk_expr *dk_reduction_arg(dk_expr *rvalue, dk_local *local, dk_bc_opcode *opcode) {
+    dk_expr *ret = null;
+    if (rvalue->kind == DK_EXPR_KIND_FUNC && rvalue->func->kind == DK_FUNC_KIND_OPCODE) {
+        switch (rvalue->func->opcode) {
+            case DK_BC_OPCODE_ADD:  case DK_BC_OPCODE_IMIN: case DK_BC_OPCODE_IMAX:
+            case DK_BC_OPCODE_FADD: case DK_BC_OPCODE_FMIN: case DK_BC_OPCODE_FMAX: {
+                dk_expr *a = rvalue->func_args.first;
+                dk_expr *b = rvalue->func_args.last;
+                if (a->kind == DK_EXPR_KIND_LOCAL && a->local == local) ret = b;
+                else if (b->kind == DK_EXPR_KIND_LOCAL && b->local == local) ret = a;
+                *opcode = rvalue->func->opcode;
+            } break;
+
+            default: break;
+        }
+    }
+    return ret;
+}
+
+static void dk_check_pfor_expr(dk_checker *c, dk_expr *expr, dk_loc loc, bool reads) {
+    dk_stmt *loop = c->pfor;
+    switch (expr->kind) {
+        case DK_EXPR_KIND_LOCAL: {
+            if (reads && expr->local->type == c->builtin_map) {
+                dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% can't be used in a Samtidig loop, since it is an ordbog.", expr->local->name));
+            }
+
+            for (dk_reduction *reduction = loop->reductions; reduction && reads; reduction = reduction->next) {
+                if (reduction->local == expr->local) {
+                    dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% is a reduction, and can only be used to update itself in the Samtidig loop.", expr->local->name));
+                }
+            }
+        } break;
+
+        case DK_EXPR_KIND_FUNC: {
+            dk_func *func = expr->func;
+            if (!reads && func->kind == DK_FUNC_KIND_OPCODE &&
+                (func->opcode == DK_BC_OPCODE_INI || func->opcode == DK_BC_OPCODE_INF || func->opcode == DK_BC_OPCODE_INMORE)) {
+                dk_report_err(c->ctx, loc, str("Input can't be read in a Samtidig loop."));
+            }
+
+            for_list (dk_expr, arg, expr->func_args) {
+                dk_check_pfor_expr(c, arg, loc, reads);
+            }
+        } break;
+
+        case DK_EXPR_KIND_LIST: {
+            for_list (dk_expr, subexpr, expr->list) {
+                dk_check_pfor_expr(c, subexpr, loc, reads);
+            }
+        } break;
+
+        case DK_EXPR_KIND_INDEX:
+        case DK_EXPR_KIND_FIELD: {
+            for_list (dk_expr, arg, expr->func_args) {
+                dk_check_pfor_expr(c, arg, loc, reads);
+            }
+        } break;
+
+        case DK_EXPR_KIND_BULK: {
+            dk_expr *dst = expr->func_args.first;
+            dk_bulk_op op = expr->func->bulk_op;
+            bool writes = op != DK_BULK_OP_SUM && op != DK_BULK_OP_DOT && op != DK_BULK_OP_MIN && op != DK_BULK_OP_MAX;
+            if (!reads && writes && dst->local->off < c->pfor_frame_size) {
+                dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% is shared between the iterations of the Samtidig loop, and can't be assigned in it.", dst->local->name));
+            }
+
+            for_list (dk_expr, arg, expr->func_args) {
+                dk_check_pfor_expr(c, arg, loc, reads);
+            }
+        } break;
+
+        case DK_EXPR_KIND_ASSIGN: {
+            dk_expr *rvalue = expr->func_args.first;
+            dk_expr *lvalue = expr->func_args.last;
+
+            // rune: Globals
+            if (lvalue->kind == DK_EXPR_KIND_GLOBAL) {
+                if (!reads) {
+                    dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% is a global, and can't be assigned in a Samtidig loop.", lvalue->local->name));
+                }
+                dk_check_pfor_expr(c, rvalue, loc, reads);
+                break;
+            }
+
+            // NOTE(rune): Elements and fields are written through the local of their list or record.
+            dk_expr *base = lvalue->kind == DK_EXPR_KIND_LOCAL ? lvalue : lvalue->func_args.first;
+            dk_local *local = base->local;
+            bool shared = local->off < c->pfor_frame_size;
+
+            // rune: Reductions
+            dk_expr *last = dk_unwrap_list_expr(rvalue);
+            dk_bc_opcode opcode = DK_BC_OPCODE_NOP;
+            dk_expr *arg = lvalue->kind == DK_EXPR_KIND_LOCAL && shared ? dk_reduction_arg(last, local, &opcode) : null;
+            bool is_float = opcode == DK_BC_OPCODE_FADD || opcode == DK_BC_OPCODE_FMIN || opcode == DK_BC_OPCODE_FMAX;
+            if (arg && local != loop->index && local->type == (is_float ? c->builtin_float : c->builtin_int)) {
+                if (!reads) {
+                    dk_reduction *found = null;
+                    for (dk_reduction *it = loop->reductions; it; it = it->next) {
+                        if (it->local == local) {
+                            found = it;
+                        }
+                    }
+
+                    if (found && found->opcode != opcode) {
+                        dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% is updated with different operations in the Samtidig loop.", local->name));
+                    } else if (found == null) {
+                        dk_reduction *reduction = arena_push_struct(c->arena, dk_reduction);
+                        reduction->local  = local;
+                        reduction->opcode = opcode;
+                        reduction->loc    = last->token ? last->token->loc : loc;
+                        slstack_push(&loop->reductions, reduction);
+                    }
+                }
+
+                // NOTE(rune): Every part of the right hand side is checked, except the reduction local itself.
+                if (rvalue->kind == DK_EXPR_KIND_LIST) {
+                    for_list (dk_expr, subexpr, rvalue->list) {
+                        if (subexpr != last) {
+                            dk_check_pfor_expr(c, subexpr, loc, reads);
+                        }
+                    }
+                }
+                dk_check_pfor_expr(c, arg, loc, reads);
+                break;
+            }
+
+            // rune: Other writes
+            if (!reads && local == loop->index) {
+                dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% is the index of the Samtidig loop, and can't be assigned.", local->name));
+            } else if (!reads && shared && lvalue->kind == DK_EXPR_KIND_LOCAL) {
+                dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% is shared between the iterations of the Samtidig loop, and can only be updated as a sum, minimum or maximum.", local->name));
+            } else if (!reads && shared) {
+                dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% is shared between the iterations of the Samtidig loop, and can't be assigned in it.", local->name));
+            }
+
+            dk_check_pfor_expr(c, rvalue, loc, reads);
+            for_list (dk_expr, lvalue_arg, lvalue->func_args) {
+                if (lvalue_arg != base) {
+                    dk_check_pfor_expr(c, lvalue_arg, loc, reads);
+                }
+            }
+        } break;
+
+        default: break;
+    }
+}
+
+// NOTE(rune): Globals are copied to each chunk, so a function called from a Samtidig loop must not assign them,
+// directly or through another call. Checked after every function, since the body of the called function may be
+// checked by another job.
+static void dk_check_pfor_calls(dk_checker *c, dk_func_list funcs) {
+    // rune: Functions which assign globals directly, and the callers of every function.
+    dk_func_ref *pending = null;
+    for_list (dk_func, func, funcs) {
+        if (func->kind == DK_FUNC_KIND_USER && dk_note_calls_stmt_list(c, func, func->stmts)) {
+            func->writes_globals = true;
+
+            dk_func_ref *ref = arena_push_struct(c->arena, dk_func_ref);
+            ref->func = func;
+            slstack_push(&pending, ref);
+        }
+    }
+
+    // rune: Callers of a function which assigns globals, assign them too.
+    while (pending) {
+        dk_func *func = pending->func;
+        slstack_pop(&pending);
+
+        for (dk_func_ref *caller = func->callers; caller; caller = caller->next) {
+            if (!caller->func->writes_globals) {
+                caller->func->writes_globals = true;
+
+                dk_func_ref *ref = arena_push_struct(c->arena, dk_func_ref);
+                ref->func = caller->func;
+                slstack_push(&pending, ref);
+            }
+        }
+    }
+
+    // rune: Calls from Samtidig loops.
+    for_list (dk_func, func, funcs) {
+        if (func->kind == DK_FUNC_KIND_USER) {
+            dk_check_pfor_calls_stmt_list(c, func->stmts, false);
+        }
+    }
+}
+
+static void dk_check_pfor_calls_stmt_list(dk_checker *c, dk_stmt_list stmts, bool in_pfor) {
+    for_list (dk_stmt, stmt, stmts) {
+        if (in_pfor && stmt->expr) {
+            dk_check_pfor_calls_expr(c, stmt->expr, stmt->token->loc);
+        }
+
+        dk_check_pfor_calls_stmt_list(c, stmt->then, in_pfor || stmt->kind == DK_STMT_KIND_PFOR);
+        dk_check_pfor_calls_stmt_list(c, stmt->else_, in_pfor);
+    }
+}
+
+static void dk_check_pfor_calls_expr(dk_checker *c, dk_expr *expr, dk_loc loc) {
+    if (expr->kind == DK_EXPR_KIND_FUNC && expr->func->writes_globals) {
+        dk_report_err(c->ctx, loc, dk_tprint(c->ctx, "% assigns a global, and can't be called in a Samtidig loop.", expr->func->signature));
+    }
+
+    switch (expr->kind) {
+        case DK_EXPR_KIND_LIST: {
+            for_list (dk_expr, subexpr, expr->list) {
+                dk_check_pfor_calls_expr(c, subexpr, loc);
+            }
+        } break;
+
+        case DK_EXPR_KIND_FUNC:
+        case DK_EXPR_KIND_ASSIGN:
+        case DK_EXPR_KIND_INDEX:
+        case DK_EXPR_KIND_BULK:
+        case DK_EXPR_KIND_FIELD: {
+            for_list (dk_expr, arg, expr->func_args) {
+                dk_check_pfor_calls_expr(c, arg, loc);
+            }
+        } break;
+
+        default: break;
+    }
+}
+
+// NOTE(rune): Returns whether the statements assign a global directly, and adds caller to the callers of every
+// function they call.
+static bool dk_note_calls_stmt_list(dk_checker *c, dk_func *caller, dk_stmt_list stmts) {
+    bool ret = false;
+    for_list (dk_stmt, stmt, stmts) {
+        if (stmt->expr) {
+            ret |= dk_note_calls_expr(c, caller, stmt->expr);
+        }
+        if (stmt->end_expr) {
+            ret |= dk_note_calls_expr(c, caller, stmt->end_expr);
+        }
+        ret |= dk_note_calls_stmt_list(c, caller, stmt->then);
+        ret |= dk_note_calls_stmt_list(c, caller, stmt->else_);
+    }
+    return ret;
+}
+
+static bool dk_note_calls_expr(dk_checker *c, dk_func *caller, dk_expr *expr) {
+    bool ret = false;
+    if (expr->kind == DK_EXPR_KIND_ASSIGN && expr->func_args.last->kind == DK_EXPR_KIND_GLOBAL) {
+        ret = true;
+    }
+
+    if (expr->kind == DK_EXPR_KIND_FUNC && expr->func->kind == DK_FUNC_KIND_USER) {
+        dk_func_ref *ref = arena_push_struct(c->arena, dk_func_ref);
+        ref->func = caller;
+        slstack_push(&expr->func->callers, ref);
+    }
+
+    switch (expr->kind) {
+        case DK_EXPR_KIND_LIST: {
+            for_list (dk_expr, subexpr, expr->list) {
+                ret |= dk_note_calls_expr(c, caller, subexpr);
+            }
+        } break;
+
+        case DK_EXPR_KIND_FUNC:
+        case DK_EXPR_KIND_ASSIGN:
+        case DK_EXPR_KIND_INDEX:
+        case DK_EXPR_KIND_BULK:
+        case DK_EXPR_KIND_FIELD: {
+            for_list (dk_expr, arg, expr->func_args) {
+                ret |= dk_note_calls_expr(c, caller, arg);
+            }
+        } break;
+
+        default: break;
+    }
+    return ret;
+}
+
+static void dk_check_func_sig(dk_checker *c, dk_func *func) {
+    // rune: Symbol id
+    if (func->kind == DK_FUNC_KIND_USER) {
+        func->symbol_id = ++c->symbol_id_counter;
+    }
+
+    // rune: Return type
+    func->type = dk_resolve_type(c, func->type_name);
+    if (func->type == c->builtin_map) {
+        dk_report_err(c->ctx, func->token->loc, dk_tprint(c->ctx, "Functions can't return %.", func->type->name));
+    }
+
+    // rune: Arguments
+    for_list (dk_pattern_part, part, func->pattern.parts) {
+        if (part->type_name.len > 0) {
+            part->type = dk_resolve_type(c, part->type_name);
+            func->arg_slots += dk_slot_count_from_type(part->type);
+        }
+    }
+
+    if (func->kind == DK_FUNC_KIND_USER) {
+        func->signature = dk_str_from_pattern(func->pattern, c->arena);
+
+        for_list (dk_pattern_part, part, func->pattern.parts) {
+            if (part->type) func->arg_count++;
+        }
+
+        func->arg_types = arena_push_array(c->arena, dk_type *, func->arg_count);
+        i64 arg_idx = 0;
+        for_list (dk_pattern_part, part, func->pattern.parts) {
+            if (part->type) func->arg_types[arg_idx++] = part->type;
+        }
+    }
+}
+
+// NOTE(rune): Globals can be of any basic type except ordbog. Records and lists are not supported, since their
+// instructions address the current call frame, and an ordbog global would have no function to free it.
+static void dk_check_globals(dk_checker *c, dk_stmt_list stmts) {
+    for_list (dk_stmt, stmt, stmts) {
+        if (stmt->kind == DK_STMT_KIND_CONST) {
+            if (dk_resolve_global(c, stmt->name)) {
+                dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "% is already declared.", stmt->name));
+            }
+
+            dk_check_stmt(c, stmt);
+            continue;
+        }
+
+        if (stmt->kind != DK_STMT_KIND_DECL) {
+            dk_report_err(c->ctx, stmt->token->loc, str("Only declarations are allowed outside of functions."));
+            continue;
+        }
+
+        // NOTE(rune): Same rules as for constants, since both are looked up by name from every function.
+        if (dk_resolve_constant(c, stmt->name)) {
+            dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "% is already declared as a constant.", stmt->name));
+        } else if (dk_resolve_global(c, stmt->name)) {
+            dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "% is already declared.", stmt->name));
+        }
+
+        dk_type *type = dk_resolve_type(c, stmt->type_name);
+        if (stmt->list_count > 0 || stmt->list_count_name.len > 0) {
+            dk_report_err(c->ctx, stmt->token->loc, str("Globals can't be lists."));
+        } else if (type->kind != DK_TYPE_KIND_BASIC || type == c->builtin_map) {
+            dk_report_err(c->ctx, stmt->token->loc, dk_tprint(c->ctx, "Globals can't be of type %.", type->name));
+        }
+
+        dk_local *global = arena_push_struct(c->arena, dk_local);
+        global->name = stmt->name;
+        global->type = type;
+        global->off  = c->tree->global_size;
+
+        slist_push(&c->globals, global);
+        c->globals.count++;
+        c->tree->global_size += dk_slot_count_from_type(type);
+    }
+}
+
+static void dk_check_func_body(dk_checker *c, dk_func *func) {
+    // TODO(rune): Cleanup
+    dk_local_list restore_locals = c->locals;
+    dk_constant *restore_constants = c->constants;
+    c->locals.first = null;
+    c->locals.last  = null;
+    c->frame_size   = 0;
+    c->unchecked_indices = null;
 
     assert(func->type); // NOTE(rune): Shuold've already been checked with dk_check_func_sig().
 
@@ -1047,15 +2491,25 @@ static void dk_check_func_body(dk_checker *c, dk_func *func) {
         if (part->type_name.len > 0) {
             dk_local *local = dk_push_local(c, part->name, part->type);
             local->flags |= DK_LOCAL_FLAG_ARG;
+            local->flags |= DK_LOCAL_FLAG_MAYBE_NEGATIVE;
         }
     }
 
     // rune: Body
     dk_check_stmt_list(c, func->stmts);
 
+    // rune: Range facts only prove an upper bound, so indices must also be non-negative to skip the bounds check.
+    for (dk_unchecked_index *it = c->unchecked_indices; it; it = it->next) {
+        if (it->local->flags & DK_LOCAL_FLAG_MAYBE_NEGATIVE) {
+            it->expr->flags &= ~DK_EXPR_FLAG_UNCHECKED;
+        }
+    }
+
     // TODO(rune): Cleanup
     func->locals = c->locals;
+    func->frame_size = c->frame_size * 8;
     c->locals = restore_locals;
+    c->constants = restore_constants;
 }
 
 static dk_pattern dk_pattern_from_str(str s, arena *arena) {
@@ -1084,31 +2538,93 @@ static dk_func *dk_func_make_opcode(dk_bc_opcode opcode, str pattern, str return
     return func;
 }
 
-static void dk_check_tree(dk_tree *tree, arena *arena) {
+static void dk_check_job_proc(void *param) {
+    dk_check_job *job = param;
+    for_n (i64, i, job->func_count) {
+        if (job->err.err_list.count > 0) break;
+        dk_check_func_body(&job->c, job->funcs[i]);
+    }
+}
+
+static void dk_check_tree(dk_tree *tree, dk_build_flags flags, dk_ctx *ctx) {
     dk_checker c = { 0 };
     c.tree = tree;
-    c.arena = arena;
+    c.arena = ctx->arena;
+    c.ctx = ctx;
+    c.flags = flags;
 
     // rune: Builtin types
     c.builtin_int          = arena_push_struct(c.arena, dk_type);
     c.builtin_int->name    = str("heltal");
     c.builtin_int->size    = 8;
+    c.builtin_int->kind    = DK_TYPE_KIND_BASIC;
+    c.builtin_int->flags   = DK_TYPE_FLAG_INTEGER|DK_TYPE_FLAG_SIGNED;
     slist_push(&tree->types, c.builtin_int);
 
+    c.builtin_u8           = arena_push_struct(c.arena, dk_type);
+    c.builtin_u8->name     = str("byte");
+    c.builtin_u8->size     = 1;
+    c.builtin_u8->kind     = DK_TYPE_KIND_BASIC;
+    c.builtin_u8->flags    = DK_TYPE_FLAG_INTEGER;
+    slist_push(&tree->types, c.builtin_u8);
+
+    c.builtin_i8           = arena_push_struct(c.arena, dk_type);
+    c.builtin_i8->name     = str("småtal");
+    c.builtin_i8->size     = 1;
+    c.builtin_i8->kind     = DK_TYPE_KIND_BASIC;
+    c.builtin_i8->flags    = DK_TYPE_FLAG_INTEGER|DK_TYPE_FLAG_SIGNED;
+    slist_push(&tree->types, c.builtin_i8);
+
+    c.builtin_i16          = arena_push_struct(c.arena, dk_type);
+    c.builtin_i16->name    = str("korttal");
+    c.builtin_i16->size    = 2;
+    c.builtin_i16->kind    = DK_TYPE_KIND_BASIC;
+    c.builtin_i16->flags   = DK_TYPE_FLAG_INTEGER|DK_TYPE_FLAG_SIGNED;
+    slist_push(&tree->types, c.builtin_i16);
+
+    c.builtin_i32          = arena_push_struct(c.arena, dk_type);
+    c.builtin_i32->name    = str("mellemtal");
+    c.builtin_i32->size    = 4;
+    c.builtin_i32->kind    = DK_TYPE_KIND_BASIC;
+    c.builtin_i32->flags   = DK_TYPE_FLAG_INTEGER|DK_TYPE_FLAG_SIGNED;
+    slist_push(&tree->types, c.builtin_i32);
+
     c.builtin_float        = arena_push_struct(c.arena, dk_type);
     c.builtin_float->name  = str("flyder");
     c.builtin_float->size  = 8;
+    c.builtin_float->kind  = DK_TYPE_KIND_BASIC;
     slist_push(&tree->types, c.builtin_float);
 
     c.builtin_bool         = arena_push_struct(c.arena, dk_type);
     c.builtin_bool->name   = str("påstand"); // TODO(rune): Cleanup string contants.
     c.builtin_bool->size   = 1;
+    c.builtin_bool->kind   = DK_TYPE_KIND_BASIC;
     slist_push(&tree->types, c.builtin_bool);
 
+    c.builtin_vec          = arena_push_struct(c.arena, dk_type);
+    c.builtin_vec->name    = str("vektor");
+    c.builtin_vec->size    = sizeof(vec4);
+    c.builtin_vec->kind    = DK_TYPE_KIND_BASIC;
+    slist_push(&tree->types, c.builtin_vec);
+
+    c.builtin_text         = arena_push_struct(c.arena, dk_type);
+    c.builtin_text->name   = str("tekst");
+    c.builtin_text->size   = sizeof(str);
+    c.builtin_text->kind   = DK_TYPE_KIND_BASIC;
+    slist_push(&tree->types, c.builtin_text);
+
+    c.builtin_map          = arena_push_struct(c.arena, dk_type);
+    c.builtin_map->name    = str("ordbog");
+    c.builtin_map->size    = 8;
+    c.builtin_map->kind    = DK_TYPE_KIND_BASIC;
+    c.builtin_map->flags   = DK_TYPE_FLAG_OWNED;
+    slist_push(&tree->types, c.builtin_map);
+
     // NOTE(rune): Special type used be builtin expressions such as "Gem det i A", where "det" and "A" can be any types.
     c.builtin_any         = arena_push_struct(c.arena, dk_type);
     c.builtin_any->name   = str("$any");
     c.builtin_any->size   = 1;
+    c.builtin_any->kind   = DK_TYPE_KIND_BASIC;
     slist_push(&tree->types, c.builtin_any);
 
     // rune: Opcode instrinsics
@@ -1131,6 +2647,49 @@ static void dk_check_tree(dk_tree *tree, arena *arena) {
             { DK_BC_OPCODE_FMUL, STR("gang A:flyder med B:flyder"),         STR("flyder")  },
             { DK_BC_OPCODE_IDIV, STR("del A:heltal med B:heltal"),          STR("heltal")  },
             { DK_BC_OPCODE_FDIV, STR("del A:flyder med B:flyder"),          STR("flyder")  },
+            { DK_BC_OPCODE_MOD,  STR("rest af A:heltal delt med B:heltal"), STR("heltal")  },
+
+            // rune: Math
+            { DK_BC_OPCODE_IABS,   STR("absolut A:heltal"),                     STR("heltal")  },
+            { DK_BC_OPCODE_FABS,   STR("absolut A:flyder"),                     STR("flyder")  },
+            { DK_BC_OPCODE_IMIN,   STR("mindste af A:heltal og B:heltal"),      STR("heltal")  },
+            { DK_BC_OPCODE_FMIN,   STR("mindste af A:flyder og B:flyder"),      STR("flyder")  },
+            { DK_BC_OPCODE_IMAX,   STR("største af A:heltal og B:heltal"),      STR("heltal")  },
+            { DK_BC_OPCODE_FMAX,   STR("største af A:flyder og B:flyder"),      STR("flyder")  },
+            { DK_BC_OPCODE_FSQRT,  STR("kvadratroden af A:flyder"),             STR("flyder")  },
+            { DK_BC_OPCODE_FFLOOR, STR("rund A:flyder ned"),                    STR("flyder")  },
+            { DK_BC_OPCODE_FPOW,   STR("A:flyder opløftet i B:flyder"),         STR("flyder")  },
+
+            // rune: Vector math
+            { DK_BC_OPCODE_VMAKE,  STR("vektor af A:flyder og B:flyder og C:flyder og D:flyder"),  STR("vektor") },
+            { DK_BC_OPCODE_VADD,   STR("læg A:vektor sammen med B:vektor"),                         STR("vektor") },
+            { DK_BC_OPCODE_VMUL,   STR("gang A:vektor med B:vektor"),                               STR("vektor") },
+            { DK_BC_OPCODE_VFMA,   STR("gang A:vektor med B:vektor plus C:vektor"),                 STR("vektor") },
+
+            // rune: Text
+            { DK_BC_OPCODE_TLEN,   STR("længden af A:tekst"),                               STR("heltal")  },
+            { DK_BC_OPCODE_TEQ,    STR("A:tekst er lig med B:tekst"),                       STR("påstand") },
+            { DK_BC_OPCODE_TFIND,  STR("placeringen af A:tekst i B:tekst"),                 STR("heltal")  },
+            { DK_BC_OPCODE_TSLICE, STR("udsnit af A:tekst fra B:heltal til C:heltal"),      STR("tekst")   },
+
+            // rune: Hash map
+            { DK_BC_OPCODE_MAPPUT, STR("gem A:heltal under B:heltal i C:ordbog"),           STR("heltal")  },
+            { DK_BC_OPCODE_MAPGET, STR("værdien under A:heltal i B:ordbog"),                STR("heltal")  },
+            { DK_BC_OPCODE_MAPHAS, STR("A:heltal findes i B:ordbog"),                       STR("påstand") },
+            { DK_BC_OPCODE_MAPDEL, STR("fjern A:heltal fra B:ordbog"),                      STR("påstand") },
+            { DK_BC_OPCODE_MAPLEN, STR("antallet af nøgler i A:ordbog"),                    STR("heltal")  },
+
+            // rune: Input
+            { DK_BC_OPCODE_INI,    STR("læs heltal"),                                       STR("heltal")  },
+            { DK_BC_OPCODE_INF,    STR("læs flyder"),                                       STR("flyder")  },
+            { DK_BC_OPCODE_INMORE, STR("er der mere input"),                                STR("påstand") },
+
+            // rune: Bitwise
+            { DK_BC_OPCODE_BAND, STR("bitvis A:heltal og B:heltal"),                STR("heltal") },
+            { DK_BC_OPCODE_BOR,  STR("bitvis A:heltal eller B:heltal"),             STR("heltal") },
+            { DK_BC_OPCODE_BXOR, STR("bitvis A:heltal eksklusivt eller B:heltal"),  STR("heltal") },
+            { DK_BC_OPCODE_SHL,  STR("skub A:heltal til venstre med B:heltal"),     STR("heltal") },
+            { DK_BC_OPCODE_SHR,  STR("skub A:heltal til højre med B:heltal"),       STR("heltal") },
 
             // rune: Comparison
             { DK_BC_OPCODE_LT,   STR("A:heltal er mindre end B:heltal"),    STR("påstand") },
@@ -1163,7 +2722,58 @@ static void dk_check_tree(dk_tree *tree, arena *arena) {
         func->type_name = c.builtin_int->name;
         func->kind      = DK_FUNC_KIND_ASSIGN;
 
-        slist_push(&tree->funcs, func);
+        slist_push(&tree->funcs, func);
+    }
+    {
+        typedef struct dk_list_func dk_list_func;
+        struct dk_list_func {
+            dk_func_kind kind;
+            str pattern;
+        };
+
+        static readonly dk_list_func list_funcs[] = {
+            { DK_FUNC_KIND_LIST_LOAD,   STR("A:$any på plads B:heltal")         },
+            { DK_FUNC_KIND_LIST_STORE,  STR("gem A:$any på plads B:heltal i C:$any") },
+            { DK_FUNC_KIND_LIST_LENGTH, STR("længden af A:$any")                },
+        };
+
+        for_sarray (dk_list_func, it, list_funcs) {
+            dk_func *func   = arena_push_struct(c.arena, dk_func);
+            func->pattern   = dk_pattern_from_str(it->pattern, c.arena);
+            func->type_name = c.builtin_any->name; // NOTE(rune): Actual type is determined by dk_check_list_access().
+            func->kind      = it->kind;
+
+            slist_push(&tree->funcs, func);
+        }
+    }
+
+    // rune: Bulk operations
+    {
+        typedef struct dk_bulk_intrinsic dk_bulk_intrinsic;
+        struct dk_bulk_intrinsic {
+            dk_bulk_op op;
+            str pattern;
+        };
+
+        static readonly dk_bulk_intrinsic bulk_intrinsics[] = {
+            { DK_BULK_OP_SUM,   STR("summen af A:$any")                     },
+            { DK_BULK_OP_DOT,   STR("prikproduktet af A:$any og B:$any")    },
+            { DK_BULK_OP_MIN,   STR("mindste værdi i A:$any")               },
+            { DK_BULK_OP_MAX,   STR("største værdi i A:$any")               },
+            { DK_BULK_OP_ADD,   STR("læg A:$any til B:$any elementvis")     },
+            { DK_BULK_OP_MUL,   STR("gang A:$any med B:$any elementvis")    },
+            { DK_BULK_OP_SCALE, STR("skaler A:$any med B:$any")             },
+        };
+
+        for_sarray (dk_bulk_intrinsic, it, bulk_intrinsics) {
+            dk_func *func   = arena_push_struct(c.arena, dk_func);
+            func->pattern   = dk_pattern_from_str(it->pattern, c.arena);
+            func->type_name = c.builtin_any->name; // NOTE(rune): Actual type is determined by dk_check_bulk().
+            func->kind      = DK_FUNC_KIND_BULK;
+            func->bulk_op   = it->op;
+
+            slist_push(&tree->funcs, func);
+        }
     }
 
     // rune: Native functions
@@ -1194,24 +2804,75 @@ static void dk_check_tree(dk_tree *tree, arena *arena) {
 
         slist_push(&tree->funcs, func);
     }
+    {
+        dk_func *func   = arena_push_struct(c.arena, dk_func);
+        func->pattern   = dk_pattern_from_str(str("print A:vektor"), c.arena);
+        func->type_name = c.builtin_int->name;
+        func->symbol_id = 0xdeadbeef + 3;
+        func->kind      = DK_FUNC_KIND_NATIVE;
+
+        slist_push(&tree->funcs, func);
+    }
+    {
+        dk_func *func   = arena_push_struct(c.arena, dk_func);
+        func->pattern   = dk_pattern_from_str(str("print A:tekst"), c.arena);
+        func->type_name = c.builtin_int->name;
+        func->symbol_id = 0xdeadbeef + 4;
+        func->kind      = DK_FUNC_KIND_NATIVE;
+
+        slist_push(&tree->funcs, func);
+    }
 
     // rune: Types
     for_list (dk_type, type, tree->types) {
-        if (dk_global_err->err_list.count > 0) break;
+        if (ctx->err->err_list.count > 0) break;
 
-        // TODO(rune): Type check types
+        dk_layout_type(&c, type);
     }
 
+    // rune: Globals
+    dk_check_globals(&c, tree->globals);
+
     // rune: Check functions signatures
     for_list (dk_func, func, tree->funcs) {
-        if (dk_global_err->err_list.count > 0) break;
+        if (ctx->err->err_list.count > 0) break;
         dk_check_func_sig(&c, func);
     }
 
     // rune: Check functions statements
-    for_list (dk_func, func, tree->funcs) {
-        if (dk_global_err->err_list.count > 0) break;
-        dk_check_func_body(&c, func);
+    if (ctx->err->err_list.count == 0) {
+        i64 func_count  = 0;
+        dk_func **funcs = dk_user_func_array_from_list(tree->funcs, &func_count, c.arena);
+
+        i64 job_count = (func_count + DK_FUNCS_PER_JOB - 1) / DK_FUNCS_PER_JOB;
+        dk_check_job *jobs = arena_push_array(c.arena, dk_check_job, job_count);
+        for_n (i64, i, job_count) {
+            jobs[i].ctx.err    = &jobs[i].err;
+            jobs[i].ctx.arena  = arena_create_default();
+            jobs[i].ctx.jobs   = ctx->jobs;
+            jobs[i].c          = c;
+            jobs[i].c.arena    = jobs[i].ctx.arena;
+            jobs[i].c.ctx      = &jobs[i].ctx;
+            jobs[i].funcs      = funcs + i * DK_FUNCS_PER_JOB;
+            jobs[i].func_count = min(DK_FUNCS_PER_JOB, func_count - i * DK_FUNCS_PER_JOB);
+        }
+
+        dk_run_jobs(ctx->jobs, dk_check_job_proc, jobs, sizeof(dk_check_job), job_count);
+
+        // rune: Same errors as checking serially, which stops at the first function with errors.
+        for_n (i64, i, job_count) {
+            if (ctx->err->err_list.count == 0) {
+                for (dk_err *err = jobs[i].err.err_list.first; err; err = err->next) {
+                    dk_report_err(ctx, err->loc, err->msg);
+                }
+            }
+            arena_adopt(c.arena, jobs[i].ctx.arena);
+        }
+    }
+
+    // rune: Calls from Samtidig loops
+    if (ctx->err->err_list.count == 0) {
+        dk_check_pfor_calls(&c, tree->funcs);
     }
 
 #if DK_DEBUG_PRINT_CHECK
@@ -1231,6 +2892,9 @@ static void *dk_buffer_push(dk_buffer *buffer, i64 size) {
         if (next_size == 0) {
             next_size = kilobytes(4);
         }
+        while (next_size < buffer->size + size) {
+            next_size *= 2;
+        }
 
         buffer->data = heap_realloc(buffer->data, next_size);
         buffer->capacity = next_size;
@@ -1294,7 +2958,7 @@ static void dk_emit_inst1(dk_emitter *e, dk_bc_opcode opcode) {
     assert(dk_bc_opcode_infos[opcode].operand_kind == DK_BC_OPERAND_KIND_NONE);
 
     dk_bc_inst_prefix prefix = { .opcode = opcode };
-    dk_emit_u8(e, prefix.u8);
+    dk_emit_u16(e, prefix.u16);
 }
 
 static void dk_emit_inst2(dk_emitter *e, dk_bc_opcode opcode, u64 operand) {
@@ -1303,36 +2967,211 @@ static void dk_emit_inst2(dk_emitter *e, dk_bc_opcode opcode, u64 operand) {
     dk_bc_inst_prefix prefix = { .opcode = opcode };
     if (operand <= U8_MAX) {
         prefix.operand_size = 0;
-        dk_emit_u8(e, prefix.u8);
+        dk_emit_u16(e, prefix.u16);
         dk_emit_u8(e, (u8)operand);
     } else if (operand <= U16_MAX) {
         prefix.operand_size = 1;
-        dk_emit_u8(e, prefix.u8);
+        dk_emit_u16(e, prefix.u16);
         dk_emit_u16(e, (u16)operand);
     } else if (operand <= U32_MAX) {
         prefix.operand_size = 2;
-        dk_emit_u8(e, prefix.u8);
+        dk_emit_u16(e, prefix.u16);
         dk_emit_u32(e, (u32)operand);
     } else {
         prefix.operand_size = 3;
-        dk_emit_u8(e, prefix.u8);
+        dk_emit_u16(e, prefix.u16);
         dk_emit_u64(e, (u64)operand);
     }
 }
 
-static void dk_emit_symbol(dk_emitter *e, u32 id, u32 size) {
+// NOTE(rune): Emits a jump instruction with a 64-bit placeholder operand, and returns the position of the operand,
+// so it can be patched with dk_patch_jump() once the jump target is known. We store a position, and not a pointer,
+// because the body buffer may be reallocated while emitting the code in between.
+static i64 dk_emit_jump(dk_emitter *e, dk_bc_opcode opcode) {
+    assert(dk_bc_opcode_infos[opcode].operand_kind == DK_BC_OPERAND_KIND_POS);
+
+    dk_bc_inst_prefix prefix = { .opcode = opcode, .operand_size = 3 };
+    dk_emit_u16(e, prefix.u16);
+    i64 operand_pos = e->body.size;
+    dk_emit_u64(e, U64_MAX);
+    dk_emit_reloc(e, operand_pos);
+    return operand_pos;
+}
+
+static void dk_patch_jump(dk_emitter *e, i64 operand_pos, i64 target) {
+    *dk_buffer_get_u64(&e->body, operand_pos) = target;
+}
+
+// NOTE(rune): Marks a u64 in the body, which holds a position in the body, so it can be moved by dk_emitter_append().
+static void dk_emit_reloc(dk_emitter *e, i64 pos) {
+    dk_buffer_push_u64(&e->relocs, pos);
+}
+
+// NOTE(rune): Appends the body and symbols of src to e, moves all positions by the size of e's body, and frees src.
+static void dk_emitter_append(dk_emitter *e, dk_emitter *src) {
+    i64 base = e->body.size;
+
+    // rune: Body
+    if (src->body.size > 0) {
+        memcpy(dk_buffer_push(&e->body, src->body.size), src->body.data, src->body.size);
+    }
+
+    // rune: Positions in body
+    for (i64 off = 0; off < src->relocs.size; off += sizeof(u64)) {
+        i64 pos = base + i64(*dk_buffer_get_u64(&src->relocs, off));
+        *dk_buffer_get_u64(&e->body, pos) += base;
+        dk_emit_reloc(e, pos);
+    }
+
+    // rune: Symbols
+    for (i64 off = 0; off < src->head.size; off += sizeof(dk_bc_symbol)) {
+        dk_bc_symbol *symbol = dk_buffer_push_struct(&e->head, dk_bc_symbol);
+        *symbol = *(dk_bc_symbol *)dk_buffer_get(&src->head, off, sizeof(dk_bc_symbol));
+        symbol->pos += base;
+    }
+
+    heap_free(src->head.data);
+    heap_free(src->body.data);
+    heap_free(src->relocs.data);
+    mem_zero_struct(src);
+}
+
+static void dk_emit_symbol(dk_emitter *e, dk_func *func) {
     dk_bc_symbol *symbol = dk_buffer_push_struct(&e->head, dk_bc_symbol);
-    symbol->id   = id;
-    symbol->size = size;
+    symbol->id   = func->symbol_id;
+    symbol->size = func->frame_size;
     symbol->pos  = e->body.size;
+    symbol->name = func->token->text;
+    symbol->row  = func->token->loc.row;
+
+    symbol->signature = func->signature;
+    symbol->arg_slots = func->arg_slots;
+    symbol->ret_slots = dk_slot_count_from_type(func->type);
+    symbol->type_name = func->type->name;
+    symbol->arg_types = func->arg_types;
+    symbol->arg_count = func->arg_count;
 }
 
 static void dk_emit_literal(dk_emitter *e, dk_literal literal) {
-    switch (literal.kind) {
-        case DK_LITERAL_KIND_INT:   dk_emit_inst2(e, DK_BC_OPCODE_LDI, u64(literal.int_));             break;
-        case DK_LITERAL_KIND_FLOAT: dk_emit_inst2(e, DK_BC_OPCODE_LDI, u64_from_f64(literal.float_));    break;
-        case DK_LITERAL_KIND_BOOL:  dk_emit_inst2(e, DK_BC_OPCODE_LDI, u64(literal.bool_));            break;
-        default:                    assert(false && "Not implemented.");                               break;
+    if (literal.kind == DK_LITERAL_KIND_TEXT) {
+        dk_emit_inst2(e, DK_BC_OPCODE_LDI, u64(literal.text_.v));
+        dk_emit_inst2(e, DK_BC_OPCODE_LDI, u64(literal.text_.len));
+    } else {
+        dk_emit_inst2(e, DK_BC_OPCODE_LDI, dk_u64_from_literal(literal));
+    }
+}
+
+// NOTE(rune): Local offset of a local, or a field of a record local.
+static i64 dk_local_off_from_expr(dk_expr *expr) {
+    i64 ret = 0;
+    if (expr->kind == DK_EXPR_KIND_FIELD) {
+        ret = expr->func_args.first->local->off + expr->field->off / 8;
+    } else {
+        assert(expr->kind == DK_EXPR_KIND_LOCAL); // TODO(rune): Better lvalue handling
+        ret = expr->local->off;
+    }
+    return ret;
+}
+
+// NOTE(rune): Byte offset in the frame of a packed field of a record local.
+static i64 dk_local_byte_off_from_expr(dk_expr *expr) {
+    assert(expr->kind == DK_EXPR_KIND_FIELD);
+    return expr->func_args.first->local->off * 8 + expr->field->off;
+}
+
+// NOTE(rune): Operand of ldf/stf for a field of a record in a list, or of ldf8/stf8 etc. for a packed list element
+// or packed field. Start and stride are computed in bytes, and converted to slots for the slot sized instructions.
+static u64 dk_field_operand_from_expr(dk_expr *expr) {
+    dk_type *list = expr->func_args.first->type;
+    i64 start  = 0;
+    i64 stride = 0;
+    if (expr->kind == DK_EXPR_KIND_INDEX) {
+        stride = list->elem->size;
+    } else if (list->flags & DK_TYPE_FLAG_SOA) {
+        start  = expr->field->off * list->count;
+        stride = expr->field->type->size;
+    } else {
+        start  = expr->field->off;
+        stride = list->elem->size;
+    }
+
+    if (!dk_type_is_packed(expr->type)) {
+        start  /= 8;
+        stride /= 8;
+    }
+
+    return dk_field_operand(expr->func_args.first->local->off, start, stride, (expr->flags & DK_EXPR_FLAG_UNCHECKED) != 0);
+}
+
+// NOTE(rune): Width specific variant of ldl8/stl8/ldf8/stf8/sext8 for a packed type.
+static dk_bc_opcode dk_packed_opcode(dk_bc_opcode op8, dk_type *type) {
+    i64 ret = op8;
+    if (type->size == 2) ret += 1;
+    if (type->size == 4) ret += 2;
+    return (dk_bc_opcode)ret;
+}
+
+// NOTE(rune): Returns the trapping variant of an integer arithmetic opcode, or nop if it has none.
+static dk_bc_opcode dk_checked_opcode(dk_bc_opcode opcode) {
+    dk_bc_opcode ret = DK_BC_OPCODE_NOP;
+    switch (opcode) {
+        case DK_BC_OPCODE_ADD:  ret = DK_BC_OPCODE_ADDC;  break;
+        case DK_BC_OPCODE_SUB:  ret = DK_BC_OPCODE_SUBC;  break;
+        case DK_BC_OPCODE_IMUL: ret = DK_BC_OPCODE_IMULC; break;
+        case DK_BC_OPCODE_IDIV: ret = DK_BC_OPCODE_IDIVC; break;
+        case DK_BC_OPCODE_MOD:  ret = DK_BC_OPCODE_MODC;  break;
+        default:                                          break;
+    }
+    return ret;
+}
+
+// NOTE(rune): Wraps the value on top of the stack to the range of a narrow integer type.
+static void dk_emit_wrap(dk_emitter *e, dk_type *type) {
+    if (dk_type_is_int(type) && type->size < 8) {
+        if (type->flags & DK_TYPE_FLAG_SIGNED) {
+            dk_emit_inst1(e, dk_packed_opcode(DK_BC_OPCODE_SEXT8, type));
+        } else {
+            assert(type->size == 1);
+            dk_emit_inst1(e, DK_BC_OPCODE_ZEXT8);
+        }
+    }
+}
+
+// NOTE(rune): Packed loads zero extend, so signed values are sign extended after loading.
+static void dk_emit_packed_load(dk_emitter *e, dk_bc_opcode op8, dk_type *type, u64 operand) {
+    dk_emit_inst2(e, dk_packed_opcode(op8, type), operand);
+    if (type->flags & DK_TYPE_FLAG_SIGNED) {
+        dk_emit_wrap(e, type);
+    }
+}
+
+// NOTE(rune): Maps owned by the function's locals are freed before returning. Arguments are borrowed from the caller.
+static void dk_emit_ret(dk_emitter *e) {
+    for_list (dk_local, local, e->func->locals) {
+        if ((local->type->flags & DK_TYPE_FLAG_OWNED) && !(local->flags & DK_LOCAL_FLAG_ARG)) {
+            dk_emit_inst2(e, DK_BC_OPCODE_MAPFREE, local->off);
+        }
+    }
+    dk_emit_inst1(e, DK_BC_OPCODE_RET);
+}
+
+static void dk_emit_pop(dk_emitter *e, dk_type *type) {
+    for_n (i64, i, dk_slot_count_from_type(type)) {
+        dk_emit_inst1(e, DK_BC_OPCODE_POP);
+    }
+}
+
+// NOTE(rune): Arguments are pushed left to right, so they are popped into their locals from the last argument,
+// and the last slot of each argument.
+static void dk_emit_store_args(dk_emitter *e, dk_local *local) {
+    if (local) {
+        dk_emit_store_args(e, local->next);
+        if (local->flags & DK_LOCAL_FLAG_ARG) {
+            dk_emit_wrap(e, local->type);
+            for (i64 i = dk_slot_count_from_type(local->type) - 1; i >= 0; i--) {
+                dk_emit_inst2(e, DK_BC_OPCODE_STL, local->off + i);
+            }
+        }
     }
 }
 
@@ -1341,8 +3180,8 @@ static void dk_emit_expr(dk_emitter *e, dk_expr *expr) {
         case DK_EXPR_KIND_LIST: {
             for_list (dk_expr, subexpr, expr->list) {
                 dk_emit_expr(e, subexpr);
-                if (subexpr != expr->list.last && subexpr->type->size > 0) {
-                    dk_emit_inst1(e, DK_BC_OPCODE_POP);
+                if (subexpr != expr->list.last) {
+                    dk_emit_pop(e, subexpr->type);
                 }
             }
         } break;
@@ -1352,7 +3191,35 @@ static void dk_emit_expr(dk_emitter *e, dk_expr *expr) {
         } break;
 
         case DK_EXPR_KIND_LOCAL: {
-            dk_emit_inst2(e, DK_BC_OPCODE_LDL, expr->local->off);
+            for_n (i64, i, dk_slot_count_from_type(expr->type)) {
+                dk_emit_inst2(e, DK_BC_OPCODE_LDL, expr->local->off + i);
+            }
+        } break;
+
+        case DK_EXPR_KIND_GLOBAL: {
+            for_n (i64, i, dk_slot_count_from_type(expr->type)) {
+                dk_emit_inst2(e, DK_BC_OPCODE_LDG, expr->local->off + i);
+            }
+        } break;
+
+        case DK_EXPR_KIND_FIELD: {
+            if (expr->func_args.first == expr->func_args.last) {
+                if (dk_type_is_packed(expr->type)) {
+                    dk_emit_packed_load(e, DK_BC_OPCODE_LDL8, expr->type, dk_local_byte_off_from_expr(expr));
+                } else {
+                    i64 off = dk_local_off_from_expr(expr);
+                    for_n (i64, i, dk_slot_count_from_type(expr->type)) {
+                        dk_emit_inst2(e, DK_BC_OPCODE_LDL, off + i);
+                    }
+                }
+            } else {
+                dk_emit_expr(e, expr->func_args.last);
+                if (dk_type_is_packed(expr->type)) {
+                    dk_emit_packed_load(e, DK_BC_OPCODE_LDF8, expr->type, dk_field_operand_from_expr(expr));
+                } else {
+                    dk_emit_inst2(e, DK_BC_OPCODE_LDF, dk_field_operand_from_expr(expr));
+                }
+            }
         } break;
 
         case DK_EXPR_KIND_FUNC: {
@@ -1361,7 +3228,11 @@ static void dk_emit_expr(dk_emitter *e, dk_expr *expr) {
             }
 
             dk_func *func = expr->func;
-            if (func->kind == DK_FUNC_KIND_OPCODE) {
+            dk_bc_opcode checked = dk_checked_opcode(func->opcode);
+            if (func->kind == DK_FUNC_KIND_OPCODE && checked != DK_BC_OPCODE_NOP && !(e->flags & DK_BUILD_FLAG_UNCHECKED)) {
+                dk_loc loc = expr->token->loc;
+                dk_emit_inst2(e, checked, dk_src_operand(loc.row + 1, loc.col + 1));
+            } else if (func->kind == DK_FUNC_KIND_OPCODE) {
                 assert(dk_bc_opcode_infos[func->opcode].operand_kind == DK_BC_OPERAND_KIND_NONE);
                 dk_emit_inst1(e, func->opcode);
             } else {
@@ -1373,11 +3244,87 @@ static void dk_emit_expr(dk_emitter *e, dk_expr *expr) {
             dk_expr *rvalue = expr->func_args.first;
             dk_expr *lvalue = expr->func_args.last;
 
-            assert(lvalue->kind == DK_EXPR_KIND_LOCAL); // TODO(rune): Better lvalue handling
-
             dk_emit_expr(e, rvalue);
-            dk_emit_inst1(e, DK_BC_OPCODE_DUP); // TODO(rune): When we have void type, we don't need this dup instruction.
-            dk_emit_inst2(e, DK_BC_OPCODE_STL, lvalue->local->off);
+
+            i64 slot_count = dk_slot_count_from_type(lvalue->type);
+            if (lvalue->kind == DK_EXPR_KIND_GLOBAL) {
+                // rune: Globals are stored like locals, but in the data segment.
+                dk_emit_wrap(e, lvalue->type);
+                if (slot_count > 1) {
+                    for (i64 i = slot_count - 1; i >= 0; i--) {
+                        dk_emit_inst2(e, DK_BC_OPCODE_STG, lvalue->local->off + i);
+                    }
+                    dk_emit_inst2(e, DK_BC_OPCODE_LDI, 0); // NOTE(rune): Assignments are typed as heltal.
+                } else {
+                    dk_emit_inst1(e, DK_BC_OPCODE_DUP); // TODO(rune): When we have void type, we don't need this dup instruction.
+                    dk_emit_inst2(e, DK_BC_OPCODE_STG, lvalue->local->off);
+                }
+            } else if (slot_count > 1) {
+                // rune: Multi-slot values e.g. vektor, are stored last slot first.
+                i64 off = dk_local_off_from_expr(lvalue);
+                for (i64 i = slot_count - 1; i >= 0; i--) {
+                    dk_emit_inst2(e, DK_BC_OPCODE_STL, off + i);
+                }
+                dk_emit_inst2(e, DK_BC_OPCODE_LDI, 0); // NOTE(rune): Assignments are typed as heltal.
+            } else if (lvalue->kind == DK_EXPR_KIND_INDEX) {
+                dk_emit_inst1(e, DK_BC_OPCODE_DUP); // TODO(rune): When we have void type, we don't need this dup instruction.
+                dk_expr *list  = lvalue->func_args.first;
+                dk_expr *index = lvalue->func_args.last;
+                dk_emit_expr(e, index);
+                if (dk_type_is_packed(lvalue->type)) {
+                    dk_emit_inst2(e, dk_packed_opcode(DK_BC_OPCODE_STF8, lvalue->type), dk_field_operand_from_expr(lvalue));
+                } else {
+                    dk_emit_inst2(e, (lvalue->flags & DK_EXPR_FLAG_UNCHECKED) ? DK_BC_OPCODE_STXU : DK_BC_OPCODE_STX, list->local->off);
+                }
+            } else if (lvalue->kind == DK_EXPR_KIND_FIELD && lvalue->func_args.first != lvalue->func_args.last) {
+                dk_emit_inst1(e, DK_BC_OPCODE_DUP); // TODO(rune): When we have void type, we don't need this dup instruction.
+                dk_emit_expr(e, lvalue->func_args.last);
+                if (dk_type_is_packed(lvalue->type)) {
+                    dk_emit_inst2(e, dk_packed_opcode(DK_BC_OPCODE_STF8, lvalue->type), dk_field_operand_from_expr(lvalue));
+                } else {
+                    dk_emit_inst2(e, DK_BC_OPCODE_STF, dk_field_operand_from_expr(lvalue));
+                }
+            } else if (lvalue->kind == DK_EXPR_KIND_FIELD && dk_type_is_packed(lvalue->type)) {
+                dk_emit_inst1(e, DK_BC_OPCODE_DUP); // TODO(rune): When we have void type, we don't need this dup instruction.
+                dk_emit_inst2(e, dk_packed_opcode(DK_BC_OPCODE_STL8, lvalue->type), dk_local_byte_off_from_expr(lvalue));
+            } else {
+                dk_emit_wrap(e, lvalue->type);
+                dk_emit_inst1(e, DK_BC_OPCODE_DUP); // TODO(rune): When we have void type, we don't need this dup instruction.
+                dk_emit_inst2(e, DK_BC_OPCODE_STL, dk_local_off_from_expr(lvalue));
+            }
+        } break;
+
+        case DK_EXPR_KIND_INDEX: {
+            dk_expr *list  = expr->func_args.first;
+            dk_expr *index = expr->func_args.last;
+            dk_emit_expr(e, index);
+            if (dk_type_is_packed(expr->type)) {
+                dk_emit_packed_load(e, DK_BC_OPCODE_LDF8, expr->type, dk_field_operand_from_expr(expr));
+            } else {
+                dk_emit_inst2(e, (expr->flags & DK_EXPR_FLAG_UNCHECKED) ? DK_BC_OPCODE_LDXU : DK_BC_OPCODE_LDX, list->local->off);
+            }
+        } break;
+
+        case DK_EXPR_KIND_BULK: {
+            dk_expr *dst = expr->func_args.first;
+            dk_expr *src = dst->next;
+            dk_bulk_op op = expr->func->bulk_op;
+
+            u64 src_off = 0;
+            if (op == DK_BULK_OP_SCALE) {
+                dk_emit_expr(e, src);
+            } else if (src) {
+                src_off = src->local->off;
+            }
+
+            u64 operand = dk_bulk_operand(expr->bulk_kernel, dst->local->off, src_off);
+            if (dk_bulk_kernel_can_overflow(expr->bulk_kernel) && !(e->flags & DK_BUILD_FLAG_UNCHECKED)) {
+                dk_loc loc = expr->token->loc;
+                dk_emit_inst2(e, DK_BC_OPCODE_LDI, dk_src_operand(loc.row + 1, loc.col + 1));
+                operand |= DK_BULK_OPERAND_CHECKED;
+            }
+
+            dk_emit_inst2(e, DK_BC_OPCODE_BULK, operand);
         } break;
 
         default: {
@@ -1386,6 +3333,144 @@ static void dk_emit_expr(dk_emitter *e, dk_expr *expr) {
     }
 }
 
+static void dk_emit_switch(dk_emitter *e, dk_stmt *stmt) {
+    // rune: Find label range.
+    i64 label_count = 0;
+    i64 label_min   = I64_MAX;
+    i64 label_max   = I64_MIN;
+    for_list (dk_stmt, case_, stmt->then) {
+        for_list (dk_expr, label, case_->labels) {
+            label_min = min(label_min, label->literal.int_);
+            label_max = max(label_max, label->literal.int_);
+            label_count += 1;
+        }
+    }
+
+    // rune: Use a dense table when the labels are compact enough, that the holes don't waste too much space.
+    dk_bc_switch_kind kind = DK_BC_SWITCH_KIND_SPARSE;
+    u64 entry_count = label_count;
+    // NOTE(rune): The span is compared before adding one, since the full range of heltal doesn't fit in a u64.
+    if (label_count > 0) {
+        u64 span = u64(label_max) - u64(label_min);
+        if (span < 4096 && span + 1 <= u64(label_count) * 2) {
+            kind = DK_BC_SWITCH_KIND_DENSE;
+            entry_count = span + 1;
+        }
+    }
+
+    // rune: Instruction and table header.
+    dk_emit_expr(e, stmt->expr);
+    dk_emit_inst2(e, DK_BC_OPCODE_SWITCH, entry_count);
+
+    i64 header_pos = e->body.size;
+    dk_bc_switch_header *header = dk_buffer_push_struct(&e->body, dk_bc_switch_header);
+    header->kind        = kind;
+    header->min         = label_min;
+    header->default_pos = U64_MAX;
+
+    i64 entries_pos = e->body.size;
+    for_n (u64, i, entry_count) {
+        dk_bc_switch_entry *entry = dk_buffer_push_struct(&e->body, dk_bc_switch_entry);
+        entry->key = kind == DK_BC_SWITCH_KIND_DENSE ? label_min + i64(i) : I64_MAX;
+        entry->pos = U64_MAX;
+    }
+
+    // rune: Case bodies.
+    dk_buffer end_jumps = { 0 };
+    i64 sparse_count = 0;
+    for_list (dk_stmt, case_, stmt->then) {
+        for_list (dk_expr, label, case_->labels) {
+            i64 key = label->literal.int_;
+            dk_bc_switch_entry *entry = null;
+            if (kind == DK_BC_SWITCH_KIND_DENSE) {
+                entry = dk_buffer_get(&e->body, entries_pos + (key - label_min) * isizeof(dk_bc_switch_entry), sizeof(dk_bc_switch_entry));
+            } else {
+                // NOTE(rune): Insertion sort, since the runtime does binary search over the keys.
+                dk_bc_switch_entry *entries = dk_buffer_get(&e->body, entries_pos, entry_count * sizeof(dk_bc_switch_entry));
+                i64 i = sparse_count++;
+                while (i > 0 && entries[i - 1].key > key) {
+                    entries[i] = entries[i - 1];
+                    i--;
+                }
+                entry = &entries[i];
+                entry->key = key;
+            }
+            entry->pos = e->body.size;
+        }
+
+        dk_emit_stmt_list(e, case_->then);
+        dk_buffer_push_u64(&end_jumps, dk_emit_jump(e, DK_BC_OPCODE_JMP));
+    }
+
+    // rune: Default body, and holes in the dense table.
+    i64 default_pos = e->body.size;
+    header = dk_buffer_get(&e->body, header_pos, sizeof(dk_bc_switch_header));
+    header->default_pos = default_pos;
+    dk_emit_reloc(e, header_pos + offsetof(dk_bc_switch_header, default_pos));
+    for_n (u64, i, entry_count) {
+        i64 entry_pos = entries_pos + i * sizeof(dk_bc_switch_entry);
+        dk_bc_switch_entry *entry = dk_buffer_get(&e->body, entry_pos, sizeof(dk_bc_switch_entry));
+        if (entry->pos == U64_MAX) {
+            entry->pos = default_pos;
+        }
+        dk_emit_reloc(e, entry_pos + offsetof(dk_bc_switch_entry, pos));
+    }
+
+    dk_emit_stmt_list(e, stmt->else_);
+
+    for_n (i64, i, end_jumps.size / isizeof(u64)) {
+        dk_patch_jump(e, *dk_buffer_get_u64(&end_jumps, i * sizeof(u64)), e->body.size);
+    }
+    heap_free(end_jumps.data);
+}
+
+// NOTE(rune): The body loops over one chunk, from the index to the end local, and returns to dk_vm_pfor_run() when
+// the chunk is done. Maps are not freed by the ret, since the frame is a copy of the caller's.
+static void dk_emit_pfor(dk_emitter *e, dk_stmt *stmt) {
+    dk_emit_expr(e, stmt->expr);
+    dk_emit_expr(e, stmt->end_expr);
+    i64 end_pos = dk_emit_jump(e, DK_BC_OPCODE_PFOR);
+
+    // rune: Header and reductions.
+    i64 reduction_count = 0;
+    for (dk_reduction *reduction = stmt->reductions; reduction; reduction = reduction->next) {
+        reduction_count += 1;
+    }
+
+    dk_bc_pfor_header *header = dk_buffer_push_struct(&e->body, dk_bc_pfor_header);
+    header->index_off       = stmt->index->off;
+    header->end_off         = stmt->index_end->off;
+    header->reduction_count = reduction_count;
+
+    for (dk_reduction *reduction = stmt->reductions; reduction; reduction = reduction->next) {
+        dk_bc_pfor_reduction *entry = dk_buffer_push_struct(&e->body, dk_bc_pfor_reduction);
+        entry->off    = reduction->local->off;
+        entry->opcode = reduction->opcode;
+        if (reduction->opcode == DK_BC_OPCODE_ADD && !(e->flags & DK_BUILD_FLAG_UNCHECKED)) {
+            entry->src = dk_src_operand(reduction->loc.row + 1, reduction->loc.col + 1);
+        }
+    }
+
+    // rune: Body
+    i64 body_pos = e->body.size;
+    dk_emit_stmt_list(e, stmt->then);
+
+    dk_emit_inst2(e, DK_BC_OPCODE_LDL, stmt->index->off);
+    dk_emit_inst2(e, DK_BC_OPCODE_LDL, stmt->index_end->off);
+    dk_emit_inst1(e, DK_BC_OPCODE_LT);
+    i64 next_pos = dk_emit_jump(e, DK_BC_OPCODE_BR);
+    dk_emit_inst1(e, DK_BC_OPCODE_RET);
+
+    dk_patch_jump(e, next_pos, e->body.size);
+    dk_emit_inst2(e, DK_BC_OPCODE_LDL, stmt->index->off);
+    dk_emit_inst2(e, DK_BC_OPCODE_LDI, 1);
+    dk_emit_inst1(e, DK_BC_OPCODE_ADD);
+    dk_emit_inst2(e, DK_BC_OPCODE_STL, stmt->index->off);
+    dk_patch_jump(e, dk_emit_jump(e, DK_BC_OPCODE_JMP), body_pos);
+
+    dk_patch_jump(e, end_pos, e->body.size);
+}
+
 static void dk_emit_stmt_list(dk_emitter *e, dk_stmt_list stmts) {
     for_list (dk_stmt, stmt, stmts) {
         switch (stmt->kind) {
@@ -1394,75 +3479,52 @@ static void dk_emit_stmt_list(dk_emitter *e, dk_stmt_list stmts) {
                 // TODO(rune): Initialization expression
             } break;
 
+            case DK_STMT_KIND_CONST: {
+                // NOTE(rune): Nothing, since uses of the constant are replaced by its literal.
+            } break;
+
             case DK_STMT_KIND_EXPR: {
                 dk_emit_expr(e, stmt->expr);
-
-                if (stmt->expr->type->size > 0) {
-                    dk_emit_inst1(e, DK_BC_OPCODE_POP);
-                }
+                dk_emit_pop(e, stmt->expr->type);
             } break;
 
             case DK_STMT_KIND_RETURN: {
                 dk_emit_expr(e, stmt->expr);
-                dk_emit_inst1(e, DK_BC_OPCODE_RET);
+                dk_emit_wrap(e, e->func->type);
+                dk_emit_ret(e);
             } break;
 
             case DK_STMT_KIND_IF: {
                 dk_emit_expr(e, stmt->expr);
                 dk_emit_inst1(e, DK_BC_OPCODE_NOT);
-
-                // TODO(rune): This whole business is a hack.
-                // TODO(rune): This whole business is a hack.
-                // TODO(rune): This whole business is a hack.
-
-                dk_bc_inst_prefix prefix = {
-                    .opcode = DK_BC_OPCODE_BR,
-                    .operand_size = 3, // NOTE(rune): 64-bits
-                };
-                dk_emit_u8(e, prefix.u8);
-                u64 *else_pos = dk_emit_u64(e, U64_MAX);
+                i64 else_pos = dk_emit_jump(e, DK_BC_OPCODE_BR);
 
                 dk_emit_stmt_list(e, stmt->then);
+                i64 end_pos = dk_emit_jump(e, DK_BC_OPCODE_JMP);
 
-                dk_emit_inst2(e, DK_BC_OPCODE_LDI, 1);
-                dk_bc_inst_prefix prefix2 = {
-                    .opcode = DK_BC_OPCODE_BR,
-                    .operand_size = 3, // NOTE(rune): 64-bits
-                };
-                dk_emit_u8(e, prefix2.u8);
-
-                u64 *end_pos = dk_emit_u64(e, U64_MAX);
-
-                *else_pos = e->body.size;
-
+                dk_patch_jump(e, else_pos, e->body.size);
                 dk_emit_stmt_list(e, stmt->else_);
-
-                *end_pos = e->body.size;
+                dk_patch_jump(e, end_pos, e->body.size);
             } break;
 
             case DK_STMT_KIND_WHILE: {
                 i64 start_pos = e->body.size;
                 dk_emit_expr(e, stmt->expr);
                 dk_emit_inst1(e, DK_BC_OPCODE_NOT);
-
-                // TODO(rune): This whole business is a hack.
-                // TODO(rune): This whole business is a hack.
-                // TODO(rune): This whole business is a hack.
-
-                dk_bc_inst_prefix prefix = {
-                    .opcode = DK_BC_OPCODE_BR,
-                    .operand_size = 3, // NOTE(rune): 64-bits
-                };
-
-                dk_emit_u8(e, prefix.u8);
-                u64 *end_pos = dk_emit_u64(e, U64_MAX);
+                i64 end_pos = dk_emit_jump(e, DK_BC_OPCODE_BR);
 
                 dk_emit_stmt_list(e, stmt->then);
+                dk_patch_jump(e, dk_emit_jump(e, DK_BC_OPCODE_JMP), start_pos);
+
+                dk_patch_jump(e, end_pos, e->body.size);
+            } break;
 
-                dk_emit_inst2(e, DK_BC_OPCODE_LDI, 1); // TODO(rune): Unconditional jump opcode.
-                dk_emit_inst2(e, DK_BC_OPCODE_BR, start_pos);
+            case DK_STMT_KIND_SWITCH: {
+                dk_emit_switch(e, stmt);
+            } break;
 
-                *end_pos = e->body.size;
+            case DK_STMT_KIND_PFOR: {
+                dk_emit_pfor(e, stmt);
             } break;
 
             default: {
@@ -1472,31 +3534,87 @@ static void dk_emit_stmt_list(dk_emitter *e, dk_stmt_list stmts) {
     }
 }
 
+static void dk_emit_func(dk_emitter *e, dk_func *func) {
+    e->func = func;
+    dk_emit_symbol(e, func);
+
+    // rune: Prelude
+    dk_emit_store_args(e, func->locals.first);
+
+    // rune: List lengths
+    for_list (dk_local, local, func->locals) {
+        if (local->type->kind == DK_TYPE_KIND_LIST) {
+            dk_emit_inst2(e, DK_BC_OPCODE_LDI, local->type->count);
+            dk_emit_inst2(e, DK_BC_OPCODE_STL, local->off);
+        }
+    }
+
+    // rune: Owned objects
+    for_list (dk_local, local, func->locals) {
+        if ((local->type->flags & DK_TYPE_FLAG_OWNED) && !(local->flags & DK_LOCAL_FLAG_ARG)) {
+            dk_emit_inst2(e, DK_BC_OPCODE_MAPNEW, local->off);
+        }
+    }
+
+    // rune: Function body
+    dk_emit_stmt_list(e, func->stmts);
+
+    // rune: Epilogue
+    for_n (i64, i, dk_slot_count_from_type(func->type)) {
+        dk_emit_inst2(e, DK_BC_OPCODE_LDI, 0);
+    }
+    dk_emit_ret(e);
+}
+
+static void dk_emit_job_proc(void *param) {
+    dk_emit_job *job = param;
+    for_n (i64, i, job->func_count) {
+        if (job->funcs[i]->kind == DK_FUNC_KIND_USER) {
+            dk_emit_func(&job->e, job->funcs[i]);
+        }
+    }
+}
+
 static void dk_emit_tree(dk_emitter *e, dk_tree *tree) {
+    if (e->ctx->err->err_list.count > 0) {
+        return;
+    }
+
+    // rune: Only user functions have bodies.
+    i64 func_count = 0;
     for_list (dk_func, func, tree->funcs) {
-        if (dk_global_err->err_list.count > 0) break;
+        if (func->kind == DK_FUNC_KIND_USER) {
+            func_count++;
+        }
+    }
 
+    dk_func **funcs = heap_alloc(sizeof(dk_func *) * max(func_count, 1));
+    i64 i = 0;
+    for_list (dk_func, func, tree->funcs) {
         if (func->kind == DK_FUNC_KIND_USER) {
-            dk_emit_symbol(e, func->symbol_id, 0);
+            funcs[i++] = func;
+        }
+    }
 
-            // rune: Prelude
-            for_list (dk_local, local, func->locals) {
-                if (local->flags & DK_LOCAL_FLAG_ARG) {
-                    dk_emit_inst2(e, DK_BC_OPCODE_STL, local->off);
-                }
-            }
+    i64 job_count = (func_count + DK_FUNCS_PER_JOB - 1) / DK_FUNCS_PER_JOB;
+    dk_emit_job *jobs = heap_alloc(sizeof(dk_emit_job) * max(job_count, 1));
+    mem_zero_size(jobs, sizeof(dk_emit_job) * max(job_count, 1));
+    for_n (i64, j, job_count) {
+        jobs[j].e.flags    = e->flags;
+        jobs[j].e.ctx      = e->ctx;
+        jobs[j].funcs      = funcs + j * DK_FUNCS_PER_JOB;
+        jobs[j].func_count = min(DK_FUNCS_PER_JOB, func_count - j * DK_FUNCS_PER_JOB);
+    }
 
-            // rune: Function body
-            dk_emit_stmt_list(e, func->stmts);
+    dk_run_jobs(e->ctx->jobs, dk_emit_job_proc, jobs, sizeof(dk_emit_job), job_count);
 
-            // rune: Epilogue
-            if (func->type->size > 0) {
-                dk_emit_inst2(e, DK_BC_OPCODE_LDI, 0);
-            }
-            dk_emit_inst1(e, DK_BC_OPCODE_RET);
-        }
+    for_n (i64, j, job_count) {
+        dk_emitter_append(e, &jobs[j].e);
     }
 
+    heap_free(jobs);
+    heap_free(funcs);
+
 #if DK_DEBUG_PRINT_EMIT
     print(ANSI_FG_BRIGHT_MAGENTA);
     print("==== EMIT ====\n");
@@ -1506,13 +3624,19 @@ static void dk_emit_tree(dk_emitter *e, dk_tree *tree) {
 }
 
 
-static dk_program dk_program_from_tree(dk_tree *tree) {
+static dk_program dk_program_from_tree(dk_tree *tree, dk_build_flags flags, dk_ctx *ctx) {
     dk_emitter e = { 0 };
+    e.flags = flags;
+    e.ctx   = ctx;
     dk_emit_tree(&e, tree);
 
     dk_program program = { 0 };
     program.head = e.head;
     program.body = e.body;
+
+    // rune: Globals start out zeroed.
+    i64 data_size = tree->global_size * 8;
+    mem_zero_size(dk_buffer_push(&program.data, data_size), data_size);
     return program;
 }
 
@@ -1524,38 +3648,95 @@ static dk_program dk_program_from_tree(dk_tree *tree) {
 //
 ////////////////////////////////////////////////////////////////
 
-static str dk_run_program(dk_program program, arena *output_arena) {
-    typedef struct dk_call_frame dk_call_frame;
-    struct dk_call_frame {
-        i64 loc_base;
-        i64 loc_size;
-        i64 return_pos;
-        dk_call_frame *prev;
-    };
+static void dk_vm_start(dk_vm *vm, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count) {
+    vm->program          = program;
+    vm->status           = DK_VM_STATUS_RUNNING;
+    vm->ip               = entry->pos;
+    vm->pfor_chunk_count = 0;
+
+    // rune: Reuse the stacks of the previous call, without freeing them.
+    dk_buffer *data_stack = &vm->data_stack;
+    dk_buffer *call_stack = &vm->call_stack;
+    data_stack->size = 0;
+    call_stack->size = 0;
+
+    // rune: Copy initial values of globals, so the program can be run more than once.
+    vm->globals.size = 0;
+    u64 *globals = dk_buffer_push(&vm->globals, program->data.size);
+    if (program->data.size > 0) {
+        memcpy(globals, program->data.data, program->data.size);
+    }
 
-    i64 ip = 0;
+    // rune: Arguments are popped by the prologue of the entry function.
+    for_n (i64, i, arg_count) {
+        dk_buffer_push_u64(data_stack, args[i]);
+    }
 
-    str_list output_list = { 0 };
+    // rune: Setup initial call frame.
+    vm->frame_pos = call_stack->size;
+    dk_call_frame *frame = dk_buffer_push_struct(call_stack, dk_call_frame);
+    frame->return_pos = -1;
+    frame->prev_pos   = -1;
+    frame->loc_base   = call_stack->size;
+    frame->loc_size   = entry->size;
 
-    dk_buffer *head = &program.head;
-    dk_buffer *body = &program.body;
+    mem_zero_size(dk_buffer_push(call_stack, entry->size), entry->size);
+}
+
+static dk_vm_status dk_vm_resume(dk_vm *vm, i64 fuel, dk_input *input, str_list *output, arena *output_arena) {
+    dk_program *program = vm->program;
+    i64 ip = vm->ip;
+    bool runtime_err = false;
+
+    dk_buffer *head = &program->head;
+    dk_buffer *body = &program->body;
 
     dk_bc_symbol *symbols = (dk_bc_symbol *)head->data;
     i64 symbol_count      = head->size / sizeof(dk_bc_symbol);
 
-    dk_buffer data_stack = { 0 };
-    dk_buffer call_stack = { 0 };
+    dk_buffer *data_stack = &vm->data_stack;
+    dk_buffer *call_stack = &vm->call_stack;
+    dk_map_list *maps     = &vm->maps;
+
+    // NOTE(rune): Never grows while the program runs, so pointers into it stay valid.
+    u64 *globals = (u64 *)vm->globals.data;
+
+    i64 frame_pos = vm->frame_pos;
+    dk_call_frame *frame = dk_buffer_get(call_stack, frame_pos, sizeof(dk_call_frame));
+
+    // rune: Catch faults in unchecked instructions.
+    dk_trap trap = { 0 };
+    trap.frame_pos = frame_pos;
+    trap.prev      = dk_active_trap;
+    dk_trap_install();
+    dk_active_trap = &trap;
+
+    int sig = dk_trap_set(&trap);
+    if (sig != 0) {
+        dk_trap_unblock(sig);
+        str_list_push_fmt(output, output_arena, "Runtime error: %\n", dk_trap_message(sig));
+
+        // rune: Stack trace, innermost call first.
+        i64 pos = trap.ip;
+        for (i64 it = trap.frame_pos; it != -1;) {
+            dk_call_frame *it_frame = dk_buffer_get(call_stack, it, sizeof(dk_call_frame));
+            dk_bc_symbol *symbol    = dk_symbol_from_pos(symbols, symbol_count, pos);
+            if (symbol) {
+                str_list_push_fmt(output, output_arena, "    in % (line %)\n", symbol->name, symbol->row + 1);
+            }
 
-    // rune: Setup initial call frame.
-    i64 hardcoded_local_size = 64; // TODO(rune): Encode number of locals and arguments.
-    dk_call_frame *frame = dk_buffer_push_struct(&call_stack, dk_call_frame);
-    frame->return_pos = -1;
-    frame->loc_base = call_stack.size;
-    frame->loc_size = hardcoded_local_size;
+            pos = it_frame->return_pos;
+            it  = it_frame->prev_pos;
+        }
 
-    dk_buffer_push(&call_stack, hardcoded_local_size);
+        fuel        = 0;
+        runtime_err = true;
+        goto exit;
+    }
 
     while (1) {
+        i64 inst_ip = ip;
+
         dk_bc_inst_prefix prefix = *dk_buffer_read_struct(body, &ip, dk_bc_inst_prefix);
         dk_bc_opcode opcode      = prefix.opcode;
         u64 operand              = 0;
@@ -1578,50 +3759,231 @@ static str dk_run_program(dk_program program, arena *output_arena) {
             case DK_BC_OPCODE_NOP: { } break;
 
             case DK_BC_OPCODE_LDI: {
-                dk_buffer_push_u64(&data_stack, operand);
+                dk_buffer_push_u64(data_stack, operand);
             } break;
 
             case DK_BC_OPCODE_LDL: {
-                u64 loc_val = *dk_buffer_get_u64(&call_stack, frame->loc_base + operand * 8); // TODO(rune): Properly sized locals (no more *8)
-                dk_buffer_push_u64(&data_stack, loc_val);
+                u64 loc_val = *dk_buffer_get_u64(call_stack, frame->loc_base + operand * 8); // TODO(rune): Properly sized locals (no more *8)
+                dk_buffer_push_u64(data_stack, loc_val);
             } break;
 
             case DK_BC_OPCODE_POP: {
-                dk_buffer_pop_u64(&data_stack);
+                dk_buffer_pop_u64(data_stack);
             } break;
 
             case DK_BC_OPCODE_STL: {
-                u64 val = dk_buffer_pop_u64(&data_stack);
-                *dk_buffer_get_u64(&call_stack, frame->loc_base + operand * 8) = val; // TODO(rune): Properly sized locals (no more *8)
+                u64 val = dk_buffer_pop_u64(data_stack);
+                *dk_buffer_get_u64(call_stack, frame->loc_base + operand * 8) = val; // TODO(rune): Properly sized locals (no more *8)
             } break;
 
             case DK_BC_OPCODE_DUP: {
-                u64 val = dk_buffer_pop_u64(&data_stack);
-                dk_buffer_push_u64(&data_stack, val);
-                dk_buffer_push_u64(&data_stack, val);
+                u64 val = dk_buffer_pop_u64(data_stack);
+                dk_buffer_push_u64(data_stack, val);
+                dk_buffer_push_u64(data_stack, val);
+            } break;
+
+            case DK_BC_OPCODE_LDG: {
+                dk_buffer_push_u64(data_stack, globals[operand]);
+            } break;
+
+            case DK_BC_OPCODE_STG: {
+                globals[operand] = dk_buffer_pop_u64(data_stack);
+            } break;
+
+            case DK_BC_OPCODE_LDX:
+            case DK_BC_OPCODE_STX: {
+                u64 idx = dk_buffer_pop_u64(data_stack);
+                u64 len = *dk_buffer_get_u64(call_stack, frame->loc_base + operand * 8);
+                if (idx >= len) {
+                    str_list_push_fmt(output, output_arena, "Runtime error: Index % is out of bounds for list of length %.\n", i64(idx), len);
+                    runtime_err = true;
+                    goto exit;
+                }
+
+                u64 *elem = dk_buffer_get_u64(call_stack, frame->loc_base + (operand + 1 + idx) * 8);
+                if (opcode == DK_BC_OPCODE_LDX) {
+                    dk_buffer_push_u64(data_stack, *elem);
+                } else {
+                    *elem = dk_buffer_pop_u64(data_stack);
+                }
+            } break;
+
+            case DK_BC_OPCODE_LDXU: {
+                trap.ip = inst_ip;
+                u64 idx = dk_buffer_pop_u64(data_stack);
+                u64 *elems = (u64 *)(call_stack->data + frame->loc_base) + operand + 1;
+                dk_buffer_push_u64(data_stack, elems[idx]);
+            } break;
+
+            case DK_BC_OPCODE_STXU: {
+                trap.ip = inst_ip;
+                u64 idx = dk_buffer_pop_u64(data_stack);
+                u64 *elems = (u64 *)(call_stack->data + frame->loc_base) + operand + 1;
+                elems[idx] = dk_buffer_pop_u64(data_stack);
+            } break;
+
+            case DK_BC_OPCODE_BULK: {
+                dk_bulk_kernel kernel = dk_bulk_operand_kernel(operand);
+                u64 *locals = (u64 *)(call_stack->data + frame->loc_base);
+                u64 *dst    = locals + dk_bulk_operand_dst(operand);
+                u64 *src    = locals + dk_bulk_operand_src(operand);
+                u64 src_pos = 0;
+                u64 scalar  = 0;
+                if (dk_bulk_operand_checked(operand)) {
+                    src_pos = dk_buffer_pop_u64(data_stack);
+                }
+                if (dk_bulk_op_from_kernel(kernel) == DK_BULK_OP_SCALE) {
+                    scalar = dk_buffer_pop_u64(data_stack);
+                }
+
+                // NOTE(rune): Both lists are checked to have the same length when compiling.
+                u64 result = 0;
+                if (dk_bulk_operand_checked(operand)) {
+                    if (dk_bulk_overflow(kernel, dst + 1, src + 1, i64(dst[0]), scalar, &result)) {
+                        str_list_push_fmt(output, output_arena, "Runtime error: Integer overflow at line %, column %.\n",
+                                          dk_src_operand_row(src_pos),
+                                          dk_src_operand_col(src_pos));
+                        runtime_err = true;
+                        goto exit;
+                    }
+                } else {
+                    dk_bulk_func *func = dk_bulk_get_func(kernel);
+                    result = func(dst + 1, src + 1, i64(dst[0]), scalar);
+                }
+                dk_buffer_push_u64(data_stack, result);
+            } break;
+
+            case DK_BC_OPCODE_LDF:
+            case DK_BC_OPCODE_STF: {
+                u64 idx = dk_buffer_pop_u64(data_stack);
+                u64 *list = (u64 *)(call_stack->data + frame->loc_base) + dk_field_operand_off(operand);
+                if (dk_field_operand_unchecked(operand)) {
+                    trap.ip = inst_ip;
+                } else if (idx >= list[0]) {
+                    str_list_push_fmt(output, output_arena, "Runtime error: Index % is out of bounds for list of length %.\n", i64(idx), list[0]);
+                    runtime_err = true;
+                    goto exit;
+                }
+
+                u64 *slot = list + 1 + dk_field_operand_start(operand) + idx * dk_field_operand_stride(operand);
+                if (opcode == DK_BC_OPCODE_LDF) {
+                    dk_buffer_push_u64(data_stack, *slot);
+                } else {
+                    *slot = dk_buffer_pop_u64(data_stack);
+                }
+            } break;
+
+            case DK_BC_OPCODE_LDL8:  dk_buffer_push_u64(data_stack, *(u8  *)(call_stack->data + frame->loc_base + operand)); break;
+            case DK_BC_OPCODE_LDL16: dk_buffer_push_u64(data_stack, *(u16 *)(call_stack->data + frame->loc_base + operand)); break;
+            case DK_BC_OPCODE_LDL32: dk_buffer_push_u64(data_stack, *(u32 *)(call_stack->data + frame->loc_base + operand)); break;
+            case DK_BC_OPCODE_STL8:  *(u8  *)(call_stack->data + frame->loc_base + operand) = u8(dk_buffer_pop_u64(data_stack));  break;
+            case DK_BC_OPCODE_STL16: *(u16 *)(call_stack->data + frame->loc_base + operand) = u16(dk_buffer_pop_u64(data_stack)); break;
+            case DK_BC_OPCODE_STL32: *(u32 *)(call_stack->data + frame->loc_base + operand) = u32(dk_buffer_pop_u64(data_stack)); break;
+
+            case DK_BC_OPCODE_LDF8:
+            case DK_BC_OPCODE_LDF16:
+            case DK_BC_OPCODE_LDF32:
+            case DK_BC_OPCODE_STF8:
+            case DK_BC_OPCODE_STF16:
+            case DK_BC_OPCODE_STF32: {
+                u64 idx = dk_buffer_pop_u64(data_stack);
+                u64 *list = (u64 *)(call_stack->data + frame->loc_base) + dk_field_operand_off(operand);
+                if (dk_field_operand_unchecked(operand)) {
+                    trap.ip = inst_ip;
+                } else if (idx >= list[0]) {
+                    str_list_push_fmt(output, output_arena, "Runtime error: Index % is out of bounds for list of length %.\n", i64(idx), list[0]);
+                    runtime_err = true;
+                    goto exit;
+                }
+
+                u8 *elem = (u8 *)(list + 1) + dk_field_operand_start(operand) + idx * dk_field_operand_stride(operand);
+                switch (opcode) {
+                    case DK_BC_OPCODE_LDF8:  dk_buffer_push_u64(data_stack, *(u8  *)elem); break;
+                    case DK_BC_OPCODE_LDF16: dk_buffer_push_u64(data_stack, *(u16 *)elem); break;
+                    case DK_BC_OPCODE_LDF32: dk_buffer_push_u64(data_stack, *(u32 *)elem); break;
+                    case DK_BC_OPCODE_STF8:  *(u8  *)elem = u8(dk_buffer_pop_u64(data_stack));  break;
+                    case DK_BC_OPCODE_STF16: *(u16 *)elem = u16(dk_buffer_pop_u64(data_stack)); break;
+                    case DK_BC_OPCODE_STF32: *(u32 *)elem = u32(dk_buffer_pop_u64(data_stack)); break;
+                }
             } break;
 
+            case DK_BC_OPCODE_SEXT8:  { u64 *a = dk_buffer_get_u64(data_stack, data_stack->size - 8); *a = u64(i64(i8(*a)));  } break;
+            case DK_BC_OPCODE_SEXT16: { u64 *a = dk_buffer_get_u64(data_stack, data_stack->size - 8); *a = u64(i64(i16(*a))); } break;
+            case DK_BC_OPCODE_SEXT32: { u64 *a = dk_buffer_get_u64(data_stack, data_stack->size - 8); *a = u64(i64(i32(*a))); } break;
+            case DK_BC_OPCODE_ZEXT8:  { u64 *a = dk_buffer_get_u64(data_stack, data_stack->size - 8); *a = *a & 0xff;         } break;
+
 #define DK_BC_BINOP_IMPL(calc)                          \
             do {                                        \
-                u64 b = dk_buffer_pop_u64(&data_stack); \
-                u64 a = dk_buffer_pop_u64(&data_stack); \
+                u64 b = dk_buffer_pop_u64(data_stack); \
+                u64 a = dk_buffer_pop_u64(data_stack); \
                 u64 c = calc;                           \
-                dk_buffer_push_u64(&data_stack, c);     \
+                dk_buffer_push_u64(data_stack, c);     \
             } while (0)
 
             case DK_BC_OPCODE_ADD:  DK_BC_BINOP_IMPL(a + b); break;
             case DK_BC_OPCODE_SUB:  DK_BC_BINOP_IMPL(a - b); break;
             case DK_BC_OPCODE_UMUL: DK_BC_BINOP_IMPL(a * b); break;
-            case DK_BC_OPCODE_UDIV: DK_BC_BINOP_IMPL(a / b); break;
+            case DK_BC_OPCODE_UDIV: trap.ip = inst_ip; DK_BC_BINOP_IMPL(a / b); break;
+
+            case DK_BC_OPCODE_IMUL: DK_BC_BINOP_IMPL(a * b); break; // NOTE(rune): Same low 64 bits as a signed multiply, without the undefined behaviour on overflow.
+            case DK_BC_OPCODE_IDIV: trap.ip = inst_ip; DK_BC_BINOP_IMPL(u64(i64(a) / i64(b))); break;
+            case DK_BC_OPCODE_MOD:  trap.ip = inst_ip; DK_BC_BINOP_IMPL(u64(i64(a) % i64(b))); break;
+
+            case DK_BC_OPCODE_ADDC:
+            case DK_BC_OPCODE_SUBC:
+            case DK_BC_OPCODE_IMULC:
+            case DK_BC_OPCODE_IDIVC:
+            case DK_BC_OPCODE_MODC: {
+                i64 b = i64(dk_buffer_pop_u64(data_stack));
+                i64 a = i64(dk_buffer_pop_u64(data_stack));
+                i64 c = 0;
+                bool overflow = false;
+                bool div_by_zero = false;
+                switch (opcode) {
+                    case DK_BC_OPCODE_ADDC:  overflow = dk_add_overflow(a, b, &c); break;
+                    case DK_BC_OPCODE_SUBC:  overflow = dk_sub_overflow(a, b, &c); break;
+                    case DK_BC_OPCODE_IMULC: overflow = dk_mul_overflow(a, b, &c); break;
+                    case DK_BC_OPCODE_IDIVC: {
+                        div_by_zero = b == 0;
+                        overflow    = a == I64_MIN && b == -1;
+                        if (!div_by_zero && !overflow) c = a / b;
+                    } break;
+                    case DK_BC_OPCODE_MODC: {
+                        div_by_zero = b == 0;
+                        if (!div_by_zero && b != -1) c = a % b; // NOTE(rune): I64_MIN % -1 traps on x64, but is just 0.
+                    } break;
+                }
+
+                if (overflow || div_by_zero) {
+                    str_list_push_fmt(output, output_arena, "Runtime error: % at line %, column %.\n",
+                                      div_by_zero ? "Division by zero" : "Integer overflow",
+                                      dk_src_operand_row(operand),
+                                      dk_src_operand_col(operand));
+                    runtime_err = true;
+                    goto exit;
+                }
+
+                dk_buffer_push_u64(data_stack, u64(c));
+            } break;
 
-            case DK_BC_OPCODE_IMUL: DK_BC_BINOP_IMPL(u64(i64(a) * i64(b))); break;
-            case DK_BC_OPCODE_IDIV: DK_BC_BINOP_IMPL(u64(i64(a) / i64(b))); break;
+            case DK_BC_OPCODE_BAND: DK_BC_BINOP_IMPL(a & b); break;
+            case DK_BC_OPCODE_BOR:  DK_BC_BINOP_IMPL(a | b); break;
+            case DK_BC_OPCODE_BXOR: DK_BC_BINOP_IMPL(a ^ b); break;
+            case DK_BC_OPCODE_SHL:  DK_BC_BINOP_IMPL(a << (b & 63)); break;
+            case DK_BC_OPCODE_SHR:  DK_BC_BINOP_IMPL(u64(i64(a) >> (b & 63))); break;
 
             case DK_BC_OPCODE_FADD: DK_BC_BINOP_IMPL(u64_from_f64(f64_from_u64(a) + f64_from_u64(b))); break;
             case DK_BC_OPCODE_FSUB: DK_BC_BINOP_IMPL(u64_from_f64(f64_from_u64(a) - f64_from_u64(b))); break;
             case DK_BC_OPCODE_FMUL: DK_BC_BINOP_IMPL(u64_from_f64(f64_from_u64(a) * f64_from_u64(b))); break;
             case DK_BC_OPCODE_FDIV: DK_BC_BINOP_IMPL(u64_from_f64(f64_from_u64(a) / f64_from_u64(b))); break;
 
+            case DK_BC_OPCODE_IMIN: DK_BC_BINOP_IMPL(i64(a) < i64(b) ? a : b); break;
+            case DK_BC_OPCODE_IMAX: DK_BC_BINOP_IMPL(i64(a) > i64(b) ? a : b); break;
+
+            case DK_BC_OPCODE_FMIN: DK_BC_BINOP_IMPL(u64_from_f64(fmin(f64_from_u64(a), f64_from_u64(b)))); break;
+            case DK_BC_OPCODE_FMAX: DK_BC_BINOP_IMPL(u64_from_f64(fmax(f64_from_u64(a), f64_from_u64(b)))); break;
+            case DK_BC_OPCODE_FPOW: DK_BC_BINOP_IMPL(u64_from_f64(pow(f64_from_u64(a), f64_from_u64(b)))); break;
+
             case DK_BC_OPCODE_AND:  DK_BC_BINOP_IMPL(a && b); break;
             case DK_BC_OPCODE_OR:   DK_BC_BINOP_IMPL(a || b); break;
 
@@ -1629,16 +3991,168 @@ static str dk_run_program(dk_program program, arena *output_arena) {
             case DK_BC_OPCODE_LT:   DK_BC_BINOP_IMPL(i64(a) < i64(b));  break;
             case DK_BC_OPCODE_GT:   DK_BC_BINOP_IMPL(i64(a) > i64(b));  break;
 
-            case DK_BC_OPCODE_FEQ: DK_BC_BINOP_IMPL(u64_from_f64(f64_from_u64(a) == f64_from_u64(b))); break;
-            case DK_BC_OPCODE_FLT: DK_BC_BINOP_IMPL(u64_from_f64(f64_from_u64(a) < f64_from_u64(b))); break;
-            case DK_BC_OPCODE_FGT: DK_BC_BINOP_IMPL(u64_from_f64(f64_from_u64(a) > f64_from_u64(b))); break;
+            case DK_BC_OPCODE_FEQ:  DK_BC_BINOP_IMPL(f64_from_u64(a) == f64_from_u64(b)); break;
+            case DK_BC_OPCODE_FLT:  DK_BC_BINOP_IMPL(f64_from_u64(a) < f64_from_u64(b));  break;
+            case DK_BC_OPCODE_FGT:  DK_BC_BINOP_IMPL(f64_from_u64(a) > f64_from_u64(b));  break;
 
 #undef DK_BC_BINOP_IMPL
 
+#define DK_BC_UNOP_IMPL(calc)                           \
+            do {                                        \
+                u64 a = dk_buffer_pop_u64(data_stack); \
+                u64 c = calc;                           \
+                dk_buffer_push_u64(data_stack, c);     \
+            } while (0)
+
+            case DK_BC_OPCODE_IABS:   DK_BC_UNOP_IMPL(i64(a) < 0 ? 0 - a : a); break;
+            case DK_BC_OPCODE_FSQRT:  DK_BC_UNOP_IMPL(u64_from_f64(sqrt(f64_from_u64(a)))); break;
+            case DK_BC_OPCODE_FFLOOR: DK_BC_UNOP_IMPL(u64_from_f64(floor(f64_from_u64(a)))); break;
+            case DK_BC_OPCODE_FABS:   DK_BC_UNOP_IMPL(u64_from_f64(fabs(f64_from_u64(a)))); break;
+
+#undef DK_BC_UNOP_IMPL
+
+            case DK_BC_OPCODE_VMAKE: {
+                f64 w = f64_from_u64(dk_buffer_pop_u64(data_stack));
+                f64 z = f64_from_u64(dk_buffer_pop_u64(data_stack));
+                f64 y = f64_from_u64(dk_buffer_pop_u64(data_stack));
+                f64 x = f64_from_u64(dk_buffer_pop_u64(data_stack));
+                *dk_buffer_push_struct(data_stack, vec4) = vec4(f32(x), f32(y), f32(z), f32(w));
+            } break;
+
+            // NOTE(rune): The result overwrites the first operand in place, instead of popping and pushing it again.
+            case DK_BC_OPCODE_VADD: {
+                vec4 b = *dk_buffer_pop_struct(data_stack, vec4);
+                vec4 *a = dk_buffer_get(data_stack, data_stack->size - isizeof(vec4), sizeof(vec4));
+                *a = dk_vec4_add(*a, b);
+            } break;
+
+            case DK_BC_OPCODE_VMUL: {
+                vec4 b = *dk_buffer_pop_struct(data_stack, vec4);
+                vec4 *a = dk_buffer_get(data_stack, data_stack->size - isizeof(vec4), sizeof(vec4));
+                *a = dk_vec4_mul(*a, b);
+            } break;
+
+            case DK_BC_OPCODE_VFMA: {
+                vec4 c = *dk_buffer_pop_struct(data_stack, vec4);
+                vec4 b = *dk_buffer_pop_struct(data_stack, vec4);
+                vec4 *a = dk_buffer_get(data_stack, data_stack->size - isizeof(vec4), sizeof(vec4));
+                *a = dk_vec4_fma(*a, b, c);
+            } break;
+
+            case DK_BC_OPCODE_TLEN: {
+                str a = *dk_buffer_pop_struct(data_stack, str);
+                dk_buffer_push_u64(data_stack, u64(a.len));
+            } break;
+
+            case DK_BC_OPCODE_TEQ: {
+                str b = *dk_buffer_pop_struct(data_stack, str);
+                str a = *dk_buffer_pop_struct(data_stack, str);
+                dk_buffer_push_u64(data_stack, str_eq(a, b));
+            } break;
+
+            case DK_BC_OPCODE_TFIND: {
+                str haystack = *dk_buffer_pop_struct(data_stack, str);
+                str needle   = *dk_buffer_pop_struct(data_stack, str);
+                dk_buffer_push_u64(data_stack, u64(str_idx_of_str(haystack, needle)));
+            } break;
+
+            case DK_BC_OPCODE_TSLICE: {
+                // NOTE(rune): Out of range indices are clamped, so a slice never points outside the original text.
+                i64 end   = i64(dk_buffer_pop_u64(data_stack));
+                i64 begin = i64(dk_buffer_pop_u64(data_stack));
+                str *a    = dk_buffer_get(data_stack, data_stack->size - isizeof(str), sizeof(str));
+                begin = clamp(begin, 0, a->len);
+                end   = clamp(end, begin, a->len);
+                *a = substr_range(*a, (i64_range) { begin, end });
+            } break;
+
+            case DK_BC_OPCODE_MAPNEW: {
+                dk_map *map = dk_map_create(maps);
+                *dk_buffer_get_u64(call_stack, frame->loc_base + operand * 8) = u64(map);
+            } break;
+
+            case DK_BC_OPCODE_MAPFREE: {
+                dk_map *map = (dk_map *)*dk_buffer_get_u64(call_stack, frame->loc_base + operand * 8);
+                dk_map_destroy(maps, map);
+            } break;
+
+            case DK_BC_OPCODE_MAPPUT: {
+                dk_map *map = (dk_map *)dk_buffer_pop_u64(data_stack);
+                u64 key     = dk_buffer_pop_u64(data_stack);
+                u64 val     = dk_buffer_pop_u64(data_stack);
+                dk_map_put(map, key, val);
+                dk_buffer_push_u64(data_stack, val);
+            } break;
+
+            case DK_BC_OPCODE_MAPGET: {
+                dk_map *map = (dk_map *)dk_buffer_pop_u64(data_stack);
+                u64 key     = dk_buffer_pop_u64(data_stack);
+                u64 val     = 0;
+                if (!dk_map_get(map, key, &val)) {
+                    str_list_push_fmt(output, output_arena, "Runtime error: Key % is not in the ordbog.\n", i64(key));
+                    runtime_err = true;
+                    goto exit;
+                }
+                dk_buffer_push_u64(data_stack, val);
+            } break;
+
+            case DK_BC_OPCODE_MAPHAS: {
+                dk_map *map = (dk_map *)dk_buffer_pop_u64(data_stack);
+                u64 key     = dk_buffer_pop_u64(data_stack);
+                u64 val     = 0;
+                dk_buffer_push_u64(data_stack, dk_map_get(map, key, &val));
+            } break;
+
+            case DK_BC_OPCODE_MAPDEL: {
+                dk_map *map = (dk_map *)dk_buffer_pop_u64(data_stack);
+                u64 key     = dk_buffer_pop_u64(data_stack);
+                dk_buffer_push_u64(data_stack, dk_map_remove(map, key));
+            } break;
+
+            case DK_BC_OPCODE_MAPLEN: {
+                dk_map *map = (dk_map *)dk_buffer_pop_u64(data_stack);
+                dk_buffer_push_u64(data_stack, dk_map_count(map));
+            } break;
+
+            case DK_BC_OPCODE_INI:
+            case DK_BC_OPCODE_INF: {
+                str token = dk_input_next_token(input);
+                if (token.len == 0) {
+                    str_list_push_fmt(output, output_arena, "Runtime error: No more input.\n");
+                    runtime_err = true;
+                    goto exit;
+                }
+
+                u64 val = 0;
+                bool ok = false;
+                if (opcode == DK_BC_OPCODE_INI) {
+                    i64 i = 0;
+                    ok  = dk_parse_int(token, &i);
+                    val = u64(i);
+                } else {
+                    f64 f = 0;
+                    ok  = dk_parse_float(token, &f);
+                    val = u64_from_f64(f);
+                }
+
+                if (!ok) {
+                    str_list_push_fmt(output, output_arena, "Runtime error: Expected % in input, but got \"%\".\n",
+                                      opcode == DK_BC_OPCODE_INI ? str("et heltal") : str("en flyder"), token);
+                    runtime_err = true;
+                    goto exit;
+                }
+
+                dk_buffer_push_u64(data_stack, val);
+            } break;
+
+            case DK_BC_OPCODE_INMORE: {
+                dk_buffer_push_u64(data_stack, dk_input_has_more(input));
+            } break;
+
             case DK_BC_OPCODE_NOT: {
-                u64 a = dk_buffer_pop_u64(&data_stack);
+                u64 a = dk_buffer_pop_u64(data_stack);
                 u64 c = !a;
-                dk_buffer_push_u64(&data_stack, c);
+                dk_buffer_push_u64(data_stack, c);
             } break;
 
             case DK_BC_OPCODE_CALL: {
@@ -1646,17 +4160,25 @@ static str dk_run_program(dk_program program, arena *output_arena) {
 
                 // TODO(rune): Better system for built-in procs.
                 if (id == 0xdeadbeef) {
-                    u64 a = dk_buffer_pop_u64(&data_stack);
-                    str_list_push_fmt(&output_list, output_arena, "%\n", a);
-                    dk_buffer_push_u64(&data_stack, 0); // TODO(rune): What should print return?
+                    u64 a = dk_buffer_pop_u64(data_stack);
+                    str_list_push_fmt(output, output_arena, "%\n", i64(a));
+                    dk_buffer_push_u64(data_stack, 0); // TODO(rune): What should print return?
                 } else if (id == 0xdeadbeef + 1) {
-                    u64 a = dk_buffer_pop_u64(&data_stack);
-                    str_list_push_fmt(&output_list, output_arena, "%\n", f64_from_u64(a));
-                    dk_buffer_push_u64(&data_stack, 0); // TODO(rune): What should print return?
+                    u64 a = dk_buffer_pop_u64(data_stack);
+                    str_list_push_fmt(output, output_arena, "%\n", f64_from_u64(a));
+                    dk_buffer_push_u64(data_stack, 0); // TODO(rune): What should print return?
                 } else if (id == 0xdeadbeef + 2) {
-                    u64 a = dk_buffer_pop_u64(&data_stack);
-                    str_list_push_fmt(&output_list, output_arena, "%\n", a ? "sand" : "falsk");
-                    dk_buffer_push_u64(&data_stack, 0); // TODO(rune): What should print return?
+                    u64 a = dk_buffer_pop_u64(data_stack);
+                    str_list_push_fmt(output, output_arena, "%\n", a ? "sand" : "falsk");
+                    dk_buffer_push_u64(data_stack, 0); // TODO(rune): What should print return?
+                } else if (id == 0xdeadbeef + 3) {
+                    vec4 a = *dk_buffer_pop_struct(data_stack, vec4);
+                    str_list_push_fmt(output, output_arena, "%\n", a);
+                    dk_buffer_push_u64(data_stack, 0); // TODO(rune): What should print return?
+                } else if (id == 0xdeadbeef + 4) {
+                    str a = *dk_buffer_pop_struct(data_stack, str);
+                    str_list_push_fmt(output, output_arena, "%\n", a);
+                    dk_buffer_push_u64(data_stack, 0); // TODO(rune): What should print return?
                 } else {
                     // TODO(rune): Better symbol lookup.
                     dk_bc_symbol *symbol = null;
@@ -1667,16 +4189,21 @@ static str dk_run_program(dk_program program, arena *output_arena) {
                     }
                     assert(symbol != null); // TODO(rune): Better error runtime error reporting.
 
-                    dk_call_frame *next_frame = dk_buffer_push_struct(&call_stack, dk_call_frame);
-                    next_frame->prev  = frame;
-                    frame             = next_frame;
-                    frame->loc_base   = call_stack.size;
-                    frame->loc_size   = hardcoded_local_size;
+                    i64 prev_pos      = frame_pos;
+                    frame_pos         = call_stack->size;
+                    frame             = dk_buffer_push_struct(call_stack, dk_call_frame);
+                    frame->prev_pos   = prev_pos;
+                    frame->loc_base   = call_stack->size;
+                    frame->loc_size   = symbol->size;
                     frame->return_pos = ip;
 
                     ip = symbol->pos;
 
-                    dk_buffer_push(&call_stack, frame->loc_size);
+                    mem_zero_size(dk_buffer_push(call_stack, symbol->size), symbol->size);
+                    frame = dk_buffer_get(call_stack, frame_pos, sizeof(dk_call_frame));
+                    trap.frame_pos = frame_pos;
+
+                    if (--fuel <= 0) goto out_of_fuel;
                 }
 
             } break;
@@ -1686,31 +4213,79 @@ static str dk_run_program(dk_program program, arena *output_arena) {
                     goto exit;
                 }
 
-                ip = frame->return_pos;;
-                dk_buffer_pop(&call_stack, frame->loc_size);
-                dk_buffer_pop_struct(&call_stack, dk_call_frame);
-                frame = frame->prev;
+                ip = frame->return_pos;
+                frame_pos = frame->prev_pos;
+                dk_buffer_pop(call_stack, frame->loc_size);
+                dk_buffer_pop_struct(call_stack, dk_call_frame);
+
+                assert(frame_pos != -1);
+                frame = dk_buffer_get(call_stack, frame_pos, sizeof(dk_call_frame));
+                trap.frame_pos = frame_pos;
 
-                assert(frame != null);
+                if (--fuel <= 0) goto out_of_fuel;
             } break;
 
             case DK_BC_OPCODE_BR: {
-                u64 condition = dk_buffer_pop_u64(&data_stack);
+                u64 condition = dk_buffer_pop_u64(data_stack);
                 if (condition) {
                     ip = operand;
                 }
+
+                if (--fuel <= 0) goto out_of_fuel;
+            } break;
+
+            case DK_BC_OPCODE_JMP: {
+                ip = operand;
+
+                if (--fuel <= 0) goto out_of_fuel;
+            } break;
+
+            case DK_BC_OPCODE_SWITCH: {
+                i64 key = i64(dk_buffer_pop_u64(data_stack));
+                dk_bc_switch_header *header = dk_buffer_read_struct(body, &ip, dk_bc_switch_header);
+                dk_bc_switch_entry *entries = dk_buffer_read(body, &ip, operand * sizeof(dk_bc_switch_entry));
+
+                ip = dk_bc_switch_target(header, entries, operand, key);
+
+                if (--fuel <= 0) goto out_of_fuel;
+            } break;
+
+            case DK_BC_OPCODE_PFOR: {
+                dk_bc_pfor_header *header        = dk_buffer_read_struct(body, &ip, dk_bc_pfor_header);
+                dk_bc_pfor_reduction *reductions = dk_buffer_read(body, &ip, header->reduction_count * sizeof(dk_bc_pfor_reduction));
+
+                // NOTE(rune): A loop which ran out of fuel is resumed from this instruction, with its chunks already started.
+                if (vm->pfor_chunk_count == 0) {
+                    i64 last  = i64(dk_buffer_pop_u64(data_stack));
+                    i64 first = i64(dk_buffer_pop_u64(data_stack));
+                    dk_vm_pfor_start(vm, frame, header, reductions, ip, first, last);
+                }
+
+                if (!dk_vm_pfor_run(vm, &fuel)) {
+                    ip = inst_ip;
+                    goto out_of_fuel;
+                }
+
+                if (!dk_vm_pfor_finish(vm, frame, header, reductions, output, output_arena)) {
+                    runtime_err = true;
+                    goto exit;
+                }
+
+                ip = operand;
+
+                if (--fuel <= 0) goto out_of_fuel;
             } break;
 
             case DK_BC_OPCODE_I2F: {
-                u64 val  = dk_buffer_pop_u64(&data_stack);
+                u64 val  = dk_buffer_pop_u64(data_stack);
                 u64 cast = u64_from_f64(f64(i64(val)));
-                dk_buffer_push_u64(&data_stack, cast);
+                dk_buffer_push_u64(data_stack, cast);
             } break;
 
             case DK_BC_OPCODE_F2I: {
-                u64 val = dk_buffer_pop_u64(&data_stack);
+                u64 val = dk_buffer_pop_u64(data_stack);
                 u64 cast = i64(f64_from_u64(val));
-                dk_buffer_push_u64(&data_stack, cast);
+                dk_buffer_push_u64(data_stack, cast);
             } break;
 
             default: {
@@ -1719,32 +4294,416 @@ static str dk_run_program(dk_program program, arena *output_arena) {
         }
     }
 
+out_of_fuel:
+    dk_active_trap = trap.prev;
+    vm->ip        = ip;
+    vm->frame_pos = frame_pos;
+    vm->fuel_left = 0;
+    return vm->status;
+
 exit:
-    if (data_stack.size != 8) {
-        str_list_push(&output_list, output_arena, dk_tprint("Invalid stack size on exit. Was % but expected %.", data_stack.size, 8));
+    dk_active_trap = trap.prev;
+    vm->fuel_left  = fuel;
+
+    // NOTE(rune): Maps are normally freed when their function returns, but a runtime error skips the returns.
+    dk_map_destroy_all(maps);
+
+    vm->status = runtime_err ? DK_VM_STATUS_ERROR : DK_VM_STATUS_DONE;
+    return vm->status;
+}
+
+static bool dk_vm_call(dk_vm *vm, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count,
+                       dk_input *input, str_list *output, arena *output_arena) {
+    dk_vm_start(vm, program, entry, args, arg_count);
+    return dk_vm_resume(vm, I64_MAX, input, output, output_arena) == DK_VM_STATUS_DONE;
+}
+
+static i64 dk_bc_switch_target(dk_bc_switch_header *header, dk_bc_switch_entry *entries, u64 entry_count, i64 key) {
+    i64 ret = i64(header->default_pos);
+    if (header->kind == DK_BC_SWITCH_KIND_DENSE) {
+        u64 idx = u64(key) - u64(header->min);
+        if (idx < entry_count) {
+            ret = entries[idx].pos;
+        }
+    } else {
+        i64 lo = 0;
+        i64 hi = i64(entry_count);
+        while (lo < hi) {
+            i64 mid = lo + (hi - lo) / 2;
+            if (entries[mid].key < key) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo < i64(entry_count) && entries[lo].key == key) {
+            ret = entries[lo].pos;
+        }
+    }
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Samtidig loops
+
+// NOTE(rune): Globals are copied to each chunk, and input is empty. The checker rejects assignments to globals in the
+// body, and calls to functions which assign them, so every chunk sees the globals as they were before the loop.
+static void dk_vm_pfor_start(dk_vm *vm, dk_call_frame *frame, dk_bc_pfor_header *header, dk_bc_pfor_reduction *reductions,
+                             i64 body_pos, i64 first, i64 last) {
+    vm->pfor_chunk_count = 0;
+    if (last < first) {
+        return;
+    }
+
+    u64 count       = u64(last) - u64(first) + 1;
+    i64 chunk_count = i64(min(count, DK_VM_CHUNK_COUNT));
+    u64 per_chunk   = count / u64(chunk_count);
+    u64 remainder   = count % u64(chunk_count);
+
+    if (vm->chunks == null) {
+        vm->chunks = heap_alloc(DK_VM_CHUNK_COUNT * sizeof(dk_vm_chunk));
+        mem_zero_size(vm->chunks, DK_VM_CHUNK_COUNT * sizeof(dk_vm_chunk));
+    }
+
+    u64 *locals = dk_buffer_get(&vm->call_stack, frame->loc_base, frame->loc_size);
+
+    u64 chunk_first = u64(first);
+    for_n (i64, k, chunk_count) {
+        dk_vm_chunk *chunk = &vm->chunks[k];
+        if (chunk->vm == null) {
+            chunk->vm    = heap_alloc(sizeof(dk_vm));
+            chunk->arena = arena_create_default();
+            mem_zero_struct(chunk->vm);
+        }
+
+        arena_reset(chunk->arena);
+        mem_zero_struct(&chunk->output);
+        chunk->status = DK_VM_STATUS_RUNNING;
+
+        // NOTE(rune): Ordbøger of a chunk, which was abandoned before it finished, e.g. when its program was killed.
+        dk_map_destroy_all(&chunk->vm->maps);
+
+        dk_vm *chunk_vm = chunk->vm;
+        chunk_vm->program          = vm->program;
+        chunk_vm->status           = DK_VM_STATUS_RUNNING;
+        chunk_vm->ip               = body_pos;
+        chunk_vm->jobs             = vm->jobs;
+        chunk_vm->data_stack.size  = 0;
+        chunk_vm->call_stack.size  = 0;
+        chunk_vm->globals.size     = 0;
+        chunk_vm->pfor_chunk_count = 0;
+
+        u64 *globals = dk_buffer_push(&chunk_vm->globals, vm->globals.size);
+        if (vm->globals.size > 0) {
+            memcpy(globals, vm->globals.data, vm->globals.size);
+        }
+
+        // rune: Copy of the current call frame, which returns to dk_vm_pfor_run() when the chunk is done.
+        chunk_vm->frame_pos = chunk_vm->call_stack.size;
+        dk_call_frame *chunk_frame = dk_buffer_push_struct(&chunk_vm->call_stack, dk_call_frame);
+        chunk_frame->return_pos = -1;
+        chunk_frame->prev_pos   = -1;
+        chunk_frame->loc_base   = chunk_vm->call_stack.size;
+        chunk_frame->loc_size   = frame->loc_size;
+
+        u64 *chunk_locals = dk_buffer_push(&chunk_vm->call_stack, frame->loc_size);
+        memcpy(chunk_locals, locals, frame->loc_size);
+
+        u64 size = per_chunk + (u64(k) < remainder);
+        chunk_locals[header->index_off] = chunk_first;
+        chunk_locals[header->end_off]   = chunk_first + size - 1;
+        chunk_first += size;
+
+        // rune: Reductions start at the identity of their opcode.
+        for_n (u64, i, header->reduction_count) {
+            u64 *value = &chunk_locals[reductions[i].off];
+            switch (reductions[i].opcode) {
+                case DK_BC_OPCODE_ADD:  *value = 0;                         break;
+                case DK_BC_OPCODE_FADD: *value = u64_from_f64(0.0);         break;
+                case DK_BC_OPCODE_IMIN: *value = u64(I64_MAX);              break;
+                case DK_BC_OPCODE_IMAX: *value = u64(I64_MIN);              break;
+                case DK_BC_OPCODE_FMIN: *value = u64_from_f64(INFINITY);    break;
+                case DK_BC_OPCODE_FMAX: *value = u64_from_f64(-INFINITY);   break;
+                default:                assert(false && "Invalid reduction opcode."); break;
+            }
+        }
+    }
+
+    vm->pfor_chunk_count = chunk_count;
+}
+
+// NOTE(rune): The fuel left is split evenly between the chunks which are still running, and what they use is
+// charged to the caller. Chunks which finish early leave their share for the next round, so the loop only pauses
+// when all of the fuel is used.
+static bool dk_vm_pfor_run(dk_vm *vm, i64 *fuel) {
+    while (*fuel > 0) {
+        i64 running = 0;
+        for_n (i64, k, vm->pfor_chunk_count) {
+            running += vm->chunks[k].status == DK_VM_STATUS_RUNNING;
+        }
+
+        if (running == 0) {
+            return true;
+        }
+
+        job_group group = { 0 };
+        i64 share = max(*fuel / running, 1);
+        for_n (i64, k, vm->pfor_chunk_count) {
+            dk_vm_chunk *chunk = &vm->chunks[k];
+            chunk->fuel = chunk->status == DK_VM_STATUS_RUNNING ? share : 0;
+            if (chunk->fuel == 0) {
+                continue;
+            }
+
+            if (vm->jobs) {
+                job_push(vm->jobs, &group, dk_vm_chunk_proc, chunk);
+            } else {
+                dk_vm_chunk_proc(chunk);
+            }
+        }
+
+        if (vm->jobs) {
+            job_wait(vm->jobs, &group);
+        }
+
+        for_n (i64, k, vm->pfor_chunk_count) {
+            dk_vm_chunk *chunk = &vm->chunks[k];
+            if (chunk->fuel > 0) {
+                *fuel -= chunk->fuel - chunk->vm->fuel_left;
+            }
+        }
+    }
+
+    bool done = true;
+    for_n (i64, k, vm->pfor_chunk_count) {
+        done &= vm->chunks[k].status != DK_VM_STATUS_RUNNING;
+    }
+    return done;
+}
+
+// NOTE(rune): Combines in chunk order, so output and reductions are the same on every run. Chunks after the first
+// failed one are discarded, as if the loop had stopped there.
+static bool dk_vm_pfor_finish(dk_vm *vm, dk_call_frame *frame, dk_bc_pfor_header *header, dk_bc_pfor_reduction *reductions,
+                              str_list *output, arena *output_arena) {
+    u64 *locals = dk_buffer_get(&vm->call_stack, frame->loc_base, frame->loc_size);
+
+    bool ok = true;
+    for (i64 k = 0; k < vm->pfor_chunk_count && ok; k++) {
+        dk_vm_chunk *chunk = &vm->chunks[k];
+        for_list (str_node, node, chunk->output) {
+            str_list_push(output, output_arena, arena_copy_str(output_arena, node->v));
+        }
+
+        ok = chunk->status == DK_VM_STATUS_DONE;
+
+        dk_call_frame *chunk_frame = dk_buffer_get(&chunk->vm->call_stack, 0, sizeof(dk_call_frame));
+        u64 *chunk_locals = dk_buffer_get(&chunk->vm->call_stack, chunk_frame->loc_base, chunk_frame->loc_size);
+        for (u64 i = 0; i < header->reduction_count && ok; i++) {
+            dk_bc_pfor_reduction *reduction = &reductions[i];
+            u64 result = 0;
+            if (dk_fold_opcode(reduction->opcode, locals[reduction->off], chunk_locals[reduction->off], reduction->src != 0, &result)) {
+                locals[reduction->off] = result;
+            } else {
+                str_list_push_fmt(output, output_arena, "Runtime error: Integer overflow at line %, column %.\n",
+                                  dk_src_operand_row(reduction->src),
+                                  dk_src_operand_col(reduction->src));
+                ok = false;
+            }
+        }
+    }
+
+    vm->pfor_chunk_count = 0;
+    return ok;
+}
+
+static void dk_vm_chunk_proc(void *param) {
+    dk_vm_chunk *chunk = param;
+    dk_input input = dk_input_from_str(str(""));
+    chunk->status = dk_vm_resume(chunk->vm, chunk->fuel, &input, &chunk->output, chunk->arena);
+}
+
+static void dk_vm_destroy(dk_vm *vm) {
+    if (vm->chunks) {
+        for_n (i64, k, DK_VM_CHUNK_COUNT) {
+            if (vm->chunks[k].vm) {
+                dk_vm_destroy(vm->chunks[k].vm);
+                heap_free(vm->chunks[k].vm);
+                arena_destroy(vm->chunks[k].arena);
+            }
+        }
+        heap_free(vm->chunks);
+    }
+
+    dk_map_destroy_all(&vm->maps);
+    heap_free(vm->data_stack.data);
+    heap_free(vm->call_stack.data);
+    heap_free(vm->globals.data);
+    mem_zero_struct(vm);
+}
+
+static str dk_run_program(dk_program program, dk_input *input, job_system *jobs, arena *output_arena) {
+    // rune: Entry point is the first function.
+    dk_bc_symbol entry = { 0 };
+    dk_bc_symbol *symbols = (dk_bc_symbol *)program.head.data;
+    for_n (i64, i, program.head.size / (i64)sizeof(dk_bc_symbol)) {
+        if (symbols[i].pos == 0) {
+            entry = symbols[i];
+        }
+    }
+
+    dk_vm vm = { 0 };
+    vm.jobs = jobs;
+    str_list output_list = { 0 };
+    bool ok = dk_vm_call(&vm, &program, &entry, null, 0, input, &output_list, output_arena);
+
+    if (vm.data_stack.size != 8 && ok) {
+        str_list_push_fmt(&output_list, output_arena, "Invalid stack size on exit. Was % but expected %.", vm.data_stack.size, 8);
     }
 
+    dk_vm_destroy(&vm);
+
     str output = str_list_concat(&output_list, output_arena);
     return output;
 }
 
+////////////////////////////////////////////////////////////////
+// rune: Runtime traps
+
+// NOTE(rune): Handlers the host had installed before us, so faults outside of a running program reach them.
+#if _WIN32
+static readonly int dk_trap_signals[] = { SIGFPE, SIGSEGV };
+static void (*dk_trap_prev_handlers[countof(dk_trap_signals)])(int);
+#else
+static readonly int dk_trap_signals[] = { SIGFPE, SIGSEGV, SIGBUS };
+static struct sigaction dk_trap_prev_actions[countof(dk_trap_signals)];
+#endif
+
+// NOTE(rune): The first thread to get here installs the handlers, and other threads wait until it is done.
+static void dk_trap_install(void) {
+    static volatile i64 state = 0; // NOTE(rune): 0 = not installed, 1 = installing, 2 = installed.
+    if (atomic_load_i64(&state) == 2) {
+        return;
+    }
+
+    if (atomic_cas_i64(&state, 0, 1)) {
+        for_n (i64, i, countof(dk_trap_signals)) {
+#if _WIN32
+            dk_trap_prev_handlers[i] = signal(dk_trap_signals[i], dk_trap_handler);
+#else
+            struct sigaction action = { 0 };
+            action.sa_sigaction = dk_trap_handler;
+            action.sa_flags     = SA_SIGINFO;
+            sigemptyset(&action.sa_mask);
+            sigaction(dk_trap_signals[i], &action, &dk_trap_prev_actions[i]);
+#endif
+        }
+        atomic_store_i64(&state, 2);
+    } else {
+        while (atomic_load_i64(&state) != 2) {
+            os_thread_sleep(0);
+        }
+    }
+}
+
+#if _WIN32
+static void dk_trap_handler(int sig) {
+    dk_trap *trap = dk_active_trap;
+    if (trap) {
+        signal(sig, dk_trap_handler); // NOTE(rune): The CRT resets the handler before calling it.
+        dk_trap_jump(trap, sig);
+    } else {
+        // NOTE(rune): Fault outside of dk_vm_call(), so it belongs to the host. Pass it on to the previous
+        // handler, or put the previous disposition back, so that returning re-runs the faulting instruction
+        // and terminates the process as usual.
+        for_n (i64, i, countof(dk_trap_signals)) {
+            if (dk_trap_signals[i] == sig) {
+                void (*prev)(int) = dk_trap_prev_handlers[i];
+                if (prev != SIG_DFL && prev != SIG_IGN && prev != SIG_ERR) {
+                    prev(sig);
+                } else {
+                    signal(sig, prev == SIG_ERR ? SIG_DFL : prev);
+                }
+            }
+        }
+    }
+}
+#else
+static void dk_trap_handler(int sig, siginfo_t *info, void *context) {
+    dk_trap *trap = dk_active_trap;
+    if (trap) {
+        dk_trap_jump(trap, sig);
+    } else {
+        // NOTE(rune): Fault outside of dk_vm_call(), so it belongs to the host. Pass it on to the previous
+        // handler, or put the previous disposition back, so that returning re-runs the faulting instruction
+        // and terminates the process as usual.
+        for_n (i64, i, countof(dk_trap_signals)) {
+            if (dk_trap_signals[i] == sig) {
+                struct sigaction *prev = &dk_trap_prev_actions[i];
+                if (prev->sa_flags & SA_SIGINFO) {
+                    prev->sa_sigaction(sig, info, context);
+                } else if (prev->sa_handler != SIG_DFL && prev->sa_handler != SIG_IGN) {
+                    prev->sa_handler(sig);
+                } else {
+                    sigaction(sig, prev, null);
+                }
+            }
+        }
+    }
+}
+#endif
+
+// NOTE(rune): The handler runs with its signal blocked, and dk_trap_set() doesn't save the mask, so jumping
+// out of the handler leaves the signal blocked. A later fault on the same thread would then kill the process.
+static void dk_trap_unblock(int sig) {
+#if _WIN32
+    unused(sig);
+#else
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, sig);
+    pthread_sigmask(SIG_UNBLOCK, &set, null);
+#endif
+}
+
+static str dk_trap_message(int sig) {
+    str ret = str("Unknown fault.");
+    switch (sig) {
+        case SIGFPE:  ret = str("Integer division by zero or overflow."); break;
+        case SIGSEGV: ret = str("Invalid memory access.");                break;
+#if !_WIN32
+        case SIGBUS:  ret = str("Invalid memory access.");                break;
+#endif
+    }
+    return ret;
+}
+
+// NOTE(rune): Symbols are emitted in the same order as the function bodies, so the function containing pos
+// is the last one that begins before it.
+static dk_bc_symbol *dk_symbol_from_pos(dk_bc_symbol *symbols, i64 symbol_count, i64 pos) {
+    dk_bc_symbol *ret = null;
+    for_n (i64, i, symbol_count) {
+        if (symbols[i].pos <= pos) {
+            ret = &symbols[i];
+        }
+    }
+    return ret;
+}
+
 ////////////////////////////////////////////////////////////////
 // rune: High level api
 
-static dk_tree *dk_tree_from_token_list(dk_token_list tokens, arena *arena) {
+static dk_tree *dk_tree_from_token_list(dk_token_list tokens, dk_ctx *ctx) {
     dk_parser p = { 0 };
-    dk_parser_init(&p, tokens, arena);
+    dk_parser_init(&p, tokens, ctx);
     dk_tree *tree = dk_parse_tree(&p);
     return tree;
 }
 
-static dk_program dk_program_from_str(str s, dk_err_sink *err, arena *arena) {
-    dk_global_err = err; // TODO(rune): Remove global.
-
-    dk_token_list tokens = dk_token_list_from_str(s, arena);
-    dk_tree *tree = dk_tree_from_token_list(tokens, arena);
-    dk_check_tree(tree, arena);
-    dk_program program = dk_program_from_tree(tree);
+static dk_program dk_program_from_str(str s, dk_build_flags flags, dk_ctx *ctx) {
+    dk_token_list tokens = dk_token_list_from_str(s, ctx);
+    dk_tree *tree = dk_tree_from_token_list(tokens, ctx);
+    dk_check_tree(tree, flags, ctx);
+    dk_program program = dk_program_from_tree(tree, flags, ctx);
     return program;
 }
 
@@ -1780,6 +4739,7 @@ static void dk_print_literal(dk_literal literal, i64 level) {
         case DK_LITERAL_KIND_INT:   println("literal/int %", literal.int_);     break;
         case DK_LITERAL_KIND_FLOAT: println("literal/float %", literal.float_); break;
         case DK_LITERAL_KIND_BOOL:  println("literal/bool %", literal.bool_);   break;
+        case DK_LITERAL_KIND_TEXT:  println("literal/text \"%\"", literal.text_); break;
         default:                    assert(false && "Invalid literal kind");    break;
     }
 }
@@ -1841,7 +4801,16 @@ static void dk_print_stmt(dk_stmt *stmt, i64 level) {
     dk_print_level(level);
     switch (stmt->kind) {
         case DK_STMT_KIND_DECL: {
-            println("stmt/decl %(literal)    %(literal)", stmt->name, stmt->type_name);
+            if (stmt->list_count > 0) {
+                println("stmt/decl %(literal)    %list of % %(literal)", stmt->name, stmt->list_soa ? "soa " : "", stmt->list_count, stmt->type_name);
+            } else {
+                println("stmt/decl %(literal)    %(literal)", stmt->name, stmt->type_name);
+            }
+        } break;
+
+        case DK_STMT_KIND_CONST: {
+            println("stmt/const %(literal)", stmt->name);
+            dk_print_literal(stmt->literal, level + 1);
         } break;
 
         case DK_STMT_KIND_EXPR: {
@@ -1883,6 +4852,49 @@ static void dk_print_stmt(dk_stmt *stmt, i64 level) {
             }
         } break;
 
+        case DK_STMT_KIND_SWITCH: {
+            println("stmt/switch");
+            if (stmt->expr) {
+                dk_print_expr(stmt->expr, level + 1);
+            } else {
+                dk_print_clause_list(stmt->clauses, level + 1);
+            }
+
+            dk_print_stmt_list(stmt->then, level + 1);
+
+            dk_print_level(level + 1);
+            println("default");
+            dk_print_stmt_list(stmt->else_, level + 2);
+        } break;
+
+        case DK_STMT_KIND_PFOR: {
+            println("stmt/pfor %(literal)", stmt->name);
+            if (stmt->expr) {
+                dk_print_expr(stmt->expr, level + 1);
+                dk_print_expr(stmt->end_expr, level + 1);
+            } else {
+                dk_print_clause_list(stmt->clauses, level + 1);
+                dk_print_clause_list(stmt->end_clauses, level + 1);
+            }
+
+            dk_print_level(level + 1);
+            println("then");
+            dk_print_stmt_list(stmt->then, level + 2);
+        } break;
+
+        case DK_STMT_KIND_CASE: {
+            println("stmt/case");
+            if (stmt->labels.first) {
+                dk_print_expr_list(stmt->labels, level + 1);
+            } else {
+                dk_print_clause_list(stmt->clauses, level + 1);
+            }
+
+            dk_print_level(level + 1);
+            println("then");
+            dk_print_stmt_list(stmt->then, level + 2);
+        } break;
+
         default: {
             assert(false && "Invalid stmt kind.");
         } break;
@@ -1925,6 +4937,10 @@ static void dk_print_func_list(dk_func_list funcs, i64 level) {
 static void dk_print_type(dk_type *type, i64 level) {
     dk_print_level(level);
     println("type % size %", type->name, type->size);
+    for_list (dk_field, field, type->fields) {
+        dk_print_level(level + 1);
+        println("field %(literal)    %(literal) off %", field->name, field->type_name, field->off);
+    }
 }
 
 static void dk_print_type_list(dk_type_list types, i64 level) {
@@ -1951,6 +4967,11 @@ static void dk_print_expr(dk_expr *expr, i64 level) {
             dk_print_local(expr->local, level + 1);
         } break;
 
+        case DK_EXPR_KIND_GLOBAL: {
+            println("expr/global type %(literal)", expr->type->name);
+            dk_print_local(expr->local, level + 1);
+        } break;
+
         case DK_EXPR_KIND_LIST: {
             println("expr/list");
             dk_print_expr_list(expr->list, level + 1);
@@ -1961,6 +4982,21 @@ static void dk_print_expr(dk_expr *expr, i64 level) {
             dk_print_expr_list(expr->func_args, level + 1);
         } break;
 
+        case DK_EXPR_KIND_INDEX: {
+            println("expr/index type %(literal)%", expr->type->name, (expr->flags & DK_EXPR_FLAG_UNCHECKED) ? " unchecked" : "");
+            dk_print_expr_list(expr->func_args, level + 1);
+        } break;
+
+        case DK_EXPR_KIND_FIELD: {
+            println("expr/field %(literal) type %(literal)%", expr->field->name, expr->type->name, (expr->flags & DK_EXPR_FLAG_UNCHECKED) ? " unchecked" : "");
+            dk_print_expr_list(expr->func_args, level + 1);
+        } break;
+
+        case DK_EXPR_KIND_BULK: {
+            println("expr/bulk % type %(literal)", dk_bulk_op_names[expr->func->bulk_op], expr->type->name);
+            dk_print_expr_list(expr->func_args, level + 1);
+        } break;
+
         default: {
             assert(false && "Invalid expr kind.");
         } break;
@@ -1977,6 +5013,7 @@ static void dk_print_tree(dk_tree *tree, i64 level) {
     dk_print_level(level);
     println("tree");
     dk_print_type_list(tree->types, level + 1);
+    dk_print_stmt_list(tree->globals, level + 1);
     dk_print_func_list(tree->funcs, level + 1);
 }
 
@@ -2000,7 +5037,7 @@ static void dk_print_program(dk_program program) {
         i64 read_pos = 0;
         while (read_pos < head->size) {
             dk_bc_symbol *symbol = dk_buffer_read_struct(head, &read_pos, dk_bc_symbol);
-            print(ANSI_FG_CYAN "%(hexpad)" ANSI_FG_DEFAULT " %(hexpad)" ANSI_FG_GRAY " %(hexpad)\n", symbol->id, symbol->size, symbol->pos);
+            print(ANSI_FG_CYAN "%(hexpad)" ANSI_FG_DEFAULT " %(hexpad)" ANSI_FG_GRAY " %(hexpad)" ANSI_FG_DEFAULT " %\n", symbol->id, symbol->size, symbol->pos, symbol->name);
         }
     }
 
@@ -2018,18 +5055,60 @@ static void dk_print_program(dk_program program) {
             print(" %\t", opcode_info->name);
 
             any operand = { 0 };
+            u64 operand_u64 = 0;
             if (opcode_info->operand_kind != DK_BC_OPERAND_KIND_NONE) {
                 switch (prefix.operand_size) {
-                    case 0: operand = anyof(dk_buffer_read_u8(body, &read_pos)); break;
-                    case 1: operand = anyof(dk_buffer_read_u16(body, &read_pos)); break;
-                    case 2: operand = anyof(dk_buffer_read_u32(body, &read_pos)); break;
-                    case 3: operand = anyof(dk_buffer_read_u64(body, &read_pos)); break;
+                    case 0: operand_u64 = dk_buffer_read_u8(body, &read_pos);  operand = anyof(u8(operand_u64));  break;
+                    case 1: operand_u64 = dk_buffer_read_u16(body, &read_pos); operand = anyof(u16(operand_u64)); break;
+                    case 2: operand_u64 = dk_buffer_read_u32(body, &read_pos); operand = anyof(u32(operand_u64)); break;
+                    case 3: operand_u64 = dk_buffer_read_u64(body, &read_pos); operand = anyof(u64(operand_u64)); break;
                 }
 
                 if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_IMM) print(ANSI_FG_MAGENTA "%(hexpad)", operand);
                 if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_SYM) print(ANSI_FG_CYAN    "%(hexpad)", operand);
                 if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_LOC) print(ANSI_FG_GREEN   "%(hexpad)", operand);
+                if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_GLB) print(ANSI_FG_YELLOW  "%(hexpad)", operand);
                 if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_POS) print(ANSI_FG_GRAY    "%(hexpad)", operand);
+                if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_TAB) print(ANSI_FG_MAGENTA "%(hexpad)", operand);
+                if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_FIELD) {
+                    print(ANSI_FG_GREEN "%" ANSI_FG_MAGENTA " %+%*i%",
+                          dk_field_operand_off(operand_u64),
+                          dk_field_operand_start(operand_u64),
+                          dk_field_operand_stride(operand_u64),
+                          dk_field_operand_unchecked(operand_u64) ? " unchecked" : "");
+                }
+                if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_SRC) {
+                    print(ANSI_FG_GRAY "%:%", dk_src_operand_row(operand_u64), dk_src_operand_col(operand_u64));
+                }
+                if (opcode_info->operand_kind == DK_BC_OPERAND_KIND_BULK) {
+                    dk_bulk_kernel kernel = dk_bulk_operand_kernel(operand_u64);
+                    print(ANSI_FG_MAGENTA "%%" ANSI_FG_GREEN " % %%",
+                          dk_bulk_kernel_is_float(kernel) ? "f" : "i",
+                          dk_bulk_op_names[dk_bulk_op_from_kernel(kernel)],
+                          dk_bulk_operand_dst(operand_u64),
+                          dk_bulk_operand_src(operand_u64),
+                          dk_bulk_operand_checked(operand_u64) ? " checked" : "");
+                }
+            }
+
+            // rune: Inline jump table.
+            if (prefix.opcode == DK_BC_OPCODE_SWITCH) {
+                dk_bc_switch_header *header = dk_buffer_read_struct(body, &read_pos, dk_bc_switch_header);
+                print(ANSI_FG_GRAY " % default %(hexpad)", header->kind == DK_BC_SWITCH_KIND_DENSE ? "dense" : "sparse", header->default_pos);
+                for_n (u64, i, operand_u64) {
+                    dk_bc_switch_entry *entry = dk_buffer_read_struct(body, &read_pos, dk_bc_switch_entry);
+                    print("\n\t\t% -> %(hexpad)", entry->key, entry->pos);
+                }
+            }
+
+            // rune: Samtidig loop header and reductions.
+            if (prefix.opcode == DK_BC_OPCODE_PFOR) {
+                dk_bc_pfor_header *header = dk_buffer_read_struct(body, &read_pos, dk_bc_pfor_header);
+                print(ANSI_FG_GREEN " index % end %", header->index_off, header->end_off);
+                for_n (u64, i, header->reduction_count) {
+                    dk_bc_pfor_reduction *reduction = dk_buffer_read_struct(body, &read_pos, dk_bc_pfor_reduction);
+                    print("\n\t\t% %", dk_bc_opcode_infos[reduction->opcode].name, reduction->off);
+                }
             }
 
             print(ANSI_FG_DEFAULT);
@@ -6,11 +6,16 @@
 #define DK_DEBUG_PRINT_CHECK    0
 #define DK_DEBUG_PRINT_EMIT     0
 
+// NOTE(rune): Selected per program on the command line. Programs are built checked by default, where integer
+// arithmetic traps on overflow and division by zero, and reports the source location. Unchecked programs use
+// the plain wrapping instructions, and division by zero is undefined.
+typedef enum dk_build_flags {
+    DK_BUILD_FLAG_UNCHECKED = 1,
+} dk_build_flags;
+
 ////////////////////////////////////////////////////////////////
 // rune: Errors
 
-static arena *temp_arena = { 0 };
-
 // TODO(rune): Think about a smarter way to report source code locations.
 // currently most of the ast's memory usage is dk_loc structs.
 typedef struct dk_loc dk_loc;
@@ -40,10 +45,23 @@ struct dk_err_sink {
     dk_err_list err_list;
 };
 
-#define                 dk_tprint(...) dk_tprint_args(argsof(__VA_ARGS__))
-static str              dk_tprint_args(args args);
+////////////////////////////////////////////////////////////////
+// rune: Context
+
+// NOTE(rune): Everything the tokenizer, parser, checker and emitter share while building a program. There is no
+// process-wide state, so several threads can build programs at once, each with its own context. Contexts may
+// share a job system.
+typedef struct dk_ctx dk_ctx;
+struct dk_ctx {
+    dk_err_sink *err;
+    arena *arena;       // NOTE(rune): Tree, checker data and error messages.
+    job_system *jobs;   // NOTE(rune): Optional. Function bodies are checked and emitted serially without it.
+};
 
-static void dk_report_err(dk_err_sink *sink, dk_loc loc, str msg);
+#define                 dk_tprint(ctx, ...) dk_tprint_args((ctx), argsof(__VA_ARGS__))
+static str              dk_tprint_args(dk_ctx *ctx, args args);
+
+static void dk_report_err(dk_ctx *ctx, dk_loc loc, str msg);
 static void dk_print_err(dk_err *err, arena *arena);
 
 ////////////////////////////////////////////////////////////////
@@ -57,6 +75,34 @@ typedef enum dk_bc_opcode {
     DK_BC_OPCODE_STL,
     DK_BC_OPCODE_POP,
     DK_BC_OPCODE_DUP,
+    DK_BC_OPCODE_LDG,
+    DK_BC_OPCODE_STG,
+
+    DK_BC_OPCODE_LDX,
+    DK_BC_OPCODE_STX,
+    DK_BC_OPCODE_LDXU,
+    DK_BC_OPCODE_STXU,
+    DK_BC_OPCODE_BULK,
+    DK_BC_OPCODE_LDF,
+    DK_BC_OPCODE_STF,
+
+    // NOTE(rune): Width specific instructions must be in 8, 16, 32 order, see dk_packed_opcode().
+    DK_BC_OPCODE_LDL8,
+    DK_BC_OPCODE_LDL16,
+    DK_BC_OPCODE_LDL32,
+    DK_BC_OPCODE_STL8,
+    DK_BC_OPCODE_STL16,
+    DK_BC_OPCODE_STL32,
+    DK_BC_OPCODE_LDF8,
+    DK_BC_OPCODE_LDF16,
+    DK_BC_OPCODE_LDF32,
+    DK_BC_OPCODE_STF8,
+    DK_BC_OPCODE_STF16,
+    DK_BC_OPCODE_STF32,
+    DK_BC_OPCODE_SEXT8,
+    DK_BC_OPCODE_SEXT16,
+    DK_BC_OPCODE_SEXT32,
+    DK_BC_OPCODE_ZEXT8,
 
     DK_BC_OPCODE_ADD,
     DK_BC_OPCODE_SUB,
@@ -64,12 +110,58 @@ typedef enum dk_bc_opcode {
     DK_BC_OPCODE_IMUL,
     DK_BC_OPCODE_UDIV,
     DK_BC_OPCODE_IDIV,
+    DK_BC_OPCODE_MOD,
+
+    DK_BC_OPCODE_ADDC,
+    DK_BC_OPCODE_SUBC,
+    DK_BC_OPCODE_IMULC,
+    DK_BC_OPCODE_IDIVC,
+    DK_BC_OPCODE_MODC,
+
+    DK_BC_OPCODE_BAND,
+    DK_BC_OPCODE_BOR,
+    DK_BC_OPCODE_BXOR,
+    DK_BC_OPCODE_SHL,
+    DK_BC_OPCODE_SHR,
 
     DK_BC_OPCODE_FADD,
     DK_BC_OPCODE_FSUB,
     DK_BC_OPCODE_FMUL,
     DK_BC_OPCODE_FDIV,
 
+    DK_BC_OPCODE_IABS,
+    DK_BC_OPCODE_IMIN,
+    DK_BC_OPCODE_IMAX,
+
+    DK_BC_OPCODE_FSQRT,
+    DK_BC_OPCODE_FFLOOR,
+    DK_BC_OPCODE_FABS,
+    DK_BC_OPCODE_FMIN,
+    DK_BC_OPCODE_FMAX,
+    DK_BC_OPCODE_FPOW,
+
+    DK_BC_OPCODE_VMAKE,
+    DK_BC_OPCODE_VADD,
+    DK_BC_OPCODE_VMUL,
+    DK_BC_OPCODE_VFMA,
+
+    DK_BC_OPCODE_TLEN,
+    DK_BC_OPCODE_TEQ,
+    DK_BC_OPCODE_TFIND,
+    DK_BC_OPCODE_TSLICE,
+
+    DK_BC_OPCODE_MAPNEW,
+    DK_BC_OPCODE_MAPFREE,
+    DK_BC_OPCODE_MAPPUT,
+    DK_BC_OPCODE_MAPGET,
+    DK_BC_OPCODE_MAPDEL,
+    DK_BC_OPCODE_MAPHAS,
+    DK_BC_OPCODE_MAPLEN,
+
+    DK_BC_OPCODE_INI,
+    DK_BC_OPCODE_INF,
+    DK_BC_OPCODE_INMORE,
+
     DK_BC_OPCODE_AND,
     DK_BC_OPCODE_OR,
     DK_BC_OPCODE_NOT,
@@ -85,6 +177,9 @@ typedef enum dk_bc_opcode {
     DK_BC_OPCODE_CALL,
     DK_BC_OPCODE_RET,
     DK_BC_OPCODE_BR,
+    DK_BC_OPCODE_JMP,
+    DK_BC_OPCODE_SWITCH,
+    DK_BC_OPCODE_PFOR,
 
     DK_BC_OPCODE_I2F,
     DK_BC_OPCODE_F2I,
@@ -98,14 +193,19 @@ typedef enum dk_bc_operand_kind {
     DK_BC_OPERAND_KIND_LOC,
     DK_BC_OPERAND_KIND_SYM,
     DK_BC_OPERAND_KIND_POS,
+    DK_BC_OPERAND_KIND_TAB,
+    DK_BC_OPERAND_KIND_BULK,
+    DK_BC_OPERAND_KIND_FIELD,
+    DK_BC_OPERAND_KIND_SRC,
+    DK_BC_OPERAND_KIND_GLB,
 
     DK_BC_OPERAND_KIND_COUNT,
 } dk_bc_operand_kind;
 
 typedef union dk_bc_inst_prefix dk_bc_inst_prefix;
 union dk_bc_inst_prefix {
-    struct { u8 opcode : 6, operand_size : 2; };
-    struct { u8 u8; };
+    struct { u16 opcode : 14, operand_size : 2; };
+    struct { u16 u16; };
 };
 
 typedef struct dk_bc_inst dk_bc_inst;
@@ -128,6 +228,33 @@ static readonly dk_bc_opcode_info dk_bc_opcode_infos[DK_BC_OPCODE_COUNT] = {
     [DK_BC_OPCODE_POP]   = { STR("pop"),                                 },
     [DK_BC_OPCODE_STL]   = { STR("stl"),      DK_BC_OPERAND_KIND_LOC     },
     [DK_BC_OPCODE_DUP]   = { STR("dup"),                                 },
+    [DK_BC_OPCODE_LDG]   = { STR("ldg"),      DK_BC_OPERAND_KIND_GLB     },
+    [DK_BC_OPCODE_STG]   = { STR("stg"),      DK_BC_OPERAND_KIND_GLB     },
+
+    [DK_BC_OPCODE_LDX]   = { STR("ldx"),      DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STX]   = { STR("stx"),      DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_LDXU]  = { STR("ldxu"),     DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STXU]  = { STR("stxu"),     DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_BULK]  = { STR("bulk"),     DK_BC_OPERAND_KIND_BULK    },
+    [DK_BC_OPCODE_LDF]   = { STR("ldf"),      DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_STF]   = { STR("stf"),      DK_BC_OPERAND_KIND_FIELD   },
+
+    [DK_BC_OPCODE_LDL8]  = { STR("ldl8"),     DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_LDL16] = { STR("ldl16"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_LDL32] = { STR("ldl32"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STL8]  = { STR("stl8"),     DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STL16] = { STR("stl16"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STL32] = { STR("stl32"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_LDF8]  = { STR("ldf8"),     DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_LDF16] = { STR("ldf16"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_LDF32] = { STR("ldf32"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_STF8]  = { STR("stf8"),     DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_STF16] = { STR("stf16"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_STF32] = { STR("stf32"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_SEXT8] = { STR("sext8"),                               },
+    [DK_BC_OPCODE_SEXT16]= { STR("sext16"),                              },
+    [DK_BC_OPCODE_SEXT32]= { STR("sext32"),                              },
+    [DK_BC_OPCODE_ZEXT8] = { STR("zext8"),                               },
 
     [DK_BC_OPCODE_ADD]   = { STR("add"),                                 },
     [DK_BC_OPCODE_SUB]   = { STR("sub"),                                 },
@@ -135,12 +262,58 @@ static readonly dk_bc_opcode_info dk_bc_opcode_infos[DK_BC_OPCODE_COUNT] = {
     [DK_BC_OPCODE_IMUL]  = { STR("imul"),                                },
     [DK_BC_OPCODE_UDIV]  = { STR("udiv"),                                },
     [DK_BC_OPCODE_IDIV]  = { STR("idiv"),                                },
+    [DK_BC_OPCODE_MOD]   = { STR("mod"),                                 },
+
+    [DK_BC_OPCODE_ADDC]  = { STR("addc"),     DK_BC_OPERAND_KIND_SRC     },
+    [DK_BC_OPCODE_SUBC]  = { STR("subc"),     DK_BC_OPERAND_KIND_SRC     },
+    [DK_BC_OPCODE_IMULC] = { STR("imulc"),    DK_BC_OPERAND_KIND_SRC     },
+    [DK_BC_OPCODE_IDIVC] = { STR("idivc"),    DK_BC_OPERAND_KIND_SRC     },
+    [DK_BC_OPCODE_MODC]  = { STR("modc"),     DK_BC_OPERAND_KIND_SRC     },
+
+    [DK_BC_OPCODE_BAND]  = { STR("band"),                                },
+    [DK_BC_OPCODE_BOR]   = { STR("bor"),                                 },
+    [DK_BC_OPCODE_BXOR]  = { STR("bxor"),                                },
+    [DK_BC_OPCODE_SHL]   = { STR("shl"),                                 },
+    [DK_BC_OPCODE_SHR]   = { STR("shr"),                                 },
 
     [DK_BC_OPCODE_FADD]  = { STR("fadd"),                                },
     [DK_BC_OPCODE_FSUB]  = { STR("fsub"),                                },
     [DK_BC_OPCODE_FMUL]  = { STR("fmul"),                                },
     [DK_BC_OPCODE_FDIV]  = { STR("fdiv"),                                },
 
+    [DK_BC_OPCODE_IABS]  = { STR("iabs"),                                },
+    [DK_BC_OPCODE_IMIN]  = { STR("imin"),                                },
+    [DK_BC_OPCODE_IMAX]  = { STR("imax"),                                },
+
+    [DK_BC_OPCODE_FSQRT] = { STR("fsqrt"),                               },
+    [DK_BC_OPCODE_FFLOOR]= { STR("ffloor"),                              },
+    [DK_BC_OPCODE_FABS]  = { STR("fabs"),                                },
+    [DK_BC_OPCODE_FMIN]  = { STR("fmin"),                                },
+    [DK_BC_OPCODE_FMAX]  = { STR("fmax"),                                },
+    [DK_BC_OPCODE_FPOW]  = { STR("fpow"),                                },
+
+    [DK_BC_OPCODE_VMAKE] = { STR("vmake"),                               },
+    [DK_BC_OPCODE_VADD]  = { STR("vadd"),                                },
+    [DK_BC_OPCODE_VMUL]  = { STR("vmul"),                                },
+    [DK_BC_OPCODE_VFMA]  = { STR("vfma"),                                },
+
+    [DK_BC_OPCODE_TLEN]  = { STR("tlen"),                                },
+    [DK_BC_OPCODE_TEQ]   = { STR("teq"),                                 },
+    [DK_BC_OPCODE_TFIND] = { STR("tfind"),                               },
+    [DK_BC_OPCODE_TSLICE]= { STR("tslice"),                              },
+
+    [DK_BC_OPCODE_MAPNEW]  = { STR("mapnew"),   DK_BC_OPERAND_KIND_LOC   },
+    [DK_BC_OPCODE_MAPFREE] = { STR("mapfree"),  DK_BC_OPERAND_KIND_LOC   },
+    [DK_BC_OPCODE_MAPPUT]  = { STR("mapput"),                            },
+    [DK_BC_OPCODE_MAPGET]  = { STR("mapget"),                            },
+    [DK_BC_OPCODE_MAPDEL]  = { STR("mapdel"),                            },
+    [DK_BC_OPCODE_MAPHAS]  = { STR("maphas"),                            },
+    [DK_BC_OPCODE_MAPLEN]  = { STR("maplen"),                            },
+
+    [DK_BC_OPCODE_INI]     = { STR("ini"),                               },
+    [DK_BC_OPCODE_INF]     = { STR("inf"),                               },
+    [DK_BC_OPCODE_INMORE]  = { STR("inmore"),                            },
+
     [DK_BC_OPCODE_AND]   = { STR("and"),                                 },
     [DK_BC_OPCODE_OR]    = { STR("or"),                                  },
     [DK_BC_OPCODE_NOT]   = { STR("not"),                                 },
@@ -156,6 +329,9 @@ static readonly dk_bc_opcode_info dk_bc_opcode_infos[DK_BC_OPCODE_COUNT] = {
     [DK_BC_OPCODE_CALL]  = { STR("call"),     DK_BC_OPERAND_KIND_SYM     },
     [DK_BC_OPCODE_RET]   = { STR("ret"),                                 },
     [DK_BC_OPCODE_BR]    = { STR("br"),       DK_BC_OPERAND_KIND_POS     },
+    [DK_BC_OPCODE_JMP]   = { STR("jmp"),      DK_BC_OPERAND_KIND_POS     },
+    [DK_BC_OPCODE_SWITCH]= { STR("switch"),   DK_BC_OPERAND_KIND_TAB     },
+    [DK_BC_OPCODE_PFOR]  = { STR("pfor"),     DK_BC_OPERAND_KIND_POS     },
 
     [DK_BC_OPCODE_I2F]   = { STR("i2f"),                                 },
     [DK_BC_OPCODE_F2I]   = { STR("f2i"),                                 },
@@ -165,6 +341,33 @@ static readonly dk_bc_opcode_info dk_bc_opcode_infos[DK_BC_OPCODE_COUNT] = {
     [DK_BC_OPCODE_LDL]   = { STR("ill"),      DK_BC_OPERAND_KIND_LOC     }, // Indlæs lokal
     [DK_BC_OPCODE_POP]   = { STR("tag"),                                 },
     [DK_BC_OPCODE_STL]   = { STR("gel"),      DK_BC_OPERAND_KIND_LOC     }, // Gem lokal
+    [DK_BC_OPCODE_LDG]   = { STR("ilg"),      DK_BC_OPERAND_KIND_GLB     }, // Indlæs global
+    [DK_BC_OPCODE_STG]   = { STR("geg"),      DK_BC_OPERAND_KIND_GLB     }, // Gem global
+
+    [DK_BC_OPCODE_LDX]   = { STR("ilp"),      DK_BC_OPERAND_KIND_LOC     }, // Indlæs plads
+    [DK_BC_OPCODE_STX]   = { STR("gep"),      DK_BC_OPERAND_KIND_LOC     }, // Gem plads
+    [DK_BC_OPCODE_LDXU]  = { STR("ilpu"),     DK_BC_OPERAND_KIND_LOC     }, // Indlæs plads, uden grænsetjek
+    [DK_BC_OPCODE_STXU]  = { STR("gepu"),     DK_BC_OPERAND_KIND_LOC     }, // Gem plads, uden grænsetjek
+    [DK_BC_OPCODE_BULK]  = { STR("masse"),    DK_BC_OPERAND_KIND_BULK    },
+    [DK_BC_OPCODE_LDF]   = { STR("ilf"),      DK_BC_OPERAND_KIND_FIELD   }, // Indlæs felt
+    [DK_BC_OPCODE_STF]   = { STR("gef"),      DK_BC_OPERAND_KIND_FIELD   }, // Gem felt
+
+    [DK_BC_OPCODE_LDL8]  = { STR("ill8"),     DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_LDL16] = { STR("ill16"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_LDL32] = { STR("ill32"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STL8]  = { STR("gel8"),     DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STL16] = { STR("gel16"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_STL32] = { STR("gel32"),    DK_BC_OPERAND_KIND_LOC     },
+    [DK_BC_OPCODE_LDF8]  = { STR("ilf8"),     DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_LDF16] = { STR("ilf16"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_LDF32] = { STR("ilf32"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_STF8]  = { STR("gef8"),     DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_STF16] = { STR("gef16"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_STF32] = { STR("gef32"),    DK_BC_OPERAND_KIND_FIELD   },
+    [DK_BC_OPCODE_SEXT8] = { STR("fudv8"),                               }, // Fortegnsudvid
+    [DK_BC_OPCODE_SEXT16]= { STR("fudv16"),                              },
+    [DK_BC_OPCODE_SEXT32]= { STR("fudv32"),                              },
+    [DK_BC_OPCODE_ZEXT8] = { STR("nudv8"),                               }, // Nuludvid
 
     [DK_BC_OPCODE_ADD]   = { STR("plus"),                                 },
     [DK_BC_OPCODE_SUB]   = { STR("minus"),                                 },
@@ -172,12 +375,58 @@ static readonly dk_bc_opcode_info dk_bc_opcode_infos[DK_BC_OPCODE_COUNT] = {
     [DK_BC_OPCODE_IMUL]  = { STR("igange"),                                },
     [DK_BC_OPCODE_UDIV]  = { STR("udel"),                                },
     [DK_BC_OPCODE_IDIV]  = { STR("idel"),                                },
+    [DK_BC_OPCODE_MOD]   = { STR("rest"),                                },
+
+    [DK_BC_OPCODE_ADDC]  = { STR("plusk"),    DK_BC_OPERAND_KIND_SRC     }, // Kontrolleret
+    [DK_BC_OPCODE_SUBC]  = { STR("minusk"),   DK_BC_OPERAND_KIND_SRC     },
+    [DK_BC_OPCODE_IMULC] = { STR("igangek"),  DK_BC_OPERAND_KIND_SRC     },
+    [DK_BC_OPCODE_IDIVC] = { STR("idelk"),    DK_BC_OPERAND_KIND_SRC     },
+    [DK_BC_OPCODE_MODC]  = { STR("restk"),    DK_BC_OPERAND_KIND_SRC     },
+
+    [DK_BC_OPCODE_BAND]  = { STR("bog"),                                 },
+    [DK_BC_OPCODE_BOR]   = { STR("belr"),                                },
+    [DK_BC_OPCODE_BXOR]  = { STR("bxelr"),                               },
+    [DK_BC_OPCODE_SHL]   = { STR("skv"),                                 }, // Skub venstre
+    [DK_BC_OPCODE_SHR]   = { STR("skh"),                                 }, // Skub højre
 
     [DK_BC_OPCODE_FADD]  = { STR("fplus"),                                },
     [DK_BC_OPCODE_FSUB]  = { STR("fminus"),                                },
     [DK_BC_OPCODE_FMUL]  = { STR("fgange"),                                },
     [DK_BC_OPCODE_FDIV]  = { STR("fdel"),                                },
 
+    [DK_BC_OPCODE_IABS]  = { STR("iabs"),                                },
+    [DK_BC_OPCODE_IMIN]  = { STR("imindst"),                             },
+    [DK_BC_OPCODE_IMAX]  = { STR("istørst"),                             },
+
+    [DK_BC_OPCODE_FSQRT] = { STR("frod"),                                },
+    [DK_BC_OPCODE_FFLOOR]= { STR("fned"),                                },
+    [DK_BC_OPCODE_FABS]  = { STR("fabs"),                                },
+    [DK_BC_OPCODE_FMIN]  = { STR("fmindst"),                             },
+    [DK_BC_OPCODE_FMAX]  = { STR("fstørst"),                             },
+    [DK_BC_OPCODE_FPOW]  = { STR("fopløft"),                             },
+
+    [DK_BC_OPCODE_VMAKE] = { STR("vlav"),                                },
+    [DK_BC_OPCODE_VADD]  = { STR("vplus"),                               },
+    [DK_BC_OPCODE_VMUL]  = { STR("vgange"),                              },
+    [DK_BC_OPCODE_VFMA]  = { STR("vgangeplus"),                          },
+
+    [DK_BC_OPCODE_TLEN]  = { STR("tlængde"),                             },
+    [DK_BC_OPCODE_TEQ]   = { STR("tlig"),                                },
+    [DK_BC_OPCODE_TFIND] = { STR("tsøg"),                                },
+    [DK_BC_OPCODE_TSLICE]= { STR("tudsnit"),                             },
+
+    [DK_BC_OPCODE_MAPNEW]  = { STR("onyt"),     DK_BC_OPERAND_KIND_LOC   }, // Ordbog ny
+    [DK_BC_OPCODE_MAPFREE] = { STR("ofri"),     DK_BC_OPERAND_KIND_LOC   }, // Ordbog frigiv
+    [DK_BC_OPCODE_MAPPUT]  = { STR("ogem"),                              },
+    [DK_BC_OPCODE_MAPGET]  = { STR("ohent"),                             },
+    [DK_BC_OPCODE_MAPDEL]  = { STR("ofjern"),                            },
+    [DK_BC_OPCODE_MAPHAS]  = { STR("ohar"),                              },
+    [DK_BC_OPCODE_MAPLEN]  = { STR("oantal"),                            },
+
+    [DK_BC_OPCODE_INI]     = { STR("læsh"),                              },
+    [DK_BC_OPCODE_INF]     = { STR("læsf"),                              },
+    [DK_BC_OPCODE_INMORE]  = { STR("mere"),                              },
+
     [DK_BC_OPCODE_AND]   = { STR("or"),                                 },
     [DK_BC_OPCODE_OR]    = { STR("elr"),                                  },
     [DK_BC_OPCODE_NOT]   = { STR("ikke"),                                 },
@@ -185,16 +434,114 @@ static readonly dk_bc_opcode_info dk_bc_opcode_infos[DK_BC_OPCODE_COUNT] = {
     [DK_BC_OPCODE_CALL]  = { STR("kald"),     DK_BC_OPERAND_KIND_SYM     },
     [DK_BC_OPCODE_RET]   = { STR("tilbage"),                                 },
     [DK_BC_OPCODE_BR]    = { STR("gren"),     DK_BC_OPERAND_KIND_POS     },
+    [DK_BC_OPCODE_JMP]   = { STR("hop"),      DK_BC_OPERAND_KIND_POS     },
+    [DK_BC_OPCODE_SWITCH]= { STR("vælg"),     DK_BC_OPERAND_KIND_TAB     },
+    [DK_BC_OPCODE_PFOR]  = { STR("samtidig"), DK_BC_OPERAND_KIND_POS     },
 #endif
 };
 
+// NOTE(rune): The switch instruction is followed by an inline jump table. The operand is the number of entries.
+// Dense tables have one entry for every key in [min, min + count), so the lookup is a single subtraction.
+// Sparse tables are sorted by key and searched with binary search.
+typedef enum dk_bc_switch_kind {
+    DK_BC_SWITCH_KIND_DENSE,
+    DK_BC_SWITCH_KIND_SPARSE,
+} dk_bc_switch_kind;
+
+typedef struct dk_bc_switch_header dk_bc_switch_header;
+struct dk_bc_switch_header {
+    u64 kind;
+    i64 min;
+    u64 default_pos;
+};
+
+typedef struct dk_bc_switch_entry dk_bc_switch_entry;
+struct dk_bc_switch_entry {
+    i64 key;
+    u64 pos;
+};
+
+// NOTE(rune): The pfor instruction pops the first and last index of a Samtidig loop, and is followed by a header
+// and one entry per reduction. The loop body follows the table, and the operand is the position after the body.
+// Each chunk of the index range runs the body on its own vm, with a copy of the current call frame, where the
+// index local holds the first index of the chunk, and the end local the last. The body loops over the chunk
+// itself, and ends with a ret. Reductions start out as the identity of their opcode in each chunk, and are
+// combined into the local of the current frame, in chunk order, once every chunk is done.
+typedef struct dk_bc_pfor_header dk_bc_pfor_header;
+struct dk_bc_pfor_header {
+    u64 index_off;
+    u64 end_off;
+    u64 reduction_count;
+};
+
+typedef struct dk_bc_pfor_reduction dk_bc_pfor_reduction;
+struct dk_bc_pfor_reduction {
+    u64 off;
+    u64 opcode; // NOTE(rune): add, fadd, imin, imax, fmin or fmax.
+    u64 src;    // NOTE(rune): Source location for overflow errors, like the operand of addc, or zero if unchecked.
+};
+
 typedef struct dk_bc_symbol dk_bc_symbol;
+// NOTE(rune): Size is the number of bytes of locals in the function's call frame.
+// Name and row are only used for stack traces.
 struct dk_bc_symbol {
     i64 id;
     i64 size;
     i64 pos;
+    str name;
+    i64 row;
+    str signature; // NOTE(rune): e.g. "Ekko og inkrementer <heltal>", which the embedding api looks functions up by.
+    i64 arg_slots;
+    i64 ret_slots;
+    str type_name; // NOTE(rune): Name of the return type.
+    struct dk_type **arg_types; // NOTE(rune): Type of each argument, which the embedding api parses arguments by.
+    i64 arg_count;
 };
 
+// NOTE(rune): A list local occupies one slot holding the length, followed by one slot per element.
+// The operand of ldx/stx is the local offset of the length slot, and the index is popped from the data stack.
+// ldxu/stxu are the same, except without the bounds check. They are emitted when the checker can prove that the index is in range.
+// The bulk instruction runs a native kernel over whole lists, see dk_bulk.h for the operand encoding.
+
+// NOTE(rune): Fields of a record local are accessed with ldl/stl, since their offset is known at compile time.
+// Fields of records in a list are accessed with ldf/stf, which pop the index and bounds check it like ldx/stx.
+// The operand packs the local offset of the list's length slot, the slot of the field in element 0 (relative to
+// the first element), and the number of slots between the field in two consecutive elements. In a normal list that
+// is the size of the record, and in a columnar ("søjlevis") list each field is stored contiguously, so it is 1.
+#define dk_field_operand(off, start, stride, unchecked) (u64(off) | (u64(start) << 24) | (u64(stride) << 48) | (u64(unchecked) << 63))
+#define dk_field_operand_off(operand)                    ((operand) & 0xffffff)
+#define dk_field_operand_start(operand)                  (((operand) >> 24) & 0xffffff)
+#define dk_field_operand_stride(operand)                 (((operand) >> 48) & 0x7fff)
+#define dk_field_operand_unchecked(operand)              (((operand) >> 63) != 0)
+
+// NOTE(rune): Globals live in the data segment of the program, one slot per 8 bytes like locals. The operand of
+// ldg/stg is the absolute slot index in the data segment, so access doesn't depend on the current call frame.
+
+// NOTE(rune): Checked arithmetic instructions trap on overflow and division by zero. Their operand is the source
+// location of the clause, so the runtime error can point at it.
+#define dk_src_operand(row, col)        ((u64(row) << 32) | u64(col))
+#define dk_src_operand_row(operand)     ((operand) >> 32)
+#define dk_src_operand_col(operand)     ((operand) & 0xffffffff)
+
+// NOTE(rune): Values smaller than a slot (påstand and the narrow integer types) are packed tightly in lists and
+// records, and are accessed with the width specific instructions instead. ldl8/stl8 etc. take a byte offset into
+// the frame, and ldf8/stf8 etc. take the same operand as ldf/stf, but with start and stride in bytes. Loads zero
+// extend, so loads of signed types are followed by sext8/sext16/sext32. Stores truncate.
+// Scalar locals of narrow types still use a whole slot, but the value in the slot is always in range of the type.
+// Values are wrapped with sext8/sext16/sext32/zext8 when stored, so every other instruction can treat them as heltal.
+
+// NOTE(rune): A vektor value is four 32-bit floats packed into two stack slots, laid out like the base vec4 type.
+// Locals, arguments and return values of type vektor also use two slots. vmake pops four flyder and packs them,
+// and vadd/vmul/vfma operate on all four lanes in one instruction.
+
+// NOTE(rune): An ordbog local holds a pointer to a dk_map (see dk_map.h). The map is allocated by mapnew in the
+// function prelude, and freed by mapfree before each ret. Arguments are borrowed, so they are not freed by the callee.
+// The other map instructions pop the map pointer, which is pushed with ldl, followed by their operands.
+
+// NOTE(rune): A tekst value is a base str (pointer and length) in two stack slots. Text literals are loaded with
+// two ldi instructions, and point directly into the program source, so texts are never copied. tslice also only
+// adjusts the pointer and length. This means the source text must outlive the program.
+
 ////////////////////////////////////////////////////////////////
 // rune: Number spelling
 
@@ -264,6 +611,7 @@ typedef enum dk_literal_kind {
     DK_LITERAL_KIND_INT,
     DK_LITERAL_KIND_FLOAT,
     DK_LITERAL_KIND_BOOL,
+    DK_LITERAL_KIND_TEXT,
 
     DK_LITERAL_KIND_COUNT,
 } dk_literal_kind;
@@ -275,6 +623,7 @@ struct dk_literal {
         i64 int_;
         f64 float_;
         bool bool_;
+        str text_; // NOTE(rune): Slice of the source, without quotes.
     };
 };
 
@@ -323,16 +672,17 @@ struct dk_tokenizer {
     dk_loc loc;
     u8 peek0;
     u8 peek1;
+    dk_ctx *ctx;
 };
 
 static str           dk_str_from_token_kind(dk_token_kind a);
 
 static void          dk_tokenizer_eat(dk_tokenizer *t);
-static void          dk_tokenizer_init(dk_tokenizer *t, str src, i64 pos);
+static void          dk_tokenizer_init(dk_tokenizer *t, str src, i64 pos, dk_ctx *ctx);
 
 static bool          dk_next_token(dk_tokenizer *t, dk_token *token);
 
-static dk_token_list dk_token_list_from_str(str s, arena *arena);
+static dk_token_list dk_token_list_from_str(str s, dk_ctx *ctx);
 
 ////////////////////////////////////////////////////////////////
 // rune: Forward declarations
@@ -347,6 +697,14 @@ typedef struct dk_func          dk_func;
 typedef struct dk_type          dk_type;
 typedef struct dk_symbol        dk_symbol;
 typedef struct dk_local         dk_local;
+typedef struct dk_field         dk_field;
+typedef struct dk_reduction     dk_reduction;
+
+typedef struct dk_expr_list dk_expr_list;
+struct dk_expr_list {
+    dk_expr *first;
+    dk_expr *last;
+};
 
 ////////////////////////////////////////////////////////////////
 // rune: Patterns
@@ -438,9 +796,13 @@ typedef enum dk_stmt_kind {
     DK_STMT_KIND_NONE,
     DK_STMT_KIND_EXPR,
     DK_STMT_KIND_DECL,
+    DK_STMT_KIND_CONST,
     DK_STMT_KIND_RETURN,
     DK_STMT_KIND_IF,
     DK_STMT_KIND_WHILE,
+    DK_STMT_KIND_SWITCH,
+    DK_STMT_KIND_CASE,
+    DK_STMT_KIND_PFOR,
 
     DK_STMT_KIND_COUNT,
 } dk_stmt_kind;
@@ -451,10 +813,25 @@ struct dk_stmt {
     dk_clause_list clauses;
     str name;
     str type_name;
+    i64 list_count; // NOTE(rune): Number of elements when declared as "en liste af N <type>", otherwise 0.
+    str list_count_name; // NOTE(rune): Name of the constant, when the number of elements is a constant.
+    bool list_soa;  // NOTE(rune): Declared as "en søjlevis liste af N <type>".
+    dk_literal literal; // NOTE(rune): Only set for constants.
     dk_expr *expr;
+    dk_expr_list labels;
     dk_stmt_list then;
     dk_stmt_list else_;
     dk_stmt *next;
+
+    // NOTE(rune): Only for Samtidig loops, which run from the index given by clauses to the one given by end_clauses.
+    // The index and end locals, and the reductions, are set by the checker.
+    dk_clause_list end_clauses;
+    dk_expr *end_expr;
+    dk_local *index;
+    dk_local *index_end;
+    dk_reduction *reductions;
+
+    dk_token *token;
 };
 
 ////////////////////////////////////////////////////////////////
@@ -462,6 +839,7 @@ struct dk_stmt {
 
 typedef enum dk_local_flags {
     DK_LOCAL_FLAG_ARG = 1,
+    DK_LOCAL_FLAG_MAYBE_NEGATIVE = 2, // NOTE(rune): Set when the local is assigned something, that can't be proven non-negative.
 } dk_local_flags;
 
 typedef struct dk_local dk_local;
@@ -473,6 +851,15 @@ struct dk_local {
     dk_local *next;
 };
 
+// NOTE(rune): Declared with "Lad N være konstant 1000.", and replaced by the literal wherever it is used, so it takes
+// part in constant folding and range facts like any other literal.
+typedef struct dk_constant dk_constant;
+struct dk_constant {
+    str name;
+    dk_literal literal;
+    dk_constant *next;
+};
+
 typedef struct dk_local_list dk_local_list;
 struct dk_local_list {
     dk_local *first;
@@ -489,27 +876,49 @@ typedef enum dk_func_kind {
     DK_FUNC_KIND_OPCODE,
     DK_FUNC_KIND_NATIVE,
     DK_FUNC_KIND_ASSIGN,
+    DK_FUNC_KIND_LIST_LOAD,
+    DK_FUNC_KIND_LIST_STORE,
+    DK_FUNC_KIND_LIST_LENGTH,
+    DK_FUNC_KIND_BULK,
 
     DK_FUNC_KIND_COUNT,
 } dk_func_kind;
 
 typedef struct dk_func dk_func;
+typedef struct dk_func_ref dk_func_ref;
 struct dk_func {
     dk_pattern pattern;
     dk_stmt_list stmts;
 
     dk_func_kind kind;
     dk_bc_opcode opcode; // TODO(rune): Cleanup
+    dk_bulk_op bulk_op;
 
     str      type_name;
     dk_type *type;
 
     dk_local_list locals;
+    i64 frame_size;
     u32 symbol_id;
+    str signature;
+    i64 arg_slots;
+    dk_type **arg_types; // NOTE(rune): Only for user functions.
+    i64 arg_count;
+
+    dk_token *token;
+
+    // NOTE(rune): Set after every function has been checked, by dk_check_pfor_calls().
+    bool writes_globals;        // NOTE(rune): Whether the function assigns a global, directly or through a call.
+    dk_func_ref *callers;
 
     dk_func *next;
 };
 
+struct dk_func_ref {
+    dk_func *func;
+    dk_func_ref *next;
+};
+
 typedef struct dk_func_list dk_func_list;
 struct dk_func_list {
     dk_func *first;
@@ -519,12 +928,6 @@ struct dk_func_list {
 ////////////////////////////////////////////////////////////////
 // rune: Expression types
 
-typedef struct dk_expr_list dk_expr_list;
-struct dk_expr_list {
-    dk_expr *first;
-    dk_expr *last;
-};
-
 typedef enum dk_expr_kind {
     DK_EXPR_KIND_NONE,
     DK_EXPR_KIND_FUNC,
@@ -532,20 +935,30 @@ typedef enum dk_expr_kind {
     DK_EXPR_KIND_LOCAL,
     DK_EXPR_KIND_LIST,
     DK_EXPR_KIND_ASSIGN,
+    DK_EXPR_KIND_INDEX,
+    DK_EXPR_KIND_BULK,
+    DK_EXPR_KIND_FIELD,
+    DK_EXPR_KIND_GLOBAL, // NOTE(rune): Uses the local member, with the offset in the data segment.
 
     DK_EXPR_KIND_COUNT,
 } dk_expr_kind;
 
+typedef enum dk_expr_flags {
+    DK_EXPR_FLAG_UNCHECKED = 1, // NOTE(rune): Index is proven to be in range, so no bounds check is needed.
+} dk_expr_flags;
+
 typedef struct dk_expr dk_expr;
 struct dk_expr {
     dk_expr_kind kind;
+    dk_expr_flags flags;
     union {
-        struct { dk_func *func; dk_expr_list func_args; };
+        struct { dk_func *func; dk_expr_list func_args; dk_bulk_kernel bulk_kernel; dk_field *field; };
         dk_literal literal;
         dk_local *local;
         dk_expr_list list;
     };
     dk_type *type;
+    dk_token *token; // NOTE(rune): Only set for function calls.
     dk_expr *next;
 };
 
@@ -558,13 +971,59 @@ struct dk_type_list {
     dk_type *last;
 };
 
+typedef enum dk_type_kind {
+    DK_TYPE_KIND_NONE,
+    DK_TYPE_KIND_BASIC,
+    DK_TYPE_KIND_LIST,
+    DK_TYPE_KIND_RECORD,
+
+    DK_TYPE_KIND_COUNT,
+} dk_type_kind;
+
+typedef enum dk_type_flags {
+    DK_TYPE_FLAG_SOA            = 1, // NOTE(rune): List is stored one field at a time, instead of one element at a time.
+    DK_TYPE_FLAG_LAID_OUT       = 2,
+    DK_TYPE_FLAG_LAYING_OUT     = 4, // NOTE(rune): Used to detect records which contain themselves.
+    DK_TYPE_FLAG_OWNED          = 8, // NOTE(rune): Locals own a runtime object, which is created in the prelude and freed on return.
+    DK_TYPE_FLAG_INTEGER        = 16, // NOTE(rune): Integer types convert implicitly to each other, and wrap when narrowed.
+    DK_TYPE_FLAG_SIGNED         = 32,
+} dk_type_flags;
+
+typedef struct dk_field dk_field;
+struct dk_field {
+    str name;
+    str type_name;
+    dk_type *type;
+    i64 off; // NOTE(rune): Byte offset from the start of the record. Fields of a slot or larger always start at a slot.
+    dk_loc loc;
+    dk_field *next;
+};
+
+typedef struct dk_field_list dk_field_list;
+struct dk_field_list {
+    dk_field *first;
+    dk_field *last;
+    i64 count;
+};
+
 typedef struct dk_type dk_type;
 struct dk_type {
     str name;
     i64 size;
+    dk_type_kind kind;
+    dk_type_flags flags;
+    dk_type *elem;          // NOTE(rune): Only for lists.
+    i64 count;              // NOTE(rune): Only for lists.
+    dk_field_list fields;   // NOTE(rune): Only for records.
+    dk_loc loc;
     dk_type *next;
 };
 
+static i64  dk_slot_count_from_type(dk_type *type);
+static bool dk_type_is_int(dk_type *type);
+static bool dk_type_is_packed(dk_type *type);
+static bool dk_types_compatible(dk_type *want, dk_type *given);
+
 ////////////////////////////////////////////////////////////////
 // rune: Parse tree types
 
@@ -572,6 +1031,8 @@ typedef struct dk_tree dk_tree;
 struct dk_tree {
     dk_type_list types;
     dk_func_list funcs;
+    dk_stmt_list globals;
+    i64 global_size; // NOTE(rune): Number of slots in the data segment. Set by the checker.
 };
 
 ////////////////////////////////////////////////////////////////
@@ -581,10 +1042,11 @@ typedef struct dk_parser dk_parser;
 struct dk_parser {
     dk_token *peek;
     arena *arena;
+    dk_ctx *ctx;
 };
 
 // rune: Initialization
-static void dk_parser_init(dk_parser *p, dk_token_list tokens, arena *arena);
+static void dk_parser_init(dk_parser *p, dk_token_list tokens, dk_ctx *ctx);
 
 // rune: Token peek and token consumption
 static dk_token *dk_peek_token(dk_parser *p);
@@ -600,16 +1062,47 @@ static bool      dk_eat_token_text_maybe(dk_parser *p, str text);
 
 // rune: Parsing
 static dk_clause *         dk_parse_clause(dk_parser *p);
+static dk_clause *         dk_parse_clause_until(dk_parser *p, str stop);
 static dk_clause_list      dk_parse_clause_list(dk_parser *p);
 static dk_stmt *           dk_parse_stmt(dk_parser *p);
 static dk_stmt_list        dk_parse_stmt_list(dk_parser *p);
 static dk_func *           dk_parse_func(dk_parser *p);
+static dk_type *           dk_parse_type(dk_parser *p);
 static dk_func_list        dk_parse_func_list(dk_parser *p);
 static dk_tree *           dk_parse_tree(dk_parser *p);
 
 ////////////////////////////////////////////////////////////////
 // rune: Semantic analysis
 
+// NOTE(rune): Records that a local is known to be less than max, because we are inside the body of a while
+// loop with the condition "I er mindre end max". The fact is killed as soon as the local may have been reassigned.
+typedef struct dk_range_fact dk_range_fact;
+struct dk_range_fact {
+    dk_local *local;
+    i64 max;
+    bool killed;
+    dk_range_fact *next;
+};
+
+// NOTE(rune): An index expression, which was marked as unchecked because of a range fact. Range facts only give
+// an upper bound, so the mark is removed again at the end of the function, if the local can be negative.
+typedef struct dk_unchecked_index dk_unchecked_index;
+struct dk_unchecked_index {
+    dk_expr *expr;
+    dk_local *local;
+    dk_unchecked_index *next;
+};
+
+// NOTE(rune): A local declared before a Samtidig loop, which the body only updates as a sum, minimum or maximum e.g.
+// "Læg S sammen med J, og gem det i S." or "Største af M og J, og gem det i M.". Any other use of the local in
+// the body is an error, since each chunk only sees its own part of the result.
+struct dk_reduction {
+    dk_local *local;
+    dk_bc_opcode opcode;
+    dk_loc loc;
+    dk_reduction *next;
+};
+
 typedef struct dk_checker dk_checker;
 struct dk_checker {
     dk_tree *tree;
@@ -618,21 +1111,73 @@ struct dk_checker {
     dk_type *builtin_float;
     dk_type *builtin_bool;
     dk_type *builtin_any;
+    dk_type *builtin_vec;
+    dk_type *builtin_text;
+    dk_type *builtin_map;
+    dk_type *builtin_u8;
+    dk_type *builtin_i8;
+    dk_type *builtin_i16;
+    dk_type *builtin_i32;
     dk_local_list locals;
+    i64 frame_size;
+
+    dk_local_list globals;
+    dk_constant *constants; // NOTE(rune): Stack, so constants declared in a function are popped after checking it.
 
+    dk_range_fact *range_facts;
+    dk_unchecked_index *unchecked_indices;
+
+    dk_stmt *pfor;          // NOTE(rune): Samtidig loop being checked, if any.
+    i64 pfor_frame_size;    // NOTE(rune): Locals below this offset are shared between the iterations of the loop.
 
     arena *arena;
+    dk_ctx *ctx;
 
     u32 symbol_id_counter;
+
+    dk_build_flags flags;
 };
 
+static dk_expr *dk_check_clause_part(dk_checker *c, dk_clause_part *part);
 static dk_expr *dk_check_clause(dk_checker *c, dk_clause *clause);
 static dk_expr *dk_check_clause_list(dk_checker *c, dk_clause_list clauses);
 static void     dk_check_stmt(dk_checker *c, dk_stmt *stmt);
 static void     dk_check_stmt_list(dk_checker *c, dk_stmt_list stmts);
 static void     dk_check_func_sig(dk_checker *c, dk_func *func);
 static void     dk_check_func_body(dk_checker *c, dk_func *func);
-static void     dk_check_tree(dk_tree *tree, arena *arena);
+static void     dk_check_globals(dk_checker *c, dk_stmt_list stmts);
+static void     dk_check_tree(dk_tree *tree, dk_build_flags flags, dk_ctx *ctx);
+
+// rune: Lists
+static dk_type *dk_make_list_type(dk_checker *c, dk_type *elem, i64 count, bool soa);
+static dk_expr *dk_check_list_access(dk_checker *c, dk_func *func, dk_expr_list args, dk_loc loc);
+static dk_expr *dk_check_bulk(dk_checker *c, dk_func *func, dk_expr_list args, dk_loc loc);
+static void     dk_note_assign(dk_checker *c, dk_local *local, dk_expr *rvalue);
+
+// rune: Samtidig loops
+static void     dk_check_pfor(dk_checker *c, dk_stmt *stmt);
+static void     dk_check_pfor_stmt_list(dk_checker *c, dk_stmt_list stmts, bool reads);
+static void     dk_check_pfor_expr(dk_checker *c, dk_expr *expr, dk_loc loc, bool reads);
+static dk_expr *dk_reduction_arg(dk_expr *rvalue, dk_local *local, dk_bc_opcode *opcode);
+static void     dk_check_pfor_calls(dk_checker *c, dk_func_list funcs);
+static void     dk_check_pfor_calls_stmt_list(dk_checker *c, dk_stmt_list stmts, bool in_pfor);
+static void     dk_check_pfor_calls_expr(dk_checker *c, dk_expr *expr, dk_loc loc);
+static bool     dk_note_calls_stmt_list(dk_checker *c, dk_func *caller, dk_stmt_list stmts);
+static bool     dk_note_calls_expr(dk_checker *c, dk_func *caller, dk_expr *expr);
+
+// rune: Records
+static void     dk_layout_type(dk_checker *c, dk_type *type);
+static dk_field *dk_resolve_field(dk_type *type, str name);
+static dk_expr *dk_check_field_access(dk_checker *c, dk_clause_part **part, dk_loc loc);
+
+// rune: Checked arithmetic
+static bool     dk_add_overflow(i64 a, i64 b, i64 *result);
+static bool     dk_sub_overflow(i64 a, i64 b, i64 *result);
+static bool     dk_mul_overflow(i64 a, i64 b, i64 *result);
+
+// rune: Constant folding
+static bool     dk_fold_opcode(dk_bc_opcode opcode, u64 a, u64 b, bool checked, u64 *result);
+static dk_expr *dk_fold_expr(dk_checker *c, dk_expr *expr);
 
 ////////////////////////////////////////////////////////////////
 // rune: Dynamic buffer
@@ -679,12 +1224,17 @@ typedef struct dk_program dk_program;
 struct dk_program {
     dk_buffer head;
     dk_buffer body;
+    dk_buffer data; // NOTE(rune): Initial values of globals. Each run works on its own copy.
 };
 
 typedef struct dk_emitter dk_emitter;
 struct dk_emitter {
     dk_buffer head;
     dk_buffer body;
+    dk_buffer relocs; // NOTE(rune): Positions of u64s in body, which hold positions in body.
+    dk_func *func; // NOTE(rune): Function currently being emitted.
+    dk_build_flags flags;
+    dk_ctx *ctx;
 };
 
 // rune: Low-level emit helpers.
@@ -694,18 +1244,171 @@ static u32 *dk_emit_u32(dk_emitter *e, u32 a);
 static u64 *dk_emit_u64(dk_emitter *e, u64 a);
 static void dk_emit_inst1(dk_emitter *e, dk_bc_opcode opcode);
 static void dk_emit_inst2(dk_emitter *e, dk_bc_opcode opcode, u64 operand);
+static i64  dk_emit_jump(dk_emitter *e, dk_bc_opcode opcode);
+static void dk_patch_jump(dk_emitter *e, i64 operand_pos, i64 target);
+static void dk_emit_reloc(dk_emitter *e, i64 pos);
+static void dk_emitter_append(dk_emitter *e, dk_emitter *src);
 
 // rune: Emit tree.
-static void dk_emit_symbol(dk_emitter *e, u32 id, u32 size);
+static void dk_emit_symbol(dk_emitter *e, dk_func *func);
 static void dk_emit_literal(dk_emitter *e, dk_literal literal);
+static i64  dk_local_off_from_expr(dk_expr *expr);
+static u64  dk_field_operand_from_expr(dk_expr *expr);
+static void dk_emit_pop(dk_emitter *e, dk_type *type);
+static void dk_emit_store_args(dk_emitter *e, dk_local *local);
+static void dk_emit_ret(dk_emitter *e);
 static void dk_emit_expr(dk_emitter *e, dk_expr *expr);
+static void dk_emit_switch(dk_emitter *e, dk_stmt *stmt);
+static void dk_emit_pfor(dk_emitter *e, dk_stmt *stmt);
 static void dk_emit_stmt_list(dk_emitter *e, dk_stmt_list stmts);
+static void dk_emit_func(dk_emitter *e, dk_func *func);
 static void dk_emit_tree(dk_emitter *e, dk_tree *tree);
 
+////////////////////////////////////////////////////////////////
+// rune: Parallel compilation
+
+// NOTE(rune): Once signatures are resolved, function bodies can be checked and emitted independently. Functions
+// are split into batches of DK_FUNCS_PER_JOB, and each batch gets its own checker arena and emitter. Checker
+// arenas are adopted by the tree's arena afterwards, and emitted bodies are concatenated in function order.
+#define DK_FUNCS_PER_JOB 32
+
+typedef struct dk_check_job dk_check_job;
+struct dk_check_job {
+    dk_checker c; // NOTE(rune): Copy of the tree's checker after signatures are resolved, with its own context.
+    dk_ctx ctx;
+    dk_err_sink err;
+    dk_func **funcs;
+    i64 func_count;
+};
+
+typedef struct dk_emit_job dk_emit_job;
+struct dk_emit_job {
+    dk_emitter e;
+    dk_func **funcs;
+    i64 func_count;
+};
+
+static void        dk_run_jobs(job_system *jobs, job_proc *proc, void *params, i64 param_size, i64 count);
+static dk_func **  dk_user_func_array_from_list(dk_func_list funcs, i64 *count, arena *arena);
+static void        dk_check_job_proc(void *param);
+static void        dk_emit_job_proc(void *param);
+
 ////////////////////////////////////////////////////////////////
 // rune: Runtime
 
-static str dk_run_program(dk_program program, arena *output_arena);
+typedef struct dk_call_frame dk_call_frame;
+struct dk_call_frame {
+    i64 loc_base;
+    i64 loc_size;
+    i64 return_pos;
+    i64 prev_pos; // NOTE(rune): Position in call_stack, and not a pointer, since call_stack may be reallocated.
+};
+
+typedef enum dk_vm_status {
+    DK_VM_STATUS_NONE,
+    DK_VM_STATUS_RUNNING, // NOTE(rune): Ran out of fuel, and can be resumed.
+    DK_VM_STATUS_DONE,
+    DK_VM_STATUS_ERROR,
+} dk_vm_status;
+
+// NOTE(rune): State of the interpreter, which is kept between calls, so the stacks only grow on the first few
+// calls. A dk_vm is only used by one thread at a time, but a dk_program can be shared by any number of them.
+// Everything needed to resume a program lives here, so a vm can be paused, and resumed later on any thread.
+typedef struct dk_vm dk_vm;
+typedef struct dk_vm_chunk dk_vm_chunk;
+struct dk_vm {
+    dk_buffer data_stack;
+    dk_buffer call_stack;
+    dk_buffer globals; // NOTE(rune): Reset to the initial values of the program on each call.
+    dk_map_list maps;
+
+    dk_program *program;
+    dk_vm_status status;
+    i64 ip;
+    i64 frame_pos;
+    i64 fuel_left; // NOTE(rune): Fuel left when dk_vm_resume() returned.
+
+    // rune: Samtidig loops
+    job_system *jobs;       // NOTE(rune): Runs the chunks of Samtidig loops. If null, chunks run one after another on the calling thread.
+    dk_vm_chunk *chunks;    // NOTE(rune): DK_VM_CHUNK_COUNT chunks, kept between loops, so their vms and arenas are reused.
+    i64 pfor_chunk_count;   // NOTE(rune): Chunks of the loop being run. Only non-zero between calls to dk_vm_resume(), if the loop ran out of fuel.
+};
+
+// NOTE(rune): The index range of a Samtidig loop is split into at most DK_VM_CHUNK_COUNT chunks, independent of the
+// number of workers, so reductions of flyder are combined in the same order on every machine.
+#define DK_VM_CHUNK_COUNT 32
+
+struct dk_vm_chunk {
+    dk_vm *vm;
+    arena *arena;           // NOTE(rune): Output of the chunk, which is copied to the output of the loop afterwards.
+    str_list output;
+    dk_vm_status status;
+    i64 fuel;               // NOTE(rune): Fuel for the next dk_vm_resume() of the chunk, or zero if it doesn't run.
+};
+
+// NOTE(rune): Fuel is charged once per basic block, i.e. on each jump, branch, switch, call and return, so a
+// program which runs forever always runs out of fuel, and straight-line code pays nothing extra.
+static void         dk_vm_start(dk_vm *vm, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count);
+static dk_vm_status dk_vm_resume(dk_vm *vm, i64 fuel, dk_input *input, str_list *output, arena *output_arena);
+
+// NOTE(rune): Runs the function of entry to completion with the given argument slots. Return values are left on
+// the data stack of the vm. Returns false on a runtime error, which is reported in output.
+static bool         dk_vm_call(dk_vm *vm, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count,
+                               dk_input *input, str_list *output, arena *output_arena);
+static void         dk_vm_destroy(dk_vm *vm);
+static void         dk_vm_pfor_start(dk_vm *vm, dk_call_frame *frame, dk_bc_pfor_header *header, dk_bc_pfor_reduction *reductions,
+                                     i64 body_pos, i64 first, i64 last);
+static bool         dk_vm_pfor_run(dk_vm *vm, i64 *fuel); // NOTE(rune): Returns false if the chunks ran out of fuel before they were done.
+static bool         dk_vm_pfor_finish(dk_vm *vm, dk_call_frame *frame, dk_bc_pfor_header *header, dk_bc_pfor_reduction *reductions,
+                                      str_list *output, arena *output_arena);
+static void         dk_vm_chunk_proc(void *param);
+static i64          dk_bc_switch_target(dk_bc_switch_header *header, dk_bc_switch_entry *entries, u64 entry_count, i64 key);
+static str          dk_run_program(dk_program program, dk_input *input, job_system *jobs, arena *output_arena);
+
+////////////////////////////////////////////////////////////////
+// rune: Runtime traps
+
+#include <signal.h>
+#include <setjmp.h>
+
+// NOTE(rune): Unchecked instructions have no runtime checks, so e.g. a division by zero faults in the host.
+// While a program runs, SIGFPE, SIGSEGV and SIGBUS jump back into dk_vm_call(), which reports a runtime
+// error with a stack trace, instead of taking down the whole process. The only cost on the fast path is
+// that the instructions which can fault store their position before they run. Faults outside of a running
+// program are passed on to whichever handler the host had installed before us.
+typedef struct dk_trap dk_trap;
+struct dk_trap {
+#if _WIN32
+    jmp_buf jmp;
+#else
+    sigjmp_buf jmp;
+#endif
+    volatile i64 ip;        // NOTE(rune): Position of the last unchecked instruction that could fault.
+    volatile i64 frame_pos; // NOTE(rune): Position of the current call frame in the call stack.
+    dk_trap *prev;          // NOTE(rune): Trap of an enclosing dk_vm_call() on the same thread.
+};
+
+// NOTE(rune): Must be a macro, since the jump buffer is only valid while the function that set it is running.
+// The signal mask is not saved, since that's a syscall on every resume. dk_trap_unblock() restores it instead.
+#if _WIN32
+#define dk_trap_set(trap)           setjmp((trap)->jmp)
+#define dk_trap_jump(trap, sig)     longjmp((trap)->jmp, (sig))
+#else
+#define dk_trap_set(trap)           sigsetjmp((trap)->jmp, 0)
+#define dk_trap_jump(trap, sig)     siglongjmp((trap)->jmp, (sig))
+#endif
+
+static thread_local dk_trap *dk_active_trap;
+
+static void dk_trap_install(void);
+#if _WIN32
+static void dk_trap_handler(int sig);
+#else
+static void dk_trap_handler(int sig, siginfo_t *info, void *context);
+#endif
+static void dk_trap_unblock(int sig);
+static str  dk_trap_message(int sig);
+static dk_bc_symbol *dk_symbol_from_pos(dk_bc_symbol *symbols, i64 symbol_count, i64 pos);
 
 ////////////////////////////////////////////////////////////////
 // rune: Debug print
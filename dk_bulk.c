@@ -0,0 +1,676 @@
+////////////////////////////////////////////////////////////////
+// rune: Bulk kernels
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   define DK_BULK_X86 1
+#   include <immintrin.h>
+#else
+#   define DK_BULK_X86 0
+#endif
+
+#if _WIN32
+#   define DK_BULK_TARGET_AVX2
+#else
+#   define DK_BULK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// NOTE(rune): The vector kernels add floats in a different order than a sequential loop, so float sums and
+// dot products may differ from the interpreted loop in the last bits. Min/max of NaN also follows minpd/maxpd,
+// and not fmin/fmax.
+
+////////////////////////////////////////////////////////////////
+// rune: Scalar kernels
+
+static u64 dk_bulk_isum_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    u64 acc = 0;
+    for_n (i64, i, count) acc += dst[i];
+    return acc;
+}
+
+static u64 dk_bulk_fsum_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 acc = 0;
+    for_n (i64, i, count) acc += d[i];
+    return u64_from_f64(acc);
+}
+
+static u64 dk_bulk_idot_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    u64 acc = 0;
+    for_n (i64, i, count) acc += dst[i] * src[i];
+    return acc;
+}
+
+static u64 dk_bulk_fdot_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    f64 acc = 0;
+    for_n (i64, i, count) acc += d[i] * s[i];
+    return u64_from_f64(acc);
+}
+
+static u64 dk_bulk_imin_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 *d = (i64 *)dst;
+    i64 acc = I64_MAX;
+    for_n (i64, i, count) acc = min(acc, d[i]);
+    return u64(acc);
+}
+
+static u64 dk_bulk_fmin_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 acc = INFINITY;
+    for_n (i64, i, count) acc = fmin(acc, d[i]);
+    return u64_from_f64(acc);
+}
+
+static u64 dk_bulk_imax_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 *d = (i64 *)dst;
+    i64 acc = I64_MIN;
+    for_n (i64, i, count) acc = max(acc, d[i]);
+    return u64(acc);
+}
+
+static u64 dk_bulk_fmax_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 acc = -INFINITY;
+    for_n (i64, i, count) acc = fmax(acc, d[i]);
+    return u64_from_f64(acc);
+}
+
+static u64 dk_bulk_iadd_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    for_n (i64, i, count) dst[i] += src[i];
+    return 0;
+}
+
+static u64 dk_bulk_fadd_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    for_n (i64, i, count) d[i] += s[i];
+    return 0;
+}
+
+static u64 dk_bulk_imul_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    for_n (i64, i, count) dst[i] *= src[i];
+    return 0;
+}
+
+static u64 dk_bulk_fmul_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    for_n (i64, i, count) d[i] *= s[i];
+    return 0;
+}
+
+static u64 dk_bulk_iscale_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    for_n (i64, i, count) dst[i] *= scalar;
+    return 0;
+}
+
+static u64 dk_bulk_fscale_scalar(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 s = f64_from_u64(scalar);
+    for_n (i64, i, count) d[i] *= s;
+    return 0;
+}
+
+#if DK_BULK_X86
+
+////////////////////////////////////////////////////////////////
+// rune: SSE2 kernels
+
+// NOTE(rune): SSE2 has no 64-bit multiply, so it is built from 32x32->64 multiplies. Only the low 64 bits
+// are needed, which is the same for signed and unsigned multiplication.
+static __m128i dk_bulk_mullo_epi64_sse2(__m128i a, __m128i b) {
+    __m128i a_hi = _mm_srli_epi64(a, 32);
+    __m128i b_hi = _mm_srli_epi64(b, 32);
+    __m128i lo   = _mm_mul_epu32(a, b);
+    __m128i mid  = _mm_add_epi64(_mm_mul_epu32(a_hi, b), _mm_mul_epu32(a, b_hi));
+    return _mm_add_epi64(lo, _mm_slli_epi64(mid, 32));
+}
+
+static u64 dk_bulk_isum_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    __m128i acc = _mm_setzero_si128();
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        acc = _mm_add_epi64(acc, _mm_loadu_si128((__m128i *)(dst + i)));
+    }
+
+    u64 lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    u64 ret = lanes[0] + lanes[1];
+    for (; i < count; i++) ret += dst[i];
+    return ret;
+}
+
+static u64 dk_bulk_fsum_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m128d acc = _mm_setzero_pd();
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        acc = _mm_add_pd(acc, _mm_loadu_pd(d + i));
+    }
+
+    f64 lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    f64 ret = lanes[0] + lanes[1];
+    for (; i < count; i++) ret += d[i];
+    return u64_from_f64(ret);
+}
+
+static u64 dk_bulk_idot_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    __m128i acc = _mm_setzero_si128();
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i a = _mm_loadu_si128((__m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((__m128i *)(src + i));
+        acc = _mm_add_epi64(acc, dk_bulk_mullo_epi64_sse2(a, b));
+    }
+
+    u64 lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    u64 ret = lanes[0] + lanes[1];
+    for (; i < count; i++) ret += dst[i] * src[i];
+    return ret;
+}
+
+static u64 dk_bulk_fdot_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    __m128d acc = _mm_setzero_pd();
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(d + i), _mm_loadu_pd(s + i)));
+    }
+
+    f64 lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    f64 ret = lanes[0] + lanes[1];
+    for (; i < count; i++) ret += d[i] * s[i];
+    return u64_from_f64(ret);
+}
+
+static u64 dk_bulk_fmin_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m128d acc = _mm_set1_pd(INFINITY);
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        acc = _mm_min_pd(acc, _mm_loadu_pd(d + i));
+    }
+
+    f64 lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    f64 ret = fmin(lanes[0], lanes[1]);
+    for (; i < count; i++) ret = fmin(ret, d[i]);
+    return u64_from_f64(ret);
+}
+
+static u64 dk_bulk_fmax_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m128d acc = _mm_set1_pd(-INFINITY);
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        acc = _mm_max_pd(acc, _mm_loadu_pd(d + i));
+    }
+
+    f64 lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    f64 ret = fmax(lanes[0], lanes[1]);
+    for (; i < count; i++) ret = fmax(ret, d[i]);
+    return u64_from_f64(ret);
+}
+
+static u64 dk_bulk_iadd_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i a = _mm_loadu_si128((__m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((__m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi64(a, b));
+    }
+    for (; i < count; i++) dst[i] += src[i];
+    return 0;
+}
+
+static u64 dk_bulk_fadd_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(d + i, _mm_add_pd(_mm_loadu_pd(d + i), _mm_loadu_pd(s + i)));
+    }
+    for (; i < count; i++) d[i] += s[i];
+    return 0;
+}
+
+static u64 dk_bulk_imul_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i a = _mm_loadu_si128((__m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((__m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), dk_bulk_mullo_epi64_sse2(a, b));
+    }
+    for (; i < count; i++) dst[i] *= src[i];
+    return 0;
+}
+
+static u64 dk_bulk_fmul_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(d + i, _mm_mul_pd(_mm_loadu_pd(d + i), _mm_loadu_pd(s + i)));
+    }
+    for (; i < count; i++) d[i] *= s[i];
+    return 0;
+}
+
+static u64 dk_bulk_iscale_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    __m128i b = _mm_set1_epi64x(i64(scalar));
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i a = _mm_loadu_si128((__m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), dk_bulk_mullo_epi64_sse2(a, b));
+    }
+    for (; i < count; i++) dst[i] *= scalar;
+    return 0;
+}
+
+static u64 dk_bulk_fscale_sse2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m128d b = _mm_set1_pd(f64_from_u64(scalar));
+    i64 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(d + i, _mm_mul_pd(_mm_loadu_pd(d + i), b));
+    }
+    for (; i < count; i++) d[i] *= f64_from_u64(scalar);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: AVX2 kernels
+
+DK_BULK_TARGET_AVX2
+static __m256i dk_bulk_mullo_epi64_avx2(__m256i a, __m256i b) {
+    __m256i a_hi = _mm256_srli_epi64(a, 32);
+    __m256i b_hi = _mm256_srli_epi64(b, 32);
+    __m256i lo   = _mm256_mul_epu32(a, b);
+    __m256i mid  = _mm256_add_epi64(_mm256_mul_epu32(a_hi, b), _mm256_mul_epu32(a, b_hi));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(mid, 32));
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_isum_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    i64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256((__m256i *)(dst + i + 0)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256((__m256i *)(dst + i + 4)));
+    }
+
+    u64 lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(acc0, acc1));
+    u64 ret = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < count; i++) ret += dst[i];
+    return ret;
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_fsum_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    i64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(d + i + 0));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(d + i + 4));
+    }
+
+    f64 lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    f64 ret = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < count; i++) ret += d[i];
+    return u64_from_f64(ret);
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_idot_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    __m256i acc = _mm256_setzero_si256();
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i *)(src + i));
+        acc = _mm256_add_epi64(acc, dk_bulk_mullo_epi64_avx2(a, b));
+    }
+
+    u64 lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    u64 ret = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < count; i++) ret += dst[i] * src[i];
+    return ret;
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_fdot_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    i64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(d + i + 0), _mm256_loadu_pd(s + i + 0)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(d + i + 4), _mm256_loadu_pd(s + i + 4)));
+    }
+
+    f64 lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    f64 ret = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < count; i++) ret += d[i] * s[i];
+    return u64_from_f64(ret);
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_imin_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 *d = (i64 *)dst;
+    __m256i acc = _mm256_set1_epi64x(I64_MAX);
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(d + i));
+        acc = _mm256_blendv_epi8(acc, a, _mm256_cmpgt_epi64(acc, a));
+    }
+
+    i64 lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    i64 ret = min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+    for (; i < count; i++) ret = min(ret, d[i]);
+    return u64(ret);
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_imax_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 *d = (i64 *)dst;
+    __m256i acc = _mm256_set1_epi64x(I64_MIN);
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(d + i));
+        acc = _mm256_blendv_epi8(acc, a, _mm256_cmpgt_epi64(a, acc));
+    }
+
+    i64 lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    i64 ret = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+    for (; i < count; i++) ret = max(ret, d[i]);
+    return u64(ret);
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_fmin_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m256d acc = _mm256_set1_pd(INFINITY);
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm256_min_pd(acc, _mm256_loadu_pd(d + i));
+    }
+
+    f64 lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    f64 ret = fmin(fmin(lanes[0], lanes[1]), fmin(lanes[2], lanes[3]));
+    for (; i < count; i++) ret = fmin(ret, d[i]);
+    return u64_from_f64(ret);
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_fmax_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m256d acc = _mm256_set1_pd(-INFINITY);
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm256_max_pd(acc, _mm256_loadu_pd(d + i));
+    }
+
+    f64 lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    f64 ret = fmax(fmax(lanes[0], lanes[1]), fmax(lanes[2], lanes[3]));
+    for (; i < count; i++) ret = fmax(ret, d[i]);
+    return u64_from_f64(ret);
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_iadd_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi64(a, b));
+    }
+    for (; i < count; i++) dst[i] += src[i];
+    return 0;
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_fadd_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(d + i, _mm256_add_pd(_mm256_loadu_pd(d + i), _mm256_loadu_pd(s + i)));
+    }
+    for (; i < count; i++) d[i] += s[i];
+    return 0;
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_imul_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((__m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), dk_bulk_mullo_epi64_avx2(a, b));
+    }
+    for (; i < count; i++) dst[i] *= src[i];
+    return 0;
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_fmul_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    f64 *s = (f64 *)src;
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(d + i, _mm256_mul_pd(_mm256_loadu_pd(d + i), _mm256_loadu_pd(s + i)));
+    }
+    for (; i < count; i++) d[i] *= s[i];
+    return 0;
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_iscale_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    __m256i b = _mm256_set1_epi64x(i64(scalar));
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(dst + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), dk_bulk_mullo_epi64_avx2(a, b));
+    }
+    for (; i < count; i++) dst[i] *= scalar;
+    return 0;
+}
+
+DK_BULK_TARGET_AVX2
+static u64 dk_bulk_fscale_avx2(u64 *dst, u64 *src, i64 count, u64 scalar) {
+    f64 *d = (f64 *)dst;
+    __m256d b = _mm256_set1_pd(f64_from_u64(scalar));
+    i64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(d + i, _mm256_mul_pd(_mm256_loadu_pd(d + i), b));
+    }
+    for (; i < count; i++) d[i] *= f64_from_u64(scalar);
+    return 0;
+}
+
+#endif // DK_BULK_X86
+
+////////////////////////////////////////////////////////////////
+// rune: Dispatch
+
+#define K(op, is_float) dk_bulk_kernel_from_op(op, is_float)
+
+// NOTE(rune): Null entries fall back to the next slower isa, e.g. SSE2 has no 64-bit integer compare.
+static dk_bulk_func *dk_bulk_funcs[DK_BULK_ISA_COUNT][DK_BULK_KERNEL_COUNT] = {
+    [DK_BULK_ISA_SCALAR] = {
+        [K(DK_BULK_OP_SUM,   0)] = dk_bulk_isum_scalar,
+        [K(DK_BULK_OP_SUM,   1)] = dk_bulk_fsum_scalar,
+        [K(DK_BULK_OP_DOT,   0)] = dk_bulk_idot_scalar,
+        [K(DK_BULK_OP_DOT,   1)] = dk_bulk_fdot_scalar,
+        [K(DK_BULK_OP_MIN,   0)] = dk_bulk_imin_scalar,
+        [K(DK_BULK_OP_MIN,   1)] = dk_bulk_fmin_scalar,
+        [K(DK_BULK_OP_MAX,   0)] = dk_bulk_imax_scalar,
+        [K(DK_BULK_OP_MAX,   1)] = dk_bulk_fmax_scalar,
+        [K(DK_BULK_OP_ADD,   0)] = dk_bulk_iadd_scalar,
+        [K(DK_BULK_OP_ADD,   1)] = dk_bulk_fadd_scalar,
+        [K(DK_BULK_OP_MUL,   0)] = dk_bulk_imul_scalar,
+        [K(DK_BULK_OP_MUL,   1)] = dk_bulk_fmul_scalar,
+        [K(DK_BULK_OP_SCALE, 0)] = dk_bulk_iscale_scalar,
+        [K(DK_BULK_OP_SCALE, 1)] = dk_bulk_fscale_scalar,
+    },
+#if DK_BULK_X86
+    [DK_BULK_ISA_SSE2] = {
+        [K(DK_BULK_OP_SUM,   0)] = dk_bulk_isum_sse2,
+        [K(DK_BULK_OP_SUM,   1)] = dk_bulk_fsum_sse2,
+        [K(DK_BULK_OP_DOT,   0)] = dk_bulk_idot_sse2,
+        [K(DK_BULK_OP_DOT,   1)] = dk_bulk_fdot_sse2,
+        [K(DK_BULK_OP_MIN,   1)] = dk_bulk_fmin_sse2,
+        [K(DK_BULK_OP_MAX,   1)] = dk_bulk_fmax_sse2,
+        [K(DK_BULK_OP_ADD,   0)] = dk_bulk_iadd_sse2,
+        [K(DK_BULK_OP_ADD,   1)] = dk_bulk_fadd_sse2,
+        [K(DK_BULK_OP_MUL,   0)] = dk_bulk_imul_sse2,
+        [K(DK_BULK_OP_MUL,   1)] = dk_bulk_fmul_sse2,
+        [K(DK_BULK_OP_SCALE, 0)] = dk_bulk_iscale_sse2,
+        [K(DK_BULK_OP_SCALE, 1)] = dk_bulk_fscale_sse2,
+    },
+    [DK_BULK_ISA_AVX2] = {
+        [K(DK_BULK_OP_SUM,   0)] = dk_bulk_isum_avx2,
+        [K(DK_BULK_OP_SUM,   1)] = dk_bulk_fsum_avx2,
+        [K(DK_BULK_OP_DOT,   0)] = dk_bulk_idot_avx2,
+        [K(DK_BULK_OP_DOT,   1)] = dk_bulk_fdot_avx2,
+        [K(DK_BULK_OP_MIN,   0)] = dk_bulk_imin_avx2,
+        [K(DK_BULK_OP_MIN,   1)] = dk_bulk_fmin_avx2,
+        [K(DK_BULK_OP_MAX,   0)] = dk_bulk_imax_avx2,
+        [K(DK_BULK_OP_MAX,   1)] = dk_bulk_fmax_avx2,
+        [K(DK_BULK_OP_ADD,   0)] = dk_bulk_iadd_avx2,
+        [K(DK_BULK_OP_ADD,   1)] = dk_bulk_fadd_avx2,
+        [K(DK_BULK_OP_MUL,   0)] = dk_bulk_imul_avx2,
+        [K(DK_BULK_OP_MUL,   1)] = dk_bulk_fmul_avx2,
+        [K(DK_BULK_OP_SCALE, 0)] = dk_bulk_iscale_avx2,
+        [K(DK_BULK_OP_SCALE, 1)] = dk_bulk_fscale_avx2,
+    },
+#endif
+};
+
+#undef K
+
+// NOTE(rune): The detected isa is shared by every thread, and stored with atomics, since any thread may be the
+// first to run a kernel. Detection always gives the same result, so threads which race to store it agree.
+// The isa can be overridden per thread by dk_bulk_select_isa(), so tests can compare isas, while other threads
+// keep running kernels with the detected isa.
+static volatile i64             dk_bulk_g_detected_isa = -1;
+static thread_local dk_bulk_isa dk_bulk_t_isa;
+static thread_local bool        dk_bulk_t_isa_selected;
+
+static dk_bulk_isa dk_bulk_detect_isa(void) {
+    dk_bulk_isa ret = DK_BULK_ISA_SCALAR;
+
+#if DK_BULK_X86
+    ret = DK_BULK_ISA_SSE2; // NOTE(rune): SSE2 is part of the x86-64 baseline.
+
+#if _WIN32
+    // NOTE(rune): AVX2 also needs the OS to save the upper halves of the ymm registers (OSXSAVE + XCR0).
+    int regs[4] = { 0 };
+    __cpuid(regs, 0);
+    if (regs[0] >= 7) {
+        __cpuidex(regs, 1, 0);
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+        bool avx     = (regs[2] & (1 << 28)) != 0;
+
+        __cpuidex(regs, 7, 0);
+        bool avx2    = (regs[1] & (1 << 5)) != 0;
+
+        if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6) {
+            ret = DK_BULK_ISA_AVX2;
+        }
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        ret = DK_BULK_ISA_AVX2;
+    }
+#endif
+#endif
+
+    return ret;
+}
+
+static void dk_bulk_select_isa(dk_bulk_isa isa) {
+    assert(isa < DK_BULK_ISA_COUNT);
+    dk_bulk_t_isa = isa;
+    dk_bulk_t_isa_selected = true;
+}
+
+static dk_bulk_isa dk_bulk_selected_isa(void) {
+    if (dk_bulk_t_isa_selected) {
+        return dk_bulk_t_isa;
+    }
+
+    i64 isa = atomic_load_i64(&dk_bulk_g_detected_isa);
+    if (isa < 0) {
+        isa = dk_bulk_detect_isa();
+        atomic_store_i64(&dk_bulk_g_detected_isa, isa);
+    }
+    return (dk_bulk_isa)isa;
+}
+
+static dk_bulk_func *dk_bulk_get_func(dk_bulk_kernel kernel) {
+    assert(kernel < DK_BULK_KERNEL_COUNT);
+
+    dk_bulk_func *ret = null;
+    for (i64 isa = dk_bulk_selected_isa(); isa >= 0 && ret == null; isa--) {
+        ret = dk_bulk_funcs[isa][kernel];
+    }
+
+    assert(ret != null);
+    return ret;
+}
+
+static bool dk_bulk_kernel_can_overflow(dk_bulk_kernel kernel) {
+    dk_bulk_op op = dk_bulk_op_from_kernel(kernel);
+    return !dk_bulk_kernel_is_float(kernel) && op != DK_BULK_OP_MIN && op != DK_BULK_OP_MAX;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Vector kernels
+
+#if DK_BULK_X86
+
+static vec4 dk_vec4_add(vec4 a, vec4 b) {
+    vec4 ret;
+    _mm_storeu_ps(ret.v, _mm_add_ps(_mm_loadu_ps(a.v), _mm_loadu_ps(b.v)));
+    return ret;
+}
+
+static vec4 dk_vec4_mul(vec4 a, vec4 b) {
+    vec4 ret;
+    _mm_storeu_ps(ret.v, _mm_mul_ps(_mm_loadu_ps(a.v), _mm_loadu_ps(b.v)));
+    return ret;
+}
+
+static vec4 dk_vec4_fma(vec4 a, vec4 b, vec4 c) {
+    // NOTE(rune): Not fused, since FMA3 is not part of the x86-64 baseline. Rounds like vec4_add(vec4_mul(a, b), c).
+    vec4 ret;
+    _mm_storeu_ps(ret.v, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a.v), _mm_loadu_ps(b.v)), _mm_loadu_ps(c.v)));
+    return ret;
+}
+
+#else
+
+static vec4 dk_vec4_add(vec4 a, vec4 b)          { return vec4_add(a, b); }
+static vec4 dk_vec4_mul(vec4 a, vec4 b)          { return vec4_mul(a, b); }
+static vec4 dk_vec4_fma(vec4 a, vec4 b, vec4 c)  { return vec4_add(vec4_mul(a, b), c); }
+
+#endif
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////
+// rune: Bulk kernels
+
+// NOTE(rune): Native kernels for whole-list operations, dispatched from the interpreter with a single bulk instruction.
+// Every kernel has a scalar version, and a SSE2 and AVX2 version on x86-64. The fastest version supported by the
+// cpu is detected at runtime, and can be overridden for the calling thread by dk_bulk_select_isa().
+//
+// Kernels operate on raw list elements. dst is always a list, src is the second list for binary kernels,
+// and scalar is the popped value for scaling. The return value is pushed on the data stack.
+
+typedef enum dk_bulk_op {
+    DK_BULK_OP_NONE,
+    DK_BULK_OP_SUM,     // sum(dst)
+    DK_BULK_OP_DOT,     // sum(dst[i] * src[i])
+    DK_BULK_OP_MIN,     // min(dst)
+    DK_BULK_OP_MAX,     // max(dst)
+    DK_BULK_OP_ADD,     // dst[i] += src[i]
+    DK_BULK_OP_MUL,     // dst[i] *= src[i]
+    DK_BULK_OP_SCALE,   // dst[i] *= scalar
+
+    DK_BULK_OP_COUNT,
+} dk_bulk_op;
+
+// NOTE(rune): Kernel id is (op << 1) | is_float.
+typedef u8 dk_bulk_kernel;
+
+#define dk_bulk_kernel_from_op(op, is_float) ((dk_bulk_kernel)(((op) << 1) | ((is_float) ? 1 : 0)))
+#define dk_bulk_op_from_kernel(k)            ((dk_bulk_op)((k) >> 1))
+#define dk_bulk_kernel_is_float(k)           (((k) & 1) != 0)
+#define DK_BULK_KERNEL_COUNT                 (DK_BULK_OP_COUNT << 1)
+
+typedef u64 dk_bulk_func(u64 *dst, u64 *src, i64 count, u64 scalar);
+
+typedef enum dk_bulk_isa {
+    DK_BULK_ISA_SCALAR,
+    DK_BULK_ISA_SSE2,
+    DK_BULK_ISA_AVX2,
+
+    DK_BULK_ISA_COUNT,
+} dk_bulk_isa;
+
+static readonly str dk_bulk_op_names[DK_BULK_OP_COUNT] = {
+    [DK_BULK_OP_NONE]  = STR("none"),
+    [DK_BULK_OP_SUM]   = STR("sum"),
+    [DK_BULK_OP_DOT]   = STR("dot"),
+    [DK_BULK_OP_MIN]   = STR("min"),
+    [DK_BULK_OP_MAX]   = STR("max"),
+    [DK_BULK_OP_ADD]   = STR("add"),
+    [DK_BULK_OP_MUL]   = STR("mul"),
+    [DK_BULK_OP_SCALE] = STR("scale"),
+};
+
+static readonly str dk_bulk_isa_names[DK_BULK_ISA_COUNT] = {
+    [DK_BULK_ISA_SCALAR] = STR("scalar"),
+    [DK_BULK_ISA_SSE2]   = STR("sse2"),
+    [DK_BULK_ISA_AVX2]   = STR("avx2"),
+};
+
+// NOTE(rune): The bulk instruction operand packs the kernel id and the local offsets of both lists. In checked builds,
+// kernels which can overflow also set the checked bit, and pop the source position of the call before any scalar.
+#define DK_BULK_OPERAND_CHECKED                     (u64(1) << 7)
+#define dk_bulk_operand(kernel, dst_off, src_off)   (u64(kernel) | (u64(dst_off) << 8) | (u64(src_off) << 36))
+#define dk_bulk_operand_kernel(operand)             ((dk_bulk_kernel)((operand) & 0x7f))
+#define dk_bulk_operand_checked(operand)            (((operand) & DK_BULK_OPERAND_CHECKED) != 0)
+#define dk_bulk_operand_dst(operand)                (((operand) >> 8) & 0xfffffff)
+#define dk_bulk_operand_src(operand)                ((operand) >> 36)
+
+static dk_bulk_isa   dk_bulk_detect_isa(void);
+static void          dk_bulk_select_isa(dk_bulk_isa isa);
+static dk_bulk_isa   dk_bulk_selected_isa(void);
+static dk_bulk_func *dk_bulk_get_func(dk_bulk_kernel kernel);
+static bool          dk_bulk_kernel_can_overflow(dk_bulk_kernel kernel);
+
+////////////////////////////////////////////////////////////////
+// rune: Vector kernels
+
+// NOTE(rune): 4-wide float math for values of type vektor. SSE is part of the x86-64 baseline,
+// so unlike the bulk kernels, these need no runtime dispatch.
+static vec4 dk_vec4_add(vec4 a, vec4 b);
+static vec4 dk_vec4_mul(vec4 a, vec4 b);
+static vec4 dk_vec4_fma(vec4 a, vec4 b, vec4 c); // a * b + c
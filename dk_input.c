@@ -0,0 +1,289 @@
+////////////////////////////////////////////////////////////////
+// rune: Program input
+
+#if !_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static dk_input dk_input_from_str(str data) {
+    dk_input input = { 0 };
+    input.data = data.v;
+    input.len  = data.len;
+    input.eof  = true;
+    return input;
+}
+
+static dk_input dk_input_from_stream(FILE *stream) {
+    dk_input input = { 0 };
+    input.stream = stream;
+    return input;
+}
+
+// NOTE(rune): Files are memory mapped where possible, so the whole file is parsed in place without copying.
+// Falls back to reading the file as a stream.
+static bool dk_input_open_file(dk_input *input, str file_name) {
+    bool ok = false;
+    mem_zero_struct(input);
+
+#if !_WIN32
+    int fd = open((char *)file_name.v, O_RDONLY);
+    if (fd != -1) {
+        struct stat st = { 0 };
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *mapped = mmap(null, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+                input->mapped      = mapped;
+                input->mapped_size = st.st_size;
+                input->data        = mapped;
+                input->len         = st.st_size;
+                input->eof         = true;
+                ok = true;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    if (!ok) {
+        FILE *stream = fopen((char *)file_name.v, "rb");
+        if (stream) {
+            *input = dk_input_from_stream(stream);
+            ok = true;
+        }
+    }
+
+    return ok;
+}
+
+static void dk_input_close(dk_input *input) {
+#if !_WIN32
+    if (input->mapped) {
+        munmap(input->mapped, input->mapped_size);
+    }
+#endif
+
+    if (input->stream && input->stream != stdin) {
+        fclose(input->stream);
+    }
+
+    heap_free(input->buf);
+    mem_zero_struct(input);
+}
+
+// NOTE(rune): Moves the unread bytes to the front of the buffer, and reads the next block after them.
+// Returns false when the stream has no more bytes.
+static bool dk_input_refill(dk_input *input) {
+    if (input->eof) {
+        return false;
+    }
+
+    i64 unread = input->len - input->pos;
+    if (input->buf_cap - unread < DK_INPUT_BLOCK_SIZE) {
+        i64 new_cap = max(input->buf_cap * 2, DK_INPUT_BLOCK_SIZE);
+        input->buf     = heap_realloc(input->buf, new_cap);
+        input->buf_cap = new_cap;
+        input->data    = input->buf; // NOTE(rune): Stream windows always point into buf.
+    }
+
+    if (unread > 0) {
+        memmove(input->buf, input->data + input->pos, unread);
+    }
+    input->data = input->buf;
+    input->pos  = 0;
+    input->len  = unread;
+
+    i64 got = (i64)fread(input->buf + unread, 1, input->buf_cap - unread, input->stream);
+    input->len += got;
+    if (got == 0) {
+        input->eof = true;
+    }
+
+    return got > 0;
+}
+
+static bool dk_input_has_more(dk_input *input) {
+    while (1) {
+        while (input->pos < input->len && u8_is_whitespace(input->data[input->pos])) {
+            input->pos++;
+        }
+
+        if (input->pos < input->len) {
+            return true;
+        }
+
+        if (!dk_input_refill(input)) {
+            return false;
+        }
+    }
+}
+
+// NOTE(rune): Returns the next whitespace separated token, or an empty string at the end of the input.
+// The token points into the window, and is only valid until the next read.
+static str dk_input_next_token(dk_input *input) {
+    str ret = { 0 };
+    if (dk_input_has_more(input)) {
+        i64 end = input->pos;
+        while (1) {
+            while (end < input->len && !u8_is_whitespace(input->data[end])) {
+                end++;
+            }
+
+            // NOTE(rune): Token crosses the end of the window, so refill and keep scanning from the same offset.
+            if (end == input->len) {
+                i64 scanned = end - input->pos;
+                bool refilled = dk_input_refill(input);
+                end = input->pos + scanned; // NOTE(rune): The window moves on refill, even when no bytes were read.
+                if (refilled) {
+                    continue;
+                }
+            }
+
+            break;
+        }
+
+        ret = str_make(input->data + input->pos, end - input->pos);
+        input->pos = end;
+    }
+    return ret;
+}
+
+// NOTE(rune): Reads the next line without the line ending. Returns false at the end of the input. Like tokens, the
+// line points into the window, and is only valid until the next read.
+static bool dk_input_next_line(dk_input *input, str *line) {
+    i64 end = input->pos;
+    while (1) {
+        while (end < input->len && input->data[end] != '\n') {
+            end++;
+        }
+
+        // NOTE(rune): Line crosses the end of the window, so refill and keep scanning from the same offset.
+        if (end == input->len) {
+            i64 scanned = end - input->pos;
+            bool refilled = dk_input_refill(input);
+            end = input->pos + scanned; // NOTE(rune): The window moves on refill, even when no bytes were read.
+            if (refilled) {
+                continue;
+            }
+        }
+
+        break;
+    }
+
+    if (end == input->pos && end == input->len) {
+        return false;
+    }
+
+    *line = str_make(input->data + input->pos, end - input->pos);
+    if (line->len > 0 && line->v[line->len - 1] == '\r') {
+        line->len--;
+    }
+
+    input->pos = min(end + 1, input->len);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Decimal parsing
+
+static bool dk_parse_int(str s, i64 *value) {
+    i64 i = 0;
+    bool neg = false;
+    if (i < s.len && (s.v[i] == '-' || s.v[i] == '+')) {
+        neg = s.v[i] == '-';
+        i++;
+    }
+
+    // NOTE(rune): Magnitude is accumulated as unsigned, so the most negative heltal can be parsed too.
+    u64 limit = neg ? u64(I64_MAX) + 1 : u64(I64_MAX);
+    u64 mag   = 0;
+    i64 digits_begin = i;
+    for (; i < s.len; i++) {
+        u8 c = s.v[i];
+        if (!u8_is_digit(c)) {
+            return false;
+        }
+
+        u64 d = c - '0';
+        if (mag > (limit - d) / 10) {
+            return false;
+        }
+        mag = mag * 10 + d;
+    }
+
+    if (i == digits_begin) {
+        return false;
+    }
+
+    *value = neg ? i64(0 - mag) : i64(mag);
+    return true;
+}
+
+static bool dk_parse_float(str s, f64 *value) {
+    static readonly f64 pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    i64 i = 0;
+    bool neg = false;
+    if (i < s.len && (s.v[i] == '-' || s.v[i] == '+')) {
+        neg = s.v[i] == '-';
+        i++;
+    }
+
+    // rune: Scan digits, with at most one decimal comma between digits.
+    u64 mantissa   = 0;
+    i64 digits     = 0;
+    i64 frac       = 0;
+    bool got_comma = false;
+    for (; i < s.len; i++) {
+        u8 c = s.v[i];
+        if (u8_is_digit(c)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (c - '0');
+            }
+            if (mantissa != 0 || got_comma) {
+                digits++;
+            }
+            if (got_comma) {
+                frac++;
+            }
+        } else if (c == ',' && !got_comma && i > 0 && u8_is_digit(s.v[i - 1]) && i + 1 < s.len && u8_is_digit(s.v[i + 1])) {
+            got_comma = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (s.len == 0 || !u8_is_digit(s.v[s.len - 1])) {
+        return false;
+    }
+
+    // NOTE(rune): When the mantissa and the power of ten are both exact doubles, a single division is correctly
+    // rounded. Otherwise fall back to strtod, like the tokenizer.
+    f64 result = 0;
+    if (digits <= 19 && mantissa <= (u64(1) << 53) && frac < countof(pow10)) {
+        result = f64(mantissa) / pow10[frac];
+    } else {
+        char temp[256];
+        if (s.len + 1 > sizeof(temp)) {
+            return false;
+        }
+
+        memcpy(temp, s.v, s.len);
+        temp[s.len] = '\0';
+        for_n (i64, j, s.len) {
+            if (temp[j] == ',') temp[j] = '.';
+        }
+
+        result = strtod(temp, null);
+        neg    = false;
+    }
+
+    *value = neg ? -result : result;
+    return true;
+}
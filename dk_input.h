@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////
+// rune: Program input
+
+// NOTE(rune): Whitespace separated numbers read by the input intrinsics. The input is either a string, a file
+// which is memory mapped, or a stream (stdin) which is read in large blocks. In all cases the parser works on
+// a window of unread bytes, and a stream refills the window when a number crosses the end of it.
+
+typedef struct dk_input dk_input;
+struct dk_input {
+    u8 *data;       // NOTE(rune): Window of unread bytes is data[pos..len).
+    i64 pos;
+    i64 len;
+
+    FILE *stream;   // NOTE(rune): Only set for streams.
+    u8 *buf;
+    i64 buf_cap;
+    bool eof;
+
+    void *mapped;   // NOTE(rune): Only set for memory mapped files.
+    i64 mapped_size;
+};
+
+#define DK_INPUT_BLOCK_SIZE kilobytes(256)
+
+static dk_input dk_input_from_str(str data);
+static dk_input dk_input_from_stream(FILE *stream);
+static bool     dk_input_open_file(dk_input *input, str file_name);
+static void     dk_input_close(dk_input *input);
+
+static bool     dk_input_has_more(dk_input *input);
+static str      dk_input_next_token(dk_input *input);
+static bool     dk_input_next_line(dk_input *input, str *line);
+
+// NOTE(rune): Decimal parsers for a single token. Floats use the danish decimal comma, like the tokenizer.
+static bool     dk_parse_int(str s, i64 *value);
+static bool     dk_parse_float(str s, f64 *value);
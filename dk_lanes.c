@@ -0,0 +1,947 @@
+////////////////////////////////////////////////////////////////
+// rune: Scalar kernels
+
+#define DK_LANES_SCALAR_KERNEL(name, calc)                              \
+    static u32 dk_lanes_##name##_scalar(u64 *x, u64 *y, u32 mask) {   \
+        for_n (i64, lane, DK_LANES_MAX) {                               \
+            if (mask & (1u << lane)) {                                  \
+                u64 a = x[lane];                                        \
+                u64 b = y[lane];                                        \
+                x[lane] = calc;                                         \
+            }                                                           \
+        }                                                               \
+        return 0;                                                       \
+    }
+
+DK_LANES_SCALAR_KERNEL(add,  a + b)
+DK_LANES_SCALAR_KERNEL(sub,  a - b)
+DK_LANES_SCALAR_KERNEL(mul,  a * b)
+DK_LANES_SCALAR_KERNEL(band, a & b)
+DK_LANES_SCALAR_KERNEL(bor,  a | b)
+DK_LANES_SCALAR_KERNEL(bxor, a ^ b)
+DK_LANES_SCALAR_KERNEL(shl,  a << (b & 63))
+DK_LANES_SCALAR_KERNEL(shr,  u64(i64(a) >> (b & 63)))
+DK_LANES_SCALAR_KERNEL(fadd, u64_from_f64(f64_from_u64(a) + f64_from_u64(b)))
+DK_LANES_SCALAR_KERNEL(fsub, u64_from_f64(f64_from_u64(a) - f64_from_u64(b)))
+DK_LANES_SCALAR_KERNEL(fmul, u64_from_f64(f64_from_u64(a) * f64_from_u64(b)))
+DK_LANES_SCALAR_KERNEL(fdiv, u64_from_f64(f64_from_u64(a) / f64_from_u64(b)))
+DK_LANES_SCALAR_KERNEL(imin, i64(a) < i64(b) ? a : b)
+DK_LANES_SCALAR_KERNEL(imax, i64(a) > i64(b) ? a : b)
+DK_LANES_SCALAR_KERNEL(fmin, u64_from_f64(fmin(f64_from_u64(a), f64_from_u64(b))))
+DK_LANES_SCALAR_KERNEL(fmax, u64_from_f64(fmax(f64_from_u64(a), f64_from_u64(b))))
+DK_LANES_SCALAR_KERNEL(fpow, u64_from_f64(pow(f64_from_u64(a), f64_from_u64(b))))
+DK_LANES_SCALAR_KERNEL(and,  a && b)
+DK_LANES_SCALAR_KERNEL(or,   a || b)
+DK_LANES_SCALAR_KERNEL(eq,   i64(a) == i64(b))
+DK_LANES_SCALAR_KERNEL(lt,   i64(a) < i64(b))
+DK_LANES_SCALAR_KERNEL(gt,   i64(a) > i64(b))
+DK_LANES_SCALAR_KERNEL(feq,  f64_from_u64(a) == f64_from_u64(b))
+DK_LANES_SCALAR_KERNEL(flt,  f64_from_u64(a) < f64_from_u64(b))
+DK_LANES_SCALAR_KERNEL(fgt,  f64_from_u64(a) > f64_from_u64(b))
+
+#undef DK_LANES_SCALAR_KERNEL
+
+// NOTE(rune): Divisions which would fault in dk_vm_resume() are reported as faults instead of being run.
+static u32 dk_lanes_udiv_scalar(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (mask & (1u << lane)) {
+            if (y[lane] == 0) {
+                fault |= 1u << lane;
+            } else {
+                x[lane] = x[lane] / y[lane];
+            }
+        }
+    }
+    return fault;
+}
+
+static u32 dk_lanes_idiv_scalar(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (mask & (1u << lane)) {
+            i64 a = i64(x[lane]);
+            i64 b = i64(y[lane]);
+            if (b == 0 || (a == I64_MIN && b == -1)) {
+                fault |= 1u << lane;
+            } else {
+                x[lane] = u64(a / b);
+            }
+        }
+    }
+    return fault;
+}
+
+static u32 dk_lanes_mod_scalar(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (mask & (1u << lane)) {
+            i64 a = i64(x[lane]);
+            i64 b = i64(y[lane]);
+            if (b == 0 || (a == I64_MIN && b == -1)) {
+                fault |= 1u << lane;
+            } else {
+                x[lane] = u64(a % b);
+            }
+        }
+    }
+    return fault;
+}
+
+static u32 dk_lanes_addc_scalar(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (mask & (1u << lane)) {
+            i64 c = 0;
+            if (dk_add_overflow(i64(x[lane]), i64(y[lane]), &c)) fault |= 1u << lane;
+            else x[lane] = u64(c);
+        }
+    }
+    return fault;
+}
+
+static u32 dk_lanes_subc_scalar(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (mask & (1u << lane)) {
+            i64 c = 0;
+            if (dk_sub_overflow(i64(x[lane]), i64(y[lane]), &c)) fault |= 1u << lane;
+            else x[lane] = u64(c);
+        }
+    }
+    return fault;
+}
+
+static u32 dk_lanes_imulc_scalar(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (mask & (1u << lane)) {
+            i64 c = 0;
+            if (dk_mul_overflow(i64(x[lane]), i64(y[lane]), &c)) fault |= 1u << lane;
+            else x[lane] = u64(c);
+        }
+    }
+    return fault;
+}
+
+// NOTE(rune): Same checks as the checked division in dk_vm_resume(), except I64_MIN % -1, which is just 0.
+static u32 dk_lanes_modc_scalar(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (mask & (1u << lane)) {
+            i64 a = i64(x[lane]);
+            i64 b = i64(y[lane]);
+            if (b == 0) {
+                fault |= 1u << lane;
+            } else {
+                x[lane] = b == -1 ? 0 : u64(a % b);
+            }
+        }
+    }
+    return fault;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: AVX2 kernels
+
+#if DK_BULK_X86
+
+DK_BULK_TARGET_AVX2
+static __m256i dk_lanes_mask_avx2(u32 mask) {
+    __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(mask), bits), bits);
+}
+
+// NOTE(rune): AVX2 has no 64-bit arithmetic shift, so the sign is shifted in from the left separately.
+// Shifting left by 64 gives zero, which covers a shift count of zero.
+DK_BULK_TARGET_AVX2
+static __m256i dk_lanes_sra_epi64_avx2(__m256i a, __m256i n) {
+    __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), a);
+    __m256i fill = _mm256_sllv_epi64(sign, _mm256_sub_epi64(_mm256_set1_epi64x(64), n));
+    return _mm256_or_si256(_mm256_srlv_epi64(a, n), fill);
+}
+
+// NOTE(rune): Lanes outside of the mask are computed too, but their old value is blended back in.
+#define DK_LANES_AVX2_KERNEL(name, calc)                                                \
+    DK_BULK_TARGET_AVX2                                                                 \
+    static u32 dk_lanes_##name##_avx2(u64 *x, u64 *y, u32 mask) {                      \
+        __m256i one = _mm256_set1_epi64x(1);                                            \
+        __m256i zero = _mm256_setzero_si256();                                          \
+        unused(one);                                                                    \
+        unused(zero);                                                                   \
+        for (i64 i = 0; i < DK_LANES_MAX; i += 4) {                                     \
+            __m256i a = _mm256_loadu_si256((__m256i *)(x + i));                         \
+            __m256i b = _mm256_loadu_si256((__m256i *)(y + i));                         \
+            __m256i c = calc;                                                           \
+            __m256i m = dk_lanes_mask_avx2(mask >> i);                                  \
+            _mm256_storeu_si256((__m256i *)(x + i), _mm256_blendv_epi8(a, c, m));       \
+        }                                                                               \
+        return 0;                                                                       \
+    }
+
+#define DK_LANES_PD(a)          _mm256_castsi256_pd(a)
+#define DK_LANES_SI(a)          _mm256_castpd_si256(a)
+#define DK_LANES_FCMP(a, b, op) _mm256_and_si256(DK_LANES_SI(_mm256_cmp_pd(DK_LANES_PD(a), DK_LANES_PD(b), op)), one)
+
+DK_LANES_AVX2_KERNEL(add,  _mm256_add_epi64(a, b))
+DK_LANES_AVX2_KERNEL(sub,  _mm256_sub_epi64(a, b))
+DK_LANES_AVX2_KERNEL(mul,  dk_bulk_mullo_epi64_avx2(a, b))
+DK_LANES_AVX2_KERNEL(band, _mm256_and_si256(a, b))
+DK_LANES_AVX2_KERNEL(bor,  _mm256_or_si256(a, b))
+DK_LANES_AVX2_KERNEL(bxor, _mm256_xor_si256(a, b))
+DK_LANES_AVX2_KERNEL(shl,  _mm256_sllv_epi64(a, _mm256_and_si256(b, _mm256_set1_epi64x(63))))
+DK_LANES_AVX2_KERNEL(shr,  dk_lanes_sra_epi64_avx2(a, _mm256_and_si256(b, _mm256_set1_epi64x(63))))
+DK_LANES_AVX2_KERNEL(fadd, DK_LANES_SI(_mm256_add_pd(DK_LANES_PD(a), DK_LANES_PD(b))))
+DK_LANES_AVX2_KERNEL(fsub, DK_LANES_SI(_mm256_sub_pd(DK_LANES_PD(a), DK_LANES_PD(b))))
+DK_LANES_AVX2_KERNEL(fmul, DK_LANES_SI(_mm256_mul_pd(DK_LANES_PD(a), DK_LANES_PD(b))))
+DK_LANES_AVX2_KERNEL(fdiv, DK_LANES_SI(_mm256_div_pd(DK_LANES_PD(a), DK_LANES_PD(b))))
+DK_LANES_AVX2_KERNEL(imin, _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)))
+DK_LANES_AVX2_KERNEL(imax, _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a)))
+DK_LANES_AVX2_KERNEL(and,  _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi64(a, zero), _mm256_cmpeq_epi64(b, zero)), one))
+DK_LANES_AVX2_KERNEL(or,   _mm256_andnot_si256(_mm256_and_si256(_mm256_cmpeq_epi64(a, zero), _mm256_cmpeq_epi64(b, zero)), one))
+DK_LANES_AVX2_KERNEL(eq,   _mm256_and_si256(_mm256_cmpeq_epi64(a, b), one))
+DK_LANES_AVX2_KERNEL(lt,   _mm256_and_si256(_mm256_cmpgt_epi64(b, a), one))
+DK_LANES_AVX2_KERNEL(gt,   _mm256_and_si256(_mm256_cmpgt_epi64(a, b), one))
+DK_LANES_AVX2_KERNEL(feq,  DK_LANES_FCMP(a, b, _CMP_EQ_OQ))
+DK_LANES_AVX2_KERNEL(flt,  DK_LANES_FCMP(a, b, _CMP_LT_OQ))
+DK_LANES_AVX2_KERNEL(fgt,  DK_LANES_FCMP(a, b, _CMP_GT_OQ))
+
+#undef DK_LANES_AVX2_KERNEL
+#undef DK_LANES_PD
+#undef DK_LANES_SI
+#undef DK_LANES_FCMP
+
+// NOTE(rune): Signed overflow happened when the result has a different sign than both operands (add), or than
+// the first operand, when the operands have different signs (sub).
+DK_BULK_TARGET_AVX2
+static u32 dk_lanes_addc_avx2(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for (i64 i = 0; i < DK_LANES_MAX; i += 4) {
+        __m256i a   = _mm256_loadu_si256((__m256i *)(x + i));
+        __m256i b   = _mm256_loadu_si256((__m256i *)(y + i));
+        __m256i c   = _mm256_add_epi64(a, b);
+        __m256i m   = dk_lanes_mask_avx2(mask >> i);
+        __m256i ovf = _mm256_and_si256(_mm256_and_si256(_mm256_xor_si256(a, c), _mm256_xor_si256(b, c)), m);
+        fault |= u32(_mm256_movemask_pd(_mm256_castsi256_pd(ovf))) << i;
+        _mm256_storeu_si256((__m256i *)(x + i), _mm256_blendv_epi8(a, c, m));
+    }
+    return fault;
+}
+
+DK_BULK_TARGET_AVX2
+static u32 dk_lanes_subc_avx2(u64 *x, u64 *y, u32 mask) {
+    u32 fault = 0;
+    for (i64 i = 0; i < DK_LANES_MAX; i += 4) {
+        __m256i a   = _mm256_loadu_si256((__m256i *)(x + i));
+        __m256i b   = _mm256_loadu_si256((__m256i *)(y + i));
+        __m256i c   = _mm256_sub_epi64(a, b);
+        __m256i m   = dk_lanes_mask_avx2(mask >> i);
+        __m256i ovf = _mm256_and_si256(_mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, c)), m);
+        fault |= u32(_mm256_movemask_pd(_mm256_castsi256_pd(ovf))) << i;
+        _mm256_storeu_si256((__m256i *)(x + i), _mm256_blendv_epi8(a, c, m));
+    }
+    return fault;
+}
+
+#endif // DK_BULK_X86
+
+////////////////////////////////////////////////////////////////
+// rune: Kernel dispatch
+
+// NOTE(rune): Null entries fall back to the next slower isa. There are no SSE2 kernels, since two lanes per
+// register is not worth the extra blending. Divisions, pow and float min/max have no vector instructions with
+// the same results, so they are always scalar.
+static dk_lanes_func *dk_lanes_funcs[DK_BULK_ISA_COUNT][DK_BC_OPCODE_COUNT] = {
+    [DK_BULK_ISA_SCALAR] = {
+        [DK_BC_OPCODE_ADD]   = dk_lanes_add_scalar,
+        [DK_BC_OPCODE_SUB]   = dk_lanes_sub_scalar,
+        [DK_BC_OPCODE_UMUL]  = dk_lanes_mul_scalar,
+        [DK_BC_OPCODE_IMUL]  = dk_lanes_mul_scalar,
+        [DK_BC_OPCODE_UDIV]  = dk_lanes_udiv_scalar,
+        [DK_BC_OPCODE_IDIV]  = dk_lanes_idiv_scalar,
+        [DK_BC_OPCODE_MOD]   = dk_lanes_mod_scalar,
+        [DK_BC_OPCODE_ADDC]  = dk_lanes_addc_scalar,
+        [DK_BC_OPCODE_SUBC]  = dk_lanes_subc_scalar,
+        [DK_BC_OPCODE_IMULC] = dk_lanes_imulc_scalar,
+        [DK_BC_OPCODE_IDIVC] = dk_lanes_idiv_scalar,
+        [DK_BC_OPCODE_MODC]  = dk_lanes_modc_scalar,
+        [DK_BC_OPCODE_BAND]  = dk_lanes_band_scalar,
+        [DK_BC_OPCODE_BOR]   = dk_lanes_bor_scalar,
+        [DK_BC_OPCODE_BXOR]  = dk_lanes_bxor_scalar,
+        [DK_BC_OPCODE_SHL]   = dk_lanes_shl_scalar,
+        [DK_BC_OPCODE_SHR]   = dk_lanes_shr_scalar,
+        [DK_BC_OPCODE_FADD]  = dk_lanes_fadd_scalar,
+        [DK_BC_OPCODE_FSUB]  = dk_lanes_fsub_scalar,
+        [DK_BC_OPCODE_FMUL]  = dk_lanes_fmul_scalar,
+        [DK_BC_OPCODE_FDIV]  = dk_lanes_fdiv_scalar,
+        [DK_BC_OPCODE_IMIN]  = dk_lanes_imin_scalar,
+        [DK_BC_OPCODE_IMAX]  = dk_lanes_imax_scalar,
+        [DK_BC_OPCODE_FMIN]  = dk_lanes_fmin_scalar,
+        [DK_BC_OPCODE_FMAX]  = dk_lanes_fmax_scalar,
+        [DK_BC_OPCODE_FPOW]  = dk_lanes_fpow_scalar,
+        [DK_BC_OPCODE_AND]   = dk_lanes_and_scalar,
+        [DK_BC_OPCODE_OR]    = dk_lanes_or_scalar,
+        [DK_BC_OPCODE_EQ]    = dk_lanes_eq_scalar,
+        [DK_BC_OPCODE_LT]    = dk_lanes_lt_scalar,
+        [DK_BC_OPCODE_GT]    = dk_lanes_gt_scalar,
+        [DK_BC_OPCODE_FEQ]   = dk_lanes_feq_scalar,
+        [DK_BC_OPCODE_FLT]   = dk_lanes_flt_scalar,
+        [DK_BC_OPCODE_FGT]   = dk_lanes_fgt_scalar,
+    },
+#if DK_BULK_X86
+    [DK_BULK_ISA_AVX2] = {
+        [DK_BC_OPCODE_ADD]   = dk_lanes_add_avx2,
+        [DK_BC_OPCODE_SUB]   = dk_lanes_sub_avx2,
+        [DK_BC_OPCODE_UMUL]  = dk_lanes_mul_avx2,
+        [DK_BC_OPCODE_IMUL]  = dk_lanes_mul_avx2,
+        [DK_BC_OPCODE_ADDC]  = dk_lanes_addc_avx2,
+        [DK_BC_OPCODE_SUBC]  = dk_lanes_subc_avx2,
+        [DK_BC_OPCODE_BAND]  = dk_lanes_band_avx2,
+        [DK_BC_OPCODE_BOR]   = dk_lanes_bor_avx2,
+        [DK_BC_OPCODE_BXOR]  = dk_lanes_bxor_avx2,
+        [DK_BC_OPCODE_SHL]   = dk_lanes_shl_avx2,
+        [DK_BC_OPCODE_SHR]   = dk_lanes_shr_avx2,
+        [DK_BC_OPCODE_FADD]  = dk_lanes_fadd_avx2,
+        [DK_BC_OPCODE_FSUB]  = dk_lanes_fsub_avx2,
+        [DK_BC_OPCODE_FMUL]  = dk_lanes_fmul_avx2,
+        [DK_BC_OPCODE_FDIV]  = dk_lanes_fdiv_avx2,
+        [DK_BC_OPCODE_IMIN]  = dk_lanes_imin_avx2,
+        [DK_BC_OPCODE_IMAX]  = dk_lanes_imax_avx2,
+        [DK_BC_OPCODE_AND]   = dk_lanes_and_avx2,
+        [DK_BC_OPCODE_OR]    = dk_lanes_or_avx2,
+        [DK_BC_OPCODE_EQ]    = dk_lanes_eq_avx2,
+        [DK_BC_OPCODE_LT]    = dk_lanes_lt_avx2,
+        [DK_BC_OPCODE_GT]    = dk_lanes_gt_avx2,
+        [DK_BC_OPCODE_FEQ]   = dk_lanes_feq_avx2,
+        [DK_BC_OPCODE_FLT]   = dk_lanes_flt_avx2,
+        [DK_BC_OPCODE_FGT]   = dk_lanes_fgt_avx2,
+    },
+#endif
+};
+
+static dk_lanes_func *dk_lanes_get_func(dk_bc_opcode opcode) {
+    assert(opcode < DK_BC_OPCODE_COUNT);
+
+    dk_lanes_func *ret = null;
+    for (i64 isa = dk_bulk_selected_isa(); isa >= 0 && ret == null; isa--) {
+        ret = dk_lanes_funcs[isa][opcode];
+    }
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Api
+
+static void dk_lanes_init(dk_lanes *lanes) {
+    mem_zero_struct(lanes);
+}
+
+static void dk_lanes_destroy(dk_lanes *lanes) {
+    heap_free(lanes->data_stack);
+    heap_free(lanes->locals);
+    heap_free(lanes->globals);
+    heap_free(lanes->frames);
+    if (lanes->fallback_vm) {
+        dk_lib_vm_destroy(lanes->fallback_vm);
+    }
+    mem_zero_struct(lanes);
+}
+
+static void dk_lanes_call(dk_lanes *lanes, dk_lib_program *program, dk_bc_symbol *func, u64 *args, i64 arg_count,
+                          i64 lane_count, dk_lib_result *results, arena *output_arena) {
+    assert(lane_count >= 0 && lane_count <= DK_LANES_MAX);
+
+    if (program->lockstep && func != null && arg_count == func->arg_slots) {
+        lanes->output_arena = output_arena;
+        dk_lanes_start(lanes, &program->program, func, args, arg_count, lane_count);
+        dk_lanes_run(lanes);
+
+        for_n (i64, lane, lane_count) {
+            dk_lib_result *result = &results[lane];
+            mem_zero_struct(result);
+
+            str_list *output = &lanes->output[lane];
+            if (!lanes->failed[lane]) {
+                result->ok          = true;
+                result->values      = lanes->values[lane];
+                result->value_count = lanes->value_count[lane];
+                if (result->value_count != func->ret_slots) {
+                    str_list_push_fmt(output, output_arena, "Invalid stack size on exit. Was % but expected %.", result->value_count * 8, func->ret_slots * 8);
+                    result->ok = false;
+                }
+            }
+            result->output = str_list_concat(output, output_arena);
+        }
+    } else {
+        // rune: One lane at a time. Errors in the program or the arguments are reported by dk_lib_call() too.
+        if (lanes->fallback_vm == null) {
+            lanes->fallback_vm = dk_lib_vm_create();
+        }
+
+        for_n (i64, lane, lane_count) {
+            results[lane] = dk_lib_call(lanes->fallback_vm, program, func, args + lane * arg_count, arg_count, null, output_arena);
+
+            // NOTE(rune): Values are on the data stack of the vm, which is reused by the next lane.
+            if (results[lane].value_count > 0) {
+                results[lane].values = arena_copy_size(output_arena, results[lane].values, results[lane].value_count * sizeof(u64), alignof(u64));
+            }
+        }
+    }
+}
+
+static dk_bc_opcode dk_lanes_read_inst(dk_buffer *body, i64 *ip, u64 *operand) {
+    dk_bc_inst_prefix prefix = *dk_buffer_read_struct(body, ip, dk_bc_inst_prefix);
+    *operand = 0;
+    if (dk_bc_opcode_infos[prefix.opcode].operand_kind != DK_BC_OPERAND_KIND_NONE) {
+        switch (prefix.operand_size) {
+            case 0: *operand = (u64)dk_buffer_read_u8(body, ip);  break;
+            case 1: *operand = (u64)dk_buffer_read_u16(body, ip); break;
+            case 2: *operand = (u64)dk_buffer_read_u32(body, ip); break;
+            case 3: *operand = (u64)dk_buffer_read_u64(body, ip); break;
+        }
+    }
+
+    assert(prefix.opcode < DK_BC_OPCODE_COUNT);
+    return prefix.opcode;
+}
+
+static bool dk_lanes_supported(dk_program *program) {
+    dk_buffer *body = &program->body;
+    bool ret = true;
+
+    i64 pos = 0;
+    while (pos < body->size && ret) {
+        u64 operand = 0;
+        dk_bc_opcode opcode = dk_lanes_read_inst(body, &pos, &operand);
+        switch (opcode) {
+            case DK_BC_OPCODE_BULK:
+            case DK_BC_OPCODE_LDF:   case DK_BC_OPCODE_STF:
+            case DK_BC_OPCODE_LDF8:  case DK_BC_OPCODE_LDF16: case DK_BC_OPCODE_LDF32:
+            case DK_BC_OPCODE_STF8:  case DK_BC_OPCODE_STF16: case DK_BC_OPCODE_STF32:
+            case DK_BC_OPCODE_VMAKE: case DK_BC_OPCODE_VADD:  case DK_BC_OPCODE_VMUL:  case DK_BC_OPCODE_VFMA:
+            case DK_BC_OPCODE_TLEN:  case DK_BC_OPCODE_TEQ:   case DK_BC_OPCODE_TFIND: case DK_BC_OPCODE_TSLICE:
+            case DK_BC_OPCODE_MAPNEW: case DK_BC_OPCODE_MAPFREE: case DK_BC_OPCODE_MAPPUT: case DK_BC_OPCODE_MAPGET:
+            case DK_BC_OPCODE_MAPDEL: case DK_BC_OPCODE_MAPHAS:  case DK_BC_OPCODE_MAPLEN:
+            case DK_BC_OPCODE_INI:   case DK_BC_OPCODE_INF:   case DK_BC_OPCODE_INMORE:
+            case DK_BC_OPCODE_PFOR: {
+                ret = false;
+            } break;
+
+            // NOTE(rune): Built-in procedures print.
+            case DK_BC_OPCODE_CALL: {
+                if (u32(operand) >= 0xdeadbeef) {
+                    ret = false;
+                }
+            } break;
+
+            // rune: Skip inline jump table.
+            case DK_BC_OPCODE_SWITCH: {
+                pos += isizeof(dk_bc_switch_header) + i64(operand) * isizeof(dk_bc_switch_entry);
+            } break;
+
+            default: break;
+        }
+    }
+
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Interpreter
+
+static void *dk_lanes_reserve(void *rows, i64 *row_count, i64 needed, i64 row_size) {
+    if (needed > *row_count) {
+        i64 next_count = max(*row_count * 2, 64);
+        while (next_count < needed) {
+            next_count *= 2;
+        }
+
+        rows       = heap_realloc(rows, next_count * row_size);
+        *row_count = next_count;
+    }
+    return rows;
+}
+
+static void dk_lanes_start(dk_lanes *lanes, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count, i64 lane_count) {
+    assert(lane_count <= DK_LANES_MAX);
+
+    lanes->program    = program;
+    lanes->entry      = entry;
+    lanes->lane_count = lane_count;
+    lanes->live       = (1u << lane_count) - 1;
+
+    // NOTE(rune): Looked up on each call, since the selected isa can change between calls.
+    for_n (i64, opcode, DK_BC_OPCODE_COUNT) {
+        lanes->funcs[opcode] = dk_lanes_get_func((dk_bc_opcode)opcode);
+    }
+
+    // rune: Arguments are popped by the prologue of the entry function, the same as in dk_vm_start().
+    i64 row_size = DK_LANES_MAX * isizeof(u64);
+    lanes->data_stack = dk_lanes_reserve(lanes->data_stack, &lanes->data_stack_rows, arg_count + 1, row_size);
+    for_n (i64, lane, lane_count) {
+        for_n (i64, i, arg_count) {
+            lanes->data_stack[i * DK_LANES_MAX + lane] = args[lane * arg_count + i];
+        }
+
+        lanes->ip[lane]          = entry->pos;
+        lanes->sp[lane]          = arg_count;
+        lanes->depth[lane]       = 0;
+        lanes->failed[lane]      = false;
+        lanes->values[lane]      = null;
+        lanes->value_count[lane] = 0;
+        mem_zero_struct(&lanes->output[lane]);
+    }
+
+    // rune: Copy initial values of globals into every lane.
+    i64 global_count = program->data.size / 8;
+    u64 *initial     = (u64 *)program->data.data;
+    lanes->globals   = dk_lanes_reserve(lanes->globals, &lanes->globals_rows, global_count, row_size);
+    for_n (i64, i, global_count) {
+        for_n (i64, lane, DK_LANES_MAX) {
+            lanes->globals[i * DK_LANES_MAX + lane] = initial[i];
+        }
+    }
+
+    // rune: Setup initial call frames.
+    i64 loc_rows  = (entry->size + 7) / 8;
+    lanes->frames = dk_lanes_reserve(lanes->frames, &lanes->frame_rows, 1, DK_LANES_MAX * isizeof(dk_call_frame));
+    lanes->locals = dk_lanes_reserve(lanes->locals, &lanes->locals_rows, loc_rows, row_size);
+    for_n (i64, lane, DK_LANES_MAX) {
+        dk_call_frame *frame = &lanes->frames[lane];
+        frame->loc_base   = 0;
+        frame->loc_size   = loc_rows;
+        frame->return_pos = -1;
+        frame->prev_pos   = -1;
+    }
+    mem_zero_size(lanes->locals, loc_rows * row_size);
+}
+
+static void dk_lanes_run(dk_lanes *lanes) {
+    while (lanes->live) {
+        u32 group = dk_lanes_next_group(lanes);
+        dk_lanes_run_group(lanes, group);
+    }
+}
+
+// NOTE(rune): The deepest lane with the lowest ip leads, so callees finish before their callers continue, and lanes
+// behind in a function catch up with lanes ahead of them. Lanes join the group if they are at the same position,
+// with the same stack and frame, so every row of the group is at the same place.
+static u32 dk_lanes_next_group(dk_lanes *lanes) {
+    i64 lead = -1;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if (lanes->live & (1u << lane)) {
+            if (lead == -1 ||
+                lanes->depth[lane] > lanes->depth[lead] ||
+                (lanes->depth[lane] == lanes->depth[lead] && lanes->ip[lane] < lanes->ip[lead])) {
+                lead = lane;
+            }
+        }
+    }
+
+    assert(lead != -1);
+    i64 depth    = lanes->depth[lead];
+    i64 loc_base = lanes->frames[depth * DK_LANES_MAX + lead].loc_base;
+
+    u32 group = 0;
+    for_n (i64, lane, DK_LANES_MAX) {
+        if ((lanes->live & (1u << lane)) &&
+            lanes->depth[lane] == depth &&
+            lanes->ip[lane] == lanes->ip[lead] &&
+            lanes->sp[lane] == lanes->sp[lead] &&
+            lanes->frames[depth * DK_LANES_MAX + lane].loc_base == loc_base) {
+            group |= 1u << lane;
+        }
+    }
+    return group;
+}
+
+static void dk_lanes_fail(dk_lanes *lanes, i64 lane, i64 depth, i64 ip, str msg, bool with_trace) {
+    str_list *output = &lanes->output[lane];
+    str_list_push_fmt(output, lanes->output_arena, "Runtime error: %\n", msg);
+
+    // rune: Stack trace, innermost call first, the same as for a trap in dk_vm_resume().
+    if (with_trace) {
+        dk_bc_symbol *symbols = (dk_bc_symbol *)lanes->program->head.data;
+        i64 symbol_count      = lanes->program->head.size / sizeof(dk_bc_symbol);
+
+        i64 pos = ip;
+        for (i64 it = depth; it >= 0; it--) {
+            dk_bc_symbol *symbol = dk_symbol_from_pos(symbols, symbol_count, pos);
+            if (symbol) {
+                str_list_push_fmt(output, lanes->output_arena, "    in % (line %)\n", symbol->name, symbol->row + 1);
+            }
+            pos = lanes->frames[it * DK_LANES_MAX + lane].return_pos;
+        }
+    }
+
+    lanes->failed[lane] = true;
+    lanes->live &= ~(1u << lane);
+}
+
+#define for_lanes(lane, mask) for_n (i64, lane, DK_LANES_MAX) if ((mask) & (1u << lane))
+
+static void dk_lanes_run_group(dk_lanes *lanes, u32 group) {
+    dk_program *program = lanes->program;
+    dk_buffer *body     = &program->body;
+
+    dk_bc_symbol *symbols = (dk_bc_symbol *)program->head.data;
+    i64 symbol_count      = program->head.size / sizeof(dk_bc_symbol);
+
+    i64 lead = 0;
+    while ((group & (1u << lead)) == 0) {
+        lead++;
+    }
+
+    i64 ip    = lanes->ip[lead];
+    i64 sp    = lanes->sp[lead];
+    i64 depth = lanes->depth[lead];
+    dk_call_frame frame = lanes->frames[depth * DK_LANES_MAX + lead];
+
+    // rune: The group keeps the lead until it reaches the lowest ip of the other lanes at the same depth.
+    i64 stop_ip = I64_MAX;
+    for_lanes (lane, lanes->live & ~group) {
+        if (lanes->depth[lane] == depth) {
+            stop_ip = min(stop_ip, lanes->ip[lane]);
+        }
+    }
+
+    bool split = false;
+    while (!split) {
+        i64 inst_ip = ip;
+        u64 operand = 0;
+        dk_bc_opcode opcode = dk_lanes_read_inst(body, &ip, &operand);
+
+        // NOTE(rune): No instruction pushes more than one row.
+        if (sp + 1 > lanes->data_stack_rows) {
+            lanes->data_stack = dk_lanes_reserve(lanes->data_stack, &lanes->data_stack_rows, sp + 1, DK_LANES_MAX * isizeof(u64));
+        }
+
+        u64 *stack   = lanes->data_stack;
+        u64 *locals  = lanes->locals + frame.loc_base * DK_LANES_MAX;
+        u64 *globals = lanes->globals;
+
+        // NOTE(rune): When every live lane is in the group, the other columns are unused, and rows are copied whole.
+        bool whole = group == lanes->live;
+
+#define DK_LANES_ROW(base, i) ((base) + (i) * DK_LANES_MAX)
+#define DK_LANES_COPY_ROW(dst, src)                                             \
+        do {                                                                    \
+            if (whole) memcpy((dst), (src), DK_LANES_MAX * sizeof(u64));        \
+            else for_lanes (lane, group) (dst)[lane] = (src)[lane];             \
+        } while (0)
+
+        switch (opcode) {
+            case DK_BC_OPCODE_NOP: { } break;
+
+            case DK_BC_OPCODE_LDI: {
+                u64 *dst = DK_LANES_ROW(stack, sp);
+                for_lanes (lane, group) dst[lane] = operand;
+                sp++;
+            } break;
+
+            case DK_BC_OPCODE_LDL: {
+                DK_LANES_COPY_ROW(DK_LANES_ROW(stack, sp), DK_LANES_ROW(locals, operand));
+                sp++;
+            } break;
+
+            case DK_BC_OPCODE_STL: {
+                DK_LANES_COPY_ROW(DK_LANES_ROW(locals, operand), DK_LANES_ROW(stack, sp - 1));
+                sp--;
+            } break;
+
+            case DK_BC_OPCODE_POP: {
+                sp--;
+            } break;
+
+            case DK_BC_OPCODE_DUP: {
+                DK_LANES_COPY_ROW(DK_LANES_ROW(stack, sp), DK_LANES_ROW(stack, sp - 1));
+                sp++;
+            } break;
+
+            case DK_BC_OPCODE_LDG: {
+                DK_LANES_COPY_ROW(DK_LANES_ROW(stack, sp), DK_LANES_ROW(globals, operand));
+                sp++;
+            } break;
+
+            case DK_BC_OPCODE_STG: {
+                DK_LANES_COPY_ROW(DK_LANES_ROW(globals, operand), DK_LANES_ROW(stack, sp - 1));
+                sp--;
+            } break;
+
+            // rune: Lists live in locals, as a length followed by the elements, so each lane indexes its own column.
+            case DK_BC_OPCODE_LDX:
+            case DK_BC_OPCODE_STX:
+            case DK_BC_OPCODE_LDXU:
+            case DK_BC_OPCODE_STXU: {
+                bool checked = opcode == DK_BC_OPCODE_LDX || opcode == DK_BC_OPCODE_STX;
+                bool store   = opcode == DK_BC_OPCODE_STX || opcode == DK_BC_OPCODE_STXU;
+                u64 *idx_row = DK_LANES_ROW(stack, sp - 1);
+                u64 *val_row = DK_LANES_ROW(stack, sp - 2);
+                i64 frame_rows = lanes->locals_rows - frame.loc_base;
+                for_lanes (lane, group) {
+                    u64 idx = idx_row[lane];
+                    u64 len = DK_LANES_ROW(locals, operand)[lane];
+                    if (checked && idx >= len) {
+                        dk_lanes_fail(lanes, lane, depth, inst_ip, arena_print(lanes->output_arena, "Index % is out of bounds for list of length %.", i64(idx), len), false);
+                        group &= ~(1u << lane);
+                        split = true;
+                    } else if (operand + 1 + idx >= u64(frame_rows)) {
+                        // NOTE(rune): Unchecked indices outside of the frame would read outside of the locals.
+                        dk_lanes_fail(lanes, lane, depth, inst_ip, dk_trap_message(SIGSEGV), true);
+                        group &= ~(1u << lane);
+                        split = true;
+                    } else if (store) {
+                        DK_LANES_ROW(locals, operand + 1 + idx)[lane] = val_row[lane];
+                    } else {
+                        idx_row[lane] = DK_LANES_ROW(locals, operand + 1 + idx)[lane];
+                    }
+                }
+                sp -= store ? 2 : 0;
+            } break;
+
+            // rune: Small locals are packed, so each lane addresses the bytes of its own column.
+            case DK_BC_OPCODE_LDL8:
+            case DK_BC_OPCODE_LDL16:
+            case DK_BC_OPCODE_LDL32: {
+                u64 *dst = DK_LANES_ROW(stack, sp);
+                u64 *src = DK_LANES_ROW(locals, operand / 8);
+                for_lanes (lane, group) {
+                    u8 *at = (u8 *)&src[lane] + operand % 8;
+                    switch (opcode) {
+                        case DK_BC_OPCODE_LDL8:  dst[lane] = *(u8  *)at; break;
+                        case DK_BC_OPCODE_LDL16: dst[lane] = *(u16 *)at; break;
+                        case DK_BC_OPCODE_LDL32: dst[lane] = *(u32 *)at; break;
+                        default: break;
+                    }
+                }
+                sp++;
+            } break;
+
+            case DK_BC_OPCODE_STL8:
+            case DK_BC_OPCODE_STL16:
+            case DK_BC_OPCODE_STL32: {
+                u64 *src = DK_LANES_ROW(stack, sp - 1);
+                u64 *dst = DK_LANES_ROW(locals, operand / 8);
+                for_lanes (lane, group) {
+                    u8 *at = (u8 *)&dst[lane] + operand % 8;
+                    switch (opcode) {
+                        case DK_BC_OPCODE_STL8:  *(u8  *)at = u8(src[lane]);  break;
+                        case DK_BC_OPCODE_STL16: *(u16 *)at = u16(src[lane]); break;
+                        case DK_BC_OPCODE_STL32: *(u32 *)at = u32(src[lane]); break;
+                        default: break;
+                    }
+                }
+                sp--;
+            } break;
+
+#define DK_LANES_UNOP_IMPL(calc)                                \
+            do {                                                \
+                u64 *row = DK_LANES_ROW(stack, sp - 1);         \
+                for_lanes (lane, group) {                       \
+                    u64 a = row[lane];                          \
+                    row[lane] = calc;                           \
+                }                                               \
+            } while (0)
+
+            case DK_BC_OPCODE_SEXT8:  DK_LANES_UNOP_IMPL(u64(i64(i8(a))));  break;
+            case DK_BC_OPCODE_SEXT16: DK_LANES_UNOP_IMPL(u64(i64(i16(a)))); break;
+            case DK_BC_OPCODE_SEXT32: DK_LANES_UNOP_IMPL(u64(i64(i32(a)))); break;
+            case DK_BC_OPCODE_ZEXT8:  DK_LANES_UNOP_IMPL(a & 0xff);         break;
+
+            case DK_BC_OPCODE_IABS:   DK_LANES_UNOP_IMPL(i64(a) < 0 ? 0 - a : a); break;
+            case DK_BC_OPCODE_FSQRT:  DK_LANES_UNOP_IMPL(u64_from_f64(sqrt(f64_from_u64(a)))); break;
+            case DK_BC_OPCODE_FFLOOR: DK_LANES_UNOP_IMPL(u64_from_f64(floor(f64_from_u64(a)))); break;
+            case DK_BC_OPCODE_FABS:   DK_LANES_UNOP_IMPL(u64_from_f64(fabs(f64_from_u64(a)))); break;
+            case DK_BC_OPCODE_NOT:    DK_LANES_UNOP_IMPL(!a); break;
+            case DK_BC_OPCODE_I2F:    DK_LANES_UNOP_IMPL(u64_from_f64(f64(i64(a)))); break;
+            case DK_BC_OPCODE_F2I:    DK_LANES_UNOP_IMPL(u64(i64(f64_from_u64(a)))); break;
+
+#undef DK_LANES_UNOP_IMPL
+
+            case DK_BC_OPCODE_ADD:  case DK_BC_OPCODE_SUB:  case DK_BC_OPCODE_UMUL: case DK_BC_OPCODE_IMUL:
+            case DK_BC_OPCODE_UDIV: case DK_BC_OPCODE_IDIV: case DK_BC_OPCODE_MOD:
+            case DK_BC_OPCODE_ADDC: case DK_BC_OPCODE_SUBC: case DK_BC_OPCODE_IMULC:
+            case DK_BC_OPCODE_IDIVC: case DK_BC_OPCODE_MODC:
+            case DK_BC_OPCODE_BAND: case DK_BC_OPCODE_BOR:  case DK_BC_OPCODE_BXOR:
+            case DK_BC_OPCODE_SHL:  case DK_BC_OPCODE_SHR:
+            case DK_BC_OPCODE_FADD: case DK_BC_OPCODE_FSUB: case DK_BC_OPCODE_FMUL: case DK_BC_OPCODE_FDIV:
+            case DK_BC_OPCODE_IMIN: case DK_BC_OPCODE_IMAX:
+            case DK_BC_OPCODE_FMIN: case DK_BC_OPCODE_FMAX: case DK_BC_OPCODE_FPOW:
+            case DK_BC_OPCODE_AND:  case DK_BC_OPCODE_OR:
+            case DK_BC_OPCODE_EQ:   case DK_BC_OPCODE_LT:   case DK_BC_OPCODE_GT:
+            case DK_BC_OPCODE_FEQ:  case DK_BC_OPCODE_FLT:  case DK_BC_OPCODE_FGT: {
+                u64 *x = DK_LANES_ROW(stack, sp - 2);
+                u64 *y = DK_LANES_ROW(stack, sp - 1);
+                u32 fault = lanes->funcs[opcode](x, y, group);
+                sp--;
+
+                // rune: Faulting lanes stop, with the same error as dk_vm_resume() would give.
+                if (fault) {
+                    bool checked = opcode == DK_BC_OPCODE_ADDC || opcode == DK_BC_OPCODE_SUBC || opcode == DK_BC_OPCODE_IMULC ||
+                                   opcode == DK_BC_OPCODE_IDIVC || opcode == DK_BC_OPCODE_MODC;
+                    for_lanes (lane, fault) {
+                        if (checked) {
+                            bool div_by_zero = (opcode == DK_BC_OPCODE_IDIVC || opcode == DK_BC_OPCODE_MODC) && y[lane] == 0;
+                            str msg = arena_print(lanes->output_arena, "% at line %, column %.",
+                                                      div_by_zero ? "Division by zero" : "Integer overflow",
+                                                      dk_src_operand_row(operand),
+                                                      dk_src_operand_col(operand));
+                            dk_lanes_fail(lanes, lane, depth, inst_ip, msg, false);
+                        } else {
+                            dk_lanes_fail(lanes, lane, depth, inst_ip, dk_trap_message(SIGFPE), true);
+                        }
+                    }
+                    group &= ~fault;
+                    split  = true;
+                }
+            } break;
+
+            case DK_BC_OPCODE_CALL: {
+                // TODO(rune): Better symbol lookup.
+                dk_bc_symbol *symbol = null;
+                for_n (i64, i, symbol_count) {
+                    if (symbols[i].id == u32(operand)) {
+                        symbol = &symbols[i];
+                    }
+                }
+                assert(symbol != null); // NOTE(rune): Built-in procedures are rejected by dk_lanes_supported().
+
+                dk_call_frame callee = { 0 };
+                callee.loc_base   = frame.loc_base + frame.loc_size;
+                callee.loc_size   = (symbol->size + 7) / 8;
+                callee.return_pos = ip;
+                callee.prev_pos   = -1;
+
+                depth++;
+                lanes->frames = dk_lanes_reserve(lanes->frames, &lanes->frame_rows, depth + 1, DK_LANES_MAX * isizeof(dk_call_frame));
+                lanes->locals = dk_lanes_reserve(lanes->locals, &lanes->locals_rows, callee.loc_base + callee.loc_size, DK_LANES_MAX * isizeof(u64));
+
+                // NOTE(rune): Deeper frames of lanes outside of the group may overlap, so only the group's columns are cleared.
+                for_lanes (lane, group) {
+                    lanes->frames[depth * DK_LANES_MAX + lane] = callee;
+                    for_n (i64, i, callee.loc_size) {
+                        lanes->locals[(callee.loc_base + i) * DK_LANES_MAX + lane] = 0;
+                    }
+                }
+
+                frame = callee;
+                ip    = symbol->pos;
+
+                // NOTE(rune): No other lane can be deeper than the group.
+                stop_ip = I64_MAX;
+            } break;
+
+            case DK_BC_OPCODE_RET: {
+                if (depth == 0) {
+                    // rune: Lanes are done, and return values are copied out, since the rows are reused.
+                    for_lanes (lane, group) {
+                        u64 *values = arena_push_array_nozero(lanes->output_arena, u64, max(sp, 1));
+                        for_n (i64, i, sp) {
+                            values[i] = DK_LANES_ROW(stack, i)[lane];
+                        }
+                        lanes->values[lane]      = values;
+                        lanes->value_count[lane] = sp;
+                    }
+                    lanes->live &= ~group;
+                    group = 0;
+                } else {
+                    // NOTE(rune): Lanes can meet in a function which they were called to from different places.
+                    i64 return_pos = frame.return_pos;
+                    bool same      = true;
+                    for_lanes (lane, group) {
+                        same &= lanes->frames[depth * DK_LANES_MAX + lane].return_pos == return_pos;
+                    }
+
+                    if (same) {
+                        depth--;
+                        frame = lanes->frames[depth * DK_LANES_MAX + lead];
+                        ip    = return_pos;
+
+                        // NOTE(rune): Lanes in the caller may be waiting to return from the same call.
+                        split = group != lanes->live;
+                    } else {
+                        for_lanes (lane, group) {
+                            lanes->ip[lane]    = lanes->frames[depth * DK_LANES_MAX + lane].return_pos;
+                            lanes->sp[lane]    = sp;
+                            lanes->depth[lane] = depth - 1;
+                        }
+                        group = 0;
+                    }
+                }
+            } break;
+
+            case DK_BC_OPCODE_BR: {
+                u64 *condition = DK_LANES_ROW(stack, sp - 1);
+                sp--;
+
+                u32 taken = 0;
+                for_lanes (lane, group) {
+                    if (condition[lane]) {
+                        taken |= 1u << lane;
+                    }
+                }
+
+                if (taken == group) {
+                    ip = operand;
+                } else if (taken != 0) {
+                    // rune: Divergent branch, so the group splits.
+                    for_lanes (lane, group) {
+                        lanes->ip[lane]    = (taken & (1u << lane)) ? i64(operand) : ip;
+                        lanes->sp[lane]    = sp;
+                        lanes->depth[lane] = depth;
+                    }
+                    group = 0;
+                }
+            } break;
+
+            case DK_BC_OPCODE_JMP: {
+                ip = operand;
+            } break;
+
+            case DK_BC_OPCODE_SWITCH: {
+                u64 *key = DK_LANES_ROW(stack, sp - 1);
+                sp--;
+
+                dk_bc_switch_header *header = dk_buffer_read_struct(body, &ip, dk_bc_switch_header);
+                dk_bc_switch_entry *entries = dk_buffer_read(body, &ip, operand * sizeof(dk_bc_switch_entry));
+
+                i64 target[DK_LANES_MAX] = { 0 };
+                bool same = true;
+                for_lanes (lane, group) {
+                    target[lane] = dk_bc_switch_target(header, entries, operand, i64(key[lane]));
+                    same &= target[lane] == target[lead];
+                }
+
+                if (same) {
+                    ip = target[lead];
+                } else {
+                    for_lanes (lane, group) {
+                        lanes->ip[lane]    = target[lane];
+                        lanes->sp[lane]    = sp;
+                        lanes->depth[lane] = depth;
+                    }
+                    group = 0;
+                }
+            } break;
+
+            default: {
+                assert(false && "Instruction is not supported in lockstep.");
+            } break;
+        }
+
+#undef DK_LANES_ROW
+#undef DK_LANES_COPY_ROW
+
+        // NOTE(rune): Lanes outside of the group may be waiting at the new position, so the next group is picked again.
+        // Failed lanes also split the group, since the lead lane may be one of them.
+        split = split || group == 0 || ip >= stop_ip;
+    }
+
+    for_lanes (lane, group) {
+        lanes->ip[lane]    = ip;
+        lanes->sp[lane]    = sp;
+        lanes->depth[lane] = depth;
+    }
+}
+
+#undef for_lanes
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////
+// rune: Lockstep interpreter
+
+// NOTE(rune): Runs one function for up to DK_LANES_MAX argument sets at once. Every instruction is decoded once,
+// and then executed for a group of lanes, which share the same position in the program. Stacks, locals and globals
+// are stored as struct-of-arrays rows, where row i holds slot i of every lane, so binary instructions run on whole
+// rows with the kernels below.
+//
+// Each lane keeps its own ip, stack size and call depth. When a branch goes different ways for lanes in the group,
+// the group splits, and the next group is picked among the deepest lanes with the lowest ip. Lanes which took a
+// forward branch wait for the others to catch up, and run together again when they meet at the same position.
+//
+// Programs which use input, output, text, ordbøger, fields or bulk instructions are run one lane at a time on a
+// normal dk_vm instead, with the same results.
+
+#define DK_LANES_MAX 8
+
+// NOTE(rune): Runs x = x op y for the lanes in mask, and returns the lanes which faulted.
+typedef u32 dk_lanes_func(u64 *x, u64 *y, u32 mask);
+
+typedef struct dk_lanes dk_lanes;
+struct dk_lanes {
+    dk_program *program;
+    dk_bc_symbol *entry;
+    i64 lane_count;
+    u32 live;               // NOTE(rune): Lanes which have not returned or failed.
+
+    // rune: Per lane state, written back when a group splits.
+    i64 ip[DK_LANES_MAX];
+    i64 sp[DK_LANES_MAX];   // NOTE(rune): In rows.
+    i64 depth[DK_LANES_MAX];
+    bool failed[DK_LANES_MAX];
+    str_list output[DK_LANES_MAX];
+    u64 *values[DK_LANES_MAX];
+    i64 value_count[DK_LANES_MAX];
+
+    // rune: Struct-of-arrays storage, DK_LANES_MAX u64s per row.
+    u64 *data_stack;
+    u64 *locals;
+    u64 *globals;
+    dk_call_frame *frames;  // NOTE(rune): frames[depth * DK_LANES_MAX + lane]. Sizes and bases are in rows.
+    i64 data_stack_rows;
+    i64 locals_rows;
+    i64 globals_rows;
+    i64 frame_rows;
+
+    dk_lanes_func *funcs[DK_BC_OPCODE_COUNT];
+    dk_vm *fallback_vm;         // NOTE(rune): Runs programs which are not supported, one lane at a time.
+    arena *output_arena;
+};
+
+// rune: Api
+static void            dk_lanes_init(dk_lanes *lanes);
+static void            dk_lanes_destroy(dk_lanes *lanes);
+
+// NOTE(rune): Calls func once per lane. Arguments of lane i start at args[i * arg_count], and the results of
+// lane i are written to results[i], the same as dk_lib_call() would.
+static void            dk_lanes_call(dk_lanes *lanes, dk_lib_program *program, dk_bc_symbol *func, u64 *args, i64 arg_count,
+                                     i64 lane_count, dk_lib_result *results, arena *output_arena);
+
+// NOTE(rune): Whether every instruction of the program can run in lockstep.
+static bool            dk_lanes_supported(dk_program *program);
+
+// rune: Interpreter
+static void            dk_lanes_start(dk_lanes *lanes, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count, i64 lane_count);
+static void            dk_lanes_run(dk_lanes *lanes);
+static u32             dk_lanes_next_group(dk_lanes *lanes);
+static void            dk_lanes_run_group(dk_lanes *lanes, u32 group);
+static void            dk_lanes_fail(dk_lanes *lanes, i64 lane, i64 depth, i64 ip, str msg, bool with_trace);
+static void *          dk_lanes_reserve(void *rows, i64 *row_count, i64 needed, i64 row_size);
+static dk_bc_opcode    dk_lanes_read_inst(dk_buffer *body, i64 *ip, u64 *operand);
+
+// rune: Kernels
+static dk_lanes_func * dk_lanes_get_func(dk_bc_opcode opcode);
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////
+// rune: Hash map
+
+#define DK_MAP_MIN_CAP 16
+
+static dk_map *dk_map_create(dk_map_list *list) {
+    dk_map *map = heap_alloc(sizeof(dk_map));
+    mem_zero_struct(map);
+    dlist_push(list, map);
+    return map;
+}
+
+static void dk_map_destroy(dk_map_list *list, dk_map *map) {
+    dlist_remove(list, map);
+    heap_free(map->keys);
+    heap_free(map->vals);
+    heap_free(map);
+}
+
+static void dk_map_destroy_all(dk_map_list *list) {
+    while (list->first) {
+        dk_map_destroy(list, list->first);
+    }
+}
+
+// NOTE(rune): Returns the slot of the key, or the empty slot where it would be inserted.
+static u64 dk_map_lookup(dk_map *map, u64 key) {
+    u64 mask = map->cap - 1;
+    u64 idx  = map_hash(key) & mask;
+    while (map->keys[idx] != 0 && map->keys[idx] != key) {
+        idx = (idx + 1) & mask;
+    }
+    return idx;
+}
+
+static void dk_map_grow(dk_map *map) {
+    u64 *old_keys = map->keys;
+    u64 *old_vals = map->vals;
+    u64  old_cap  = map->cap;
+
+    map->cap  = max(old_cap * 2, DK_MAP_MIN_CAP);
+    map->keys = heap_alloc(map->cap * sizeof(u64));
+    map->vals = heap_alloc(map->cap * sizeof(u64));
+    mem_zero_size(map->keys, map->cap * sizeof(u64));
+
+    for_n (u64, i, old_cap) {
+        if (old_keys[i] != 0) {
+            u64 idx = dk_map_lookup(map, old_keys[i]);
+            map->keys[idx] = old_keys[i];
+            map->vals[idx] = old_vals[i];
+        }
+    }
+
+    heap_free(old_keys);
+    heap_free(old_vals);
+}
+
+static bool dk_map_get(dk_map *map, u64 key, u64 *val) {
+    bool ret = false;
+    if (key == 0) {
+        ret  = map->has_zero;
+        *val = map->zero_val;
+    } else if (map->cap > 0) {
+        u64 idx = dk_map_lookup(map, key);
+        if (map->keys[idx] != 0) {
+            *val = map->vals[idx];
+            ret  = true;
+        }
+    }
+    return ret;
+}
+
+static void dk_map_put(dk_map *map, u64 key, u64 val) {
+    if (key == 0) {
+        map->has_zero = true;
+        map->zero_val = val;
+        return;
+    }
+
+    // NOTE(rune): Keep load factor below 3/4.
+    if ((map->count + 1) * 4 > map->cap * 3) {
+        dk_map_grow(map);
+    }
+
+    u64 idx = dk_map_lookup(map, key);
+    if (map->keys[idx] == 0) {
+        map->keys[idx] = key;
+        map->count++;
+    }
+    map->vals[idx] = val;
+}
+
+static bool dk_map_remove(dk_map *map, u64 key) {
+    if (key == 0) {
+        bool ret = map->has_zero;
+        map->has_zero = false;
+        return ret;
+    }
+
+    if (map->cap == 0) {
+        return false;
+    }
+
+    u64 idx = dk_map_lookup(map, key);
+    if (map->keys[idx] == 0) {
+        return false;
+    }
+
+    // rune: Backward shift deletion. Move later entries of the probe chain into the hole, unless they would
+    // then be placed before their home slot.
+    u64 mask = map->cap - 1;
+    u64 hole = idx;
+    u64 next = (hole + 1) & mask;
+    while (map->keys[next] != 0) {
+        u64 home = map_hash(map->keys[next]) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            map->keys[hole] = map->keys[next];
+            map->vals[hole] = map->vals[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    map->keys[hole] = 0;
+    map->count--;
+    return true;
+}
+
+static u64 dk_map_count(dk_map *map) {
+    return map->count + (map->has_zero ? 1 : 0);
+}
@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////
+// rune: Hash map
+
+// NOTE(rune): Open-addressing hash map from u64 to u64, backing the ordbog type. Derived from base/base_map.c,
+// with these differences:
+//  - Capacity is a power of two, so the probe index is masked instead of divided.
+//  - Removal shifts the following entries of the probe chain back, so there are no tombstones, and lookups
+//    stay short after many removals.
+//  - Key 0 is allowed. It still marks empty slots in the table, so its value is stored out of line.
+//  - Maps are linked into a list, so the interpreter can free every map that is still alive when a program exits.
+
+typedef struct dk_map dk_map;
+struct dk_map {
+    u64 *keys;
+    u64 *vals;
+    u64 count;  // NOTE(rune): Not including key 0.
+    u64 cap;
+    bool has_zero;
+    u64 zero_val;
+
+    dk_map *prev;
+    dk_map *next;
+};
+
+typedef struct dk_map_list dk_map_list;
+struct dk_map_list {
+    dk_map *first;
+    dk_map *last;
+};
+
+static dk_map * dk_map_create(dk_map_list *list);
+static void     dk_map_destroy(dk_map_list *list, dk_map *map);
+static void     dk_map_destroy_all(dk_map_list *list);
+
+static bool     dk_map_get(dk_map *map, u64 key, u64 *val);
+static void     dk_map_put(dk_map *map, u64 key, u64 val);
+static bool     dk_map_remove(dk_map *map, u64 key);
+static u64      dk_map_count(dk_map *map);
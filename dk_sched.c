@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////
+// rune: Scheduler
+
+static void dk_sched_init(dk_sched *sched, i64 slice_fuel) {
+    mem_zero_struct(sched);
+    sched->slice_fuel = slice_fuel > 0 ? slice_fuel : DK_SCHED_DEFAULT_SLICE_FUEL;
+    sched->mutex      = os_mutex_create();
+    sched->cond       = os_cond_create();
+}
+
+static void dk_sched_destroy(dk_sched *sched) {
+    dk_sched_instance *instance = sched->spawned;
+    while (instance) {
+        dk_sched_instance *next = instance->next_spawned;
+        dk_vm_destroy(&instance->vm);
+        arena_destroy(instance->arena);
+        heap_free(instance);
+        instance = next;
+    }
+
+    os_cond_destroy(sched->cond);
+    os_mutex_destroy(sched->mutex);
+    mem_zero_struct(sched);
+}
+
+static dk_sched_instance *dk_sched_spawn(dk_sched *sched, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count, dk_input input) {
+    dk_sched_instance *instance = heap_alloc(sizeof(dk_sched_instance));
+    mem_zero_struct(instance);
+    instance->input = input;
+    instance->arena = arena_create(kilobytes(4), ARENA_KIND_EXPONENTIAL);
+    dk_vm_start(&instance->vm, program, entry, args, arg_count);
+
+    os_mutex_scope(sched->mutex) {
+        instance->next_spawned = sched->spawned;
+        sched->spawned         = instance;
+        sched->unfinished     += 1;
+        slist_push(sched, instance);
+        os_cond_signal(sched->cond);
+    }
+
+    return instance;
+}
+
+static void dk_sched_run(dk_sched *sched, job_system *jobs) {
+    if (jobs) {
+        // NOTE(rune): One worker per thread, counting the calling thread, which helps while waiting.
+        job_group group = { 0 };
+        for_n (i64, i, jobs->worker_count + 1) {
+            job_push(jobs, &group, dk_sched_worker_proc, sched);
+        }
+        job_wait(jobs, &group);
+    } else {
+        dk_sched_worker_proc(sched);
+    }
+}
+
+static void dk_sched_worker_proc(void *param) {
+    dk_sched *sched = param;
+    while (1) {
+        dk_sched_instance *instance = null;
+        os_mutex_scope(sched->mutex) {
+            // NOTE(rune): The queue can be empty while other workers are running slices, which may go back in the queue.
+            while (sched->first == null && sched->unfinished > 0) {
+                os_cond_wait(sched->cond, sched->mutex, U32_MAX);
+            }
+
+            instance = sched->first;
+            if (instance) {
+                slist_pop_front(sched);
+                instance->next = null;
+            }
+        }
+
+        // NOTE(rune): Only an empty queue with no unfinished instances gets here.
+        if (instance == null) {
+            break;
+        }
+
+        dk_sched_run_slice(sched, instance);
+
+        if (instance->vm.status == DK_VM_STATUS_RUNNING) {
+            os_mutex_scope(sched->mutex) {
+                slist_push(sched, instance);
+                os_cond_signal(sched->cond);
+            }
+        } else {
+            instance->output = str_list_concat(&instance->output_list, instance->arena);
+            os_mutex_scope(sched->mutex) {
+                sched->unfinished -= 1;
+                if (sched->unfinished == 0) {
+                    os_cond_signal_all(sched->cond);
+                }
+            }
+        }
+    }
+}
+
+static void dk_sched_run_slice(dk_sched *sched, dk_sched_instance *instance) {
+    i64 fuel = sched->slice_fuel;
+    if (instance->fuel_quota > 0) {
+        fuel = min(fuel, instance->fuel_quota - instance->fuel_used);
+    }
+
+    dk_vm_resume(&instance->vm, fuel, &instance->input, &instance->output_list, instance->arena);
+    instance->fuel_used += fuel - instance->vm.fuel_left;
+    instance->slice_count++;
+
+    if (instance->vm.status == DK_VM_STATUS_RUNNING) {
+        if (instance->fuel_quota > 0 && instance->fuel_used >= instance->fuel_quota) {
+            dk_sched_kill(instance, arena_print(instance->arena, "Fuel quota of % exceeded.", instance->fuel_quota));
+        } else if (instance->memory_quota > 0 && dk_sched_memory_used(instance) > instance->memory_quota) {
+            dk_sched_kill(instance, arena_print(instance->arena, "Memory quota of % bytes exceeded.", instance->memory_quota));
+        }
+    }
+}
+
+static void dk_sched_kill(dk_sched_instance *instance, str reason) {
+    str_list_push_fmt(&instance->output_list, instance->arena, "Runtime error: %\n", reason);
+
+    // NOTE(rune): The program never gets to return, so its ordbøger are freed here instead.
+    dk_map_destroy_all(&instance->vm.maps);
+    instance->vm.status = DK_VM_STATUS_ERROR;
+}
+
+static i64 dk_sched_memory_used(dk_sched_instance *instance) {
+    i64 ret = 0;
+    ret += instance->vm.data_stack.capacity;
+    ret += instance->vm.call_stack.capacity;
+    ret += instance->vm.globals.capacity;
+
+    for (dk_map *map = instance->vm.maps.first; map; map = map->next) {
+        ret += map->cap * 2 * sizeof(u64);
+    }
+
+    for (arena *block = instance->arena; block; block = block->next) {
+        ret += block->cap;
+    }
+
+    return ret;
+}
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////
+// rune: Scheduler
+
+// NOTE(rune): Runs many programs on a few threads. Each instance is a dk_vm, which is resumed for one slice of fuel
+// at a time. An instance which runs out of fuel goes to the back of the run queue, so instances are time-sliced
+// round-robin, and a program which never finishes only gets its share of the threads. Quotas are checked between
+// slices, so an instance can go over its memory quota by at most what it allocates in one slice.
+
+#define DK_SCHED_DEFAULT_SLICE_FUEL 10000
+
+typedef struct dk_sched_instance dk_sched_instance;
+struct dk_sched_instance {
+    dk_vm vm;
+    dk_input input;
+    arena *arena;           // NOTE(rune): Output of the instance.
+    str_list output_list;
+    str output;             // NOTE(rune): Set when the instance has finished.
+
+    i64 fuel_quota;         // NOTE(rune): Total fuel of the instance, or zero for no quota.
+    i64 memory_quota;       // NOTE(rune): Bytes of stacks, globals, ordbøger and output, or zero for no quota.
+    i64 fuel_used;
+    i64 slice_count;
+
+    dk_sched_instance *next;        // NOTE(rune): Next in the run queue.
+    dk_sched_instance *next_spawned;
+};
+
+typedef struct dk_sched dk_sched;
+struct dk_sched {
+    i64 slice_fuel;
+    os_handle mutex;
+    os_handle cond;         // NOTE(rune): Signalled when an instance is queued, or when the last one finishes.
+    i64 unfinished;         // NOTE(rune): Protected by mutex.
+
+    // rune: Run queue
+    dk_sched_instance *first;
+    dk_sched_instance *last;
+
+    // rune: All instances, for cleanup.
+    dk_sched_instance *spawned;
+};
+
+static void               dk_sched_init(dk_sched *sched, i64 slice_fuel); // NOTE(rune): Zero means the default slice.
+static void               dk_sched_destroy(dk_sched *sched);
+static dk_sched_instance *dk_sched_spawn(dk_sched *sched, dk_program *program, dk_bc_symbol *entry, u64 *args, i64 arg_count, dk_input input);
+
+// NOTE(rune): Runs until all instances have finished. Uses every worker of the job system, or only the calling
+// thread if jobs is null.
+static void               dk_sched_run(dk_sched *sched, job_system *jobs);
+
+static void               dk_sched_worker_proc(void *param);
+static void               dk_sched_run_slice(dk_sched *sched, dk_sched_instance *instance);
+static void               dk_sched_kill(dk_sched_instance *instance, str reason);
+static i64                dk_sched_memory_used(dk_sched_instance *instance);
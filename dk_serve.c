@@ -0,0 +1,362 @@
+////////////////////////////////////////////////////////////////
+// rune: Job server
+
+#if !_WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+// NOTE(rune): FNV-1a.
+static u64 dk_serve_hash(str s) {
+    u64 h = 0xcbf29ce484222325;
+    for_n (i64, i, s.len) {
+        h ^= s.v[i];
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+// NOTE(rune): Must be called with the mutex held. The entry is destroyed by dk_serve_release() if still in use.
+static void dk_serve_evict(dk_serve_server *server, dk_serve_entry *entry) {
+    dk_serve_entry **at = &server->buckets[entry->hash % DK_SERVE_CACHE_BUCKETS];
+    while (*at != entry) {
+        at = &(*at)->next;
+    }
+    *at = entry->next;
+
+    DLIST_REMOVE(server->lru_first, server->lru_last, lru_next, lru_prev, entry);
+    entry->lru_next = null;
+    entry->lru_prev = null;
+    entry->cached   = false;
+    server->cache_count -= 1;
+
+    if (entry->ref_count == 0) {
+        dk_lib_program_destroy(entry->program);
+        heap_free(entry);
+    }
+}
+
+// NOTE(rune): The entry is kept alive until dk_serve_release(), even if it is evicted by another request meanwhile.
+static dk_serve_entry *dk_serve_acquire(dk_serve_server *server, str src, dk_build_flags flags, bool *cached) {
+    u64 hash = dk_serve_hash(src);
+    dk_serve_entry **bucket = &server->buckets[hash % DK_SERVE_CACHE_BUCKETS];
+
+    // rune: Look up
+    dk_serve_entry *ret = null;
+    os_mutex_scope(server->mutex) {
+        for (dk_serve_entry *entry = *bucket; entry; entry = entry->next) {
+            if (entry->hash == hash && entry->flags == flags && str_eq(entry->program->src, src)) {
+                ret = entry;
+                ret->ref_count += 1;
+
+                // NOTE(rune): Move to the back of the LRU list.
+                DLIST_REMOVE(server->lru_first, server->lru_last, lru_next, lru_prev, ret);
+                ret->lru_next = null;
+                ret->lru_prev = null;
+                DLIST_PUSH_BACK(server->lru_first, server->lru_last, lru_next, lru_prev, ret);
+                break;
+            }
+        }
+    }
+
+    *cached = ret != null;
+
+    // rune: Compile outside of the lock, so other requests can run meanwhile. If two requests compile the same
+    // program at once, both are kept, and the first one is found by later requests.
+    if (ret == null) {
+        ret = heap_alloc(sizeof(dk_serve_entry));
+        mem_zero_struct(ret);
+        ret->hash      = hash;
+        ret->flags     = flags;
+        ret->program   = dk_lib_compile(src, flags, null);
+        ret->ref_count = 1;
+
+        // NOTE(rune): Programs which failed to compile are not cached, since any number of different sources can
+        // fail, and the error is found quickly anyway.
+        if (ret->program->err.len == 0) {
+            os_mutex_scope(server->mutex) {
+                ret->cached = true;
+                ret->next   = *bucket;
+                *bucket     = ret;
+                DLIST_PUSH_BACK(server->lru_first, server->lru_last, lru_next, lru_prev, ret);
+                server->cache_count += 1;
+
+                while (server->cache_count > server->cache_capacity) {
+                    dk_serve_evict(server, server->lru_first);
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+static void dk_serve_release(dk_serve_server *server, dk_serve_entry *entry) {
+    bool destroy = false;
+    os_mutex_scope(server->mutex) {
+        entry->ref_count -= 1;
+        destroy = entry->ref_count == 0 && !entry->cached;
+    }
+
+    if (destroy) {
+        dk_lib_program_destroy(entry->program);
+        heap_free(entry);
+    }
+}
+
+#if !_WIN32
+
+static bool dk_serve_read_all(int fd, void *dst, i64 size) {
+    u8 *at = dst;
+    while (size > 0) {
+        ssize_t got = recv(fd, at, size, 0);
+        if (got <= 0) {
+            return false;
+        }
+        at   += got;
+        size -= got;
+    }
+    return true;
+}
+
+// NOTE(rune): MSG_NOSIGNAL, so a client which hangs up early doesn't take down the server with SIGPIPE.
+static bool dk_serve_write_all(int fd, void *src, i64 size) {
+    u8 *at = src;
+    while (size > 0) {
+        ssize_t sent = send(fd, at, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        at   += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+static bool dk_serve_start(dk_serve_server *server, str socket_path, job_system *jobs) {
+    mem_zero_struct(server);
+    server->jobs           = jobs;
+    server->socket_path    = socket_path;
+    server->listen_fd      = -1;
+    server->cache_capacity = DK_SERVE_CACHE_CAPACITY;
+
+    struct sockaddr_un addr = { 0 };
+    addr.sun_family = AF_UNIX;
+    if (socket_path.len + 1 > sizeof(addr.sun_path)) {
+        return false;
+    }
+    memcpy(addr.sun_path, socket_path.v, socket_path.len);
+
+    // NOTE(rune): A socket file left behind by a previous server would make bind() fail.
+    unlink(addr.sun_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return false;
+    }
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+        close(fd);
+        return false;
+    }
+
+    server->listen_fd = fd;
+    server->mutex     = os_mutex_create();
+    return true;
+}
+
+static void dk_serve_run(dk_serve_server *server) {
+    while (!atomic_load_i64(&server->stop)) {
+        int fd = accept(server->listen_fd, null, null);
+        if (fd == -1) {
+            continue;
+        }
+
+        // NOTE(rune): A client which never sends its request would otherwise hold on to a worker forever.
+        struct timeval timeout = { 0 };
+        timeout.tv_sec = DK_SERVE_READ_TIMEOUT_SECONDS;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        dk_serve_conn *conn = heap_alloc(sizeof(dk_serve_conn));
+        conn->server = server;
+        conn->fd     = fd;
+        job_push(server->jobs, &server->group, dk_serve_conn_proc, conn);
+    }
+
+    job_wait(server->jobs, &server->group);
+}
+
+static void dk_serve_destroy(dk_serve_server *server) {
+    if (server->listen_fd != -1) {
+        close(server->listen_fd);
+        unlink((char *)server->socket_path.v);
+        os_mutex_destroy(server->mutex);
+    }
+
+    // NOTE(rune): Every cached entry is on the LRU list, and none are in use once dk_serve_run() has returned.
+    dk_serve_entry *entry = server->lru_first;
+    while (entry) {
+        dk_serve_entry *next = entry->lru_next;
+        dk_lib_program_destroy(entry->program);
+        heap_free(entry);
+        entry = next;
+    }
+
+    dk_serve_slot *slot = server->free_slots;
+    while (slot) {
+        dk_serve_slot *next = slot->next;
+        dk_lib_vm_destroy(slot->vm);
+        arena_destroy(slot->arena);
+        heap_free(slot);
+        slot = next;
+    }
+
+    mem_zero_struct(server);
+}
+
+static void dk_serve_conn_proc(void *param) {
+    dk_serve_conn conn = *(dk_serve_conn *)param;
+    dk_serve_server *server = conn.server;
+    heap_free(param);
+
+    // rune: Take a slot from the pool, or make a new one.
+    dk_serve_slot *slot = null;
+    os_mutex_scope(server->mutex) {
+        slot = server->free_slots;
+        if (slot) {
+            server->free_slots = slot->next;
+        }
+    }
+
+    if (slot == null) {
+        slot = heap_alloc(sizeof(dk_serve_slot));
+        slot->vm       = dk_lib_vm_create();
+        slot->vm->jobs = server->jobs;
+        slot->arena    = arena_create_default();
+    }
+
+    arena_reset(slot->arena);
+
+    // rune: Read request.
+    dk_serve_request_header request = { 0 };
+    dk_serve_response_header response = { 0 };
+    str output = { 0 };
+    dk_serve_entry *entry = null;
+
+    bool ok = dk_serve_read_all(conn.fd, &request, sizeof(request));
+    if (ok && request.kind == DK_SERVE_REQUEST_KIND_STOP) {
+        // NOTE(rune): Wakes up the accept() in dk_serve_run().
+        atomic_store_i64(&server->stop, 1);
+        shutdown(server->listen_fd, SHUT_RDWR);
+    } else if (ok && request.kind == DK_SERVE_REQUEST_KIND_RUN &&
+               request.src_len <= DK_SERVE_MAX_REQUEST_SIZE &&
+               request.input_len <= DK_SERVE_MAX_REQUEST_SIZE - request.src_len) { // NOTE(rune): Lengths come from the client, so the sum may overflow.
+        str src   = arena_push_str(slot->arena, i64(request.src_len), 0);
+        str input = arena_push_str(slot->arena, i64(request.input_len), 0);
+        ok = dk_serve_read_all(conn.fd, src.v, src.len) && dk_serve_read_all(conn.fd, input.v, input.len);
+
+        // rune: Run
+        if (ok) {
+            atomic_add_i64(&server->request_count, 1);
+
+            bool cached = false;
+            entry                   = dk_serve_acquire(server, src, request.flags & DK_BUILD_FLAG_UNCHECKED, &cached);
+            dk_lib_program *program = entry->program;
+            if (cached) {
+                atomic_add_i64(&server->cache_hit_count, 1);
+            }
+
+            response.cached = cached;
+            if (program->err.len > 0) {
+                response.status = DK_SERVE_STATUS_COMPILE_ERROR;
+                output          = program->err;
+            } else {
+                dk_input run_input   = dk_input_from_str(input);
+                dk_lib_result result = dk_lib_call(slot->vm, program, dk_lib_entry_func(program), null, 0, &run_input, slot->arena);
+                response.status      = result.ok ? DK_SERVE_STATUS_OK : DK_SERVE_STATUS_RUNTIME_ERROR;
+                output               = result.output;
+            }
+        }
+    } else if (ok) {
+        response.status = DK_SERVE_STATUS_BAD_REQUEST;
+    }
+
+    // rune: Respond
+    if (ok) {
+        response.output_len = output.len;
+        dk_serve_write_all(conn.fd, &response, sizeof(response));
+        dk_serve_write_all(conn.fd, output.v, output.len);
+    }
+    close(conn.fd);
+
+    // NOTE(rune): Only after responding, since a compilation error points into the program.
+    if (entry) {
+        dk_serve_release(server, entry);
+    }
+
+    os_mutex_scope(server->mutex) {
+        slot->next         = server->free_slots;
+        server->free_slots = slot;
+    }
+}
+
+static bool dk_serve_request(str socket_path, dk_serve_request_kind kind, dk_build_flags flags, str src, str input,
+                             dk_serve_response_header *response, str *output, arena *arena) {
+    struct sockaddr_un addr = { 0 };
+    addr.sun_family = AF_UNIX;
+    if (socket_path.len + 1 > sizeof(addr.sun_path)) {
+        return false;
+    }
+    memcpy(addr.sun_path, socket_path.v, socket_path.len);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return false;
+    }
+
+    bool ok = connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+
+    // rune: Send request.
+    if (ok) {
+        dk_serve_request_header request = { 0 };
+        request.kind      = kind;
+        request.flags     = flags;
+        request.src_len   = src.len;
+        request.input_len = input.len;
+        ok = dk_serve_write_all(fd, &request, sizeof(request)) &&
+             dk_serve_write_all(fd, src.v, src.len) &&
+             dk_serve_write_all(fd, input.v, input.len);
+    }
+
+    // rune: Read response.
+    mem_zero_struct(response);
+    *output = str("");
+    if (ok && kind != DK_SERVE_REQUEST_KIND_STOP) {
+        ok = dk_serve_read_all(fd, response, sizeof(*response));
+        if (ok) {
+            *output = arena_push_str(arena, i64(response->output_len), 0);
+            ok = dk_serve_read_all(fd, output->v, output->len);
+        }
+    }
+
+    close(fd);
+    return ok;
+}
+
+#else
+
+// TODO(rune): Windows has AF_UNIX sockets in winsock since Windows 10, but the server is only used on Linux for now.
+static bool dk_serve_read_all(int fd, void *dst, i64 size)   { unused(fd, dst, size); return false; }
+static bool dk_serve_write_all(int fd, void *src, i64 size)  { unused(fd, src, size); return false; }
+static bool dk_serve_start(dk_serve_server *server, str socket_path, job_system *jobs) { unused(server, socket_path, jobs); return false; }
+static void dk_serve_run(dk_serve_server *server)            { unused(server); }
+static void dk_serve_destroy(dk_serve_server *server)        { unused(server); }
+static void dk_serve_conn_proc(void *param)                  { unused(param); }
+
+static bool dk_serve_request(str socket_path, dk_serve_request_kind kind, dk_build_flags flags, str src, str input,
+                             dk_serve_response_header *response, str *output, arena *arena) {
+    unused(socket_path, kind, flags, src, input, response, output, arena);
+    return false;
+}
+
+#endif
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////
+// rune: Job server
+
+// NOTE(rune): dansk serve keeps compiled programs in an LRU cache, keyed by a hash of their source, and runs requests
+// from a unix domain socket on the job system. Each connection carries one request, which is read, looked up in
+// the cache or compiled, run and answered on a worker thread. Vms and output arenas are kept in a pool between
+// requests, so a request for a cached program only pays for its execution.
+//
+//     Request:  dk_serve_request_header, followed by src_len bytes of source and input_len bytes of input.
+//     Response: dk_serve_response_header, followed by output_len bytes of output, or the compilation error.
+
+#define DK_SERVE_DEFAULT_SOCKET         "/tmp/dansk.sock"
+#define DK_SERVE_CACHE_BUCKETS          1024
+#define DK_SERVE_CACHE_CAPACITY         256
+#define DK_SERVE_MAX_REQUEST_SIZE       megabytes(64)
+#define DK_SERVE_READ_TIMEOUT_SECONDS   10
+
+typedef enum dk_serve_request_kind {
+    DK_SERVE_REQUEST_KIND_NONE,
+    DK_SERVE_REQUEST_KIND_RUN,
+    DK_SERVE_REQUEST_KIND_STOP,
+} dk_serve_request_kind;
+
+typedef enum dk_serve_status {
+    DK_SERVE_STATUS_OK,
+    DK_SERVE_STATUS_COMPILE_ERROR,
+    DK_SERVE_STATUS_RUNTIME_ERROR,
+    DK_SERVE_STATUS_BAD_REQUEST,
+} dk_serve_status;
+
+typedef struct dk_serve_request_header dk_serve_request_header;
+struct dk_serve_request_header {
+    u32 kind;
+    u32 flags;      // NOTE(rune): dk_build_flags.
+    u64 src_len;
+    u64 input_len;
+};
+
+typedef struct dk_serve_response_header dk_serve_response_header;
+struct dk_serve_response_header {
+    u32 status;
+    u32 cached;     // NOTE(rune): Whether the program was already compiled.
+    u64 output_len;
+};
+
+typedef struct dk_serve_entry dk_serve_entry;
+struct dk_serve_entry {
+    u64 hash;
+    dk_build_flags flags;
+    dk_lib_program *program;
+    i64 ref_count;      // NOTE(rune): Requests running the program, which must not be destroyed meanwhile.
+    bool cached;        // NOTE(rune): Whether the entry is still in the cache, or was evicted or never added.
+    dk_serve_entry *next;
+    dk_serve_entry *lru_next;
+    dk_serve_entry *lru_prev;
+};
+
+// NOTE(rune): Everything a request needs to run, which is reused by the next request.
+typedef struct dk_serve_slot dk_serve_slot;
+struct dk_serve_slot {
+    dk_vm *vm;
+    arena *arena;
+    dk_serve_slot *next;
+};
+
+typedef struct dk_serve_server dk_serve_server;
+struct dk_serve_server {
+    int listen_fd;
+    str socket_path;
+    job_system *jobs;
+    job_group group;
+    volatile i64 stop;
+
+    os_handle mutex;
+    dk_serve_entry *buckets[DK_SERVE_CACHE_BUCKETS];
+    dk_serve_entry *lru_first;  // NOTE(rune): Least recently used, and the first to be evicted.
+    dk_serve_entry *lru_last;
+    i64 cache_count;
+    i64 cache_capacity;
+    dk_serve_slot *free_slots;
+
+    volatile i64 request_count;
+    volatile i64 cache_hit_count;
+};
+
+typedef struct dk_serve_conn dk_serve_conn;
+struct dk_serve_conn {
+    dk_serve_server *server;
+    int fd;
+};
+
+// rune: Server
+static bool            dk_serve_start(dk_serve_server *server, str socket_path, job_system *jobs);
+static void            dk_serve_run(dk_serve_server *server);
+static void            dk_serve_destroy(dk_serve_server *server);
+static void            dk_serve_conn_proc(void *param);
+static dk_serve_entry  *dk_serve_acquire(dk_serve_server *server, str src, dk_build_flags flags, bool *cached);
+static void            dk_serve_release(dk_serve_server *server, dk_serve_entry *entry);
+static void            dk_serve_evict(dk_serve_server *server, dk_serve_entry *entry);
+static u64             dk_serve_hash(str s);
+
+// rune: Client
+static bool            dk_serve_request(str socket_path, dk_serve_request_kind kind, dk_build_flags flags, str src, str input,
+                                        dk_serve_response_header *response, str *output, arena *arena);
+
+// rune: Socket helpers
+static bool            dk_serve_read_all(int fd, void *dst, i64 size);
+static bool            dk_serve_write_all(int fd, void *src, i64 size);
@@ -36,13 +36,15 @@ static dk_tests dk_tests_from_file(str file_path, arena *arena) {
             str part1 = str_trim(section_parts.first->v);
             str part2 = str_trim(section_parts.first->next->v);
             str part3 = str_trim(section_parts.first->next->next->v);
+            str part4 = section_parts.count >= 4 ? str_trim(section_parts.first->next->next->next->v) : str("");
 
             // rune: Add to list of tests
             dk_test *t   = arena_push_struct(arena, dk_test);
-            t->file_path = file_path;
-            t->name      = part1;
-            t->input     = part2;
-            t->output    = part3;
+            t->file_path  = file_path;
+            t->name       = part1;
+            t->input      = part2;
+            t->output     = part3;
+            t->input_data = part4;
 
             slist_push(&tests, t);
             tests.count += 1;
@@ -62,7 +64,42 @@ static dk_tests dk_tests_from_file(str file_path, arena *arena) {
 ////////////////////////////////////////////////////////////////
 // rune: Runner
 
-static void dk_run_test_file(str file_path, str filter) {
+// NOTE(rune): Builds and runs the program of a test, and returns its output, or the first compilation error.
+// Only uses the given arena, so tests can run on any thread.
+static str dk_run_test_program(dk_test *test, job_system *jobs, arena *arena) {
+    str actual_output = { 0 };
+    dk_err_sink err_sink = { 0 };
+    dk_ctx ctx = { &err_sink, arena, jobs };
+    dk_program program = dk_program_from_str(test->input, 0, &ctx);
+
+    if (err_sink.err_list.count > 0) {
+        actual_output = err_sink.err_list.first->msg;
+    } else {
+        dk_input input = dk_input_from_str(test->input_data);
+        actual_output = dk_run_program(program, &input, jobs, arena);
+    }
+
+    return actual_output;
+}
+
+static void dk_test_job_proc(void *param) {
+    dk_test_job *job = param;
+    arena *arena = arena_create_default();
+
+    u64 timestamp_begin = os_get_performance_timestamp();
+    str actual_output   = dk_run_test_program(job->test, job->jobs, arena);
+    job->duration       = os_get_millis_between(timestamp_begin, os_get_performance_timestamp());
+
+    // rune: Output outlives the job's arena, since tests are reported after all jobs are done.
+    job->actual_output.v   = heap_alloc(actual_output.len + 1);
+    job->actual_output.len = actual_output.len;
+    memcpy(job->actual_output.v, actual_output.v, actual_output.len);
+    job->actual_output.v[actual_output.len] = '\0';
+
+    arena_destroy(arena);
+}
+
+static void dk_run_test_file(str file_path, str filter, job_system *jobs) {
     // rune: Setup test context
     test_ctx ctx = { 0 };
     ctx.name = file_path;
@@ -70,19 +107,44 @@ static void dk_run_test_file(str file_path, str filter) {
         // rune: Parse test file.
         dk_tests tests = dk_tests_from_file(file_path, test_arena());
 
+        // rune: Run tests in parallel, and report them afterwards in file order.
+        dk_test_job *test_jobs = null;
+        i64 test_job_count = 0;
+        if (jobs) {
+            u64 timestamp_begin = os_get_performance_timestamp();
+
+            test_jobs = arena_push_array(test_arena(), dk_test_job, tests.count);
+            for_list (dk_test, test, tests) {
+                if (str_idx_of_str(test->name, filter) != -1) {
+                    test_jobs[test_job_count].test = test;
+                    test_jobs[test_job_count].jobs = jobs;
+                    test_job_count++;
+                }
+            }
+
+            job_group group = { 0 };
+            for_n (i64, i, test_job_count) {
+                job_push(jobs, &group, dk_test_job_proc, &test_jobs[i]);
+            }
+            job_wait(jobs, &group);
+
+            ctx.duration_wall = os_get_millis_between(timestamp_begin, os_get_performance_timestamp());
+        }
+
         // rune: Loop over tests in file.
+        i64 job_idx = 0;
         for_list (dk_test, test, tests) {
             if (str_idx_of_str(test->name, filter) != -1) {
                 test_scope(test->name) {
-                    // rune: Run test.
+                    // rune: Run test, or take the result of its job.
                     str actual_output = { 0 };
-                    dk_err_sink err_sink = { 0 };
-                    dk_program program = dk_program_from_str(test->input, &err_sink, test_arena());
-
-                    if (err_sink.err_list.count > 0) {
-                        actual_output = err_sink.err_list.first->msg;
+                    if (test_jobs) {
+                        dk_test_job *job = &test_jobs[job_idx++];
+                        actual_output = arena_copy_str(test_arena(), job->actual_output);
+                        heap_free(job->actual_output.v);
+                        test_set_duration(job->duration);
                     } else {
-                        actual_output = dk_run_program(program, test_arena());
+                        actual_output = dk_run_test_program(test, null, test_arena());
                     }
 
                     // rune: Check result. We don't care about whitespace.
@@ -135,7 +197,1595 @@ static void dk_run_test_numbers(void) {
     }
 }
 
-static void dk_run_tests(void) {
+static void dk_test_selected_isa_proc(void *param) {
+    *(dk_bulk_isa *)param = dk_bulk_selected_isa();
+}
+
+static void dk_run_test_bulk_kernels(void) {
+    test_ctx ctx = { 0 };
+    ctx.name = str("Bulk kernels");
+    test_ctx(&ctx) {
+        // NOTE(rune): Every vector kernel must give the same result as the scalar kernel. Odd length to exercise the
+        // scalar tail loops, and floats are small multiples of 0.25, so sums are exact regardless of summation order.
+        enum { count = 37 };
+        u64 dst[count];
+        u64 src[count];
+        u64 expect_dst[count];
+        u64 actual_dst[count];
+
+        dk_bulk_isa restore_isa = dk_bulk_selected_isa();
+        dk_bulk_isa max_isa     = dk_bulk_detect_isa();
+
+        for (dk_bulk_isa isa = DK_BULK_ISA_SSE2; isa <= max_isa; isa++) {
+            for (dk_bulk_kernel kernel = dk_bulk_kernel_from_op(DK_BULK_OP_SUM, false); kernel < DK_BULK_KERNEL_COUNT; kernel++) {
+                bool is_float = dk_bulk_kernel_is_float(kernel);
+                test_scope("% %%" ANSI_RESET, dk_bulk_isa_names[isa], is_float ? "f" : "i", dk_bulk_op_names[dk_bulk_op_from_kernel(kernel)]) {
+                    u64 seed = 0x9e3779b97f4a7c15;
+                    for_n (i64, i, count) {
+                        seed = seed * 6364136223846793005 + 1442695040888963407;
+                        i64 a = i64(seed >> 40) % 1000 - 500;
+                        i64 b = i64(seed >> 20) % 1000 - 500;
+                        dst[i] = is_float ? u64_from_f64(f64(a) * 0.25) : u64(a * 1000003);
+                        src[i] = is_float ? u64_from_f64(f64(b) * 0.25) : u64(b * 1000033);
+                    }
+                    u64 scalar = is_float ? u64_from_f64(-1.5) : u64(-7);
+
+                    memcpy(expect_dst, dst, sizeof(dst));
+                    memcpy(actual_dst, dst, sizeof(dst));
+
+                    dk_bulk_select_isa(DK_BULK_ISA_SCALAR);
+                    u64 expect = dk_bulk_get_func(kernel)(expect_dst, src, count, scalar);
+
+                    dk_bulk_select_isa(isa);
+                    u64 actual = dk_bulk_get_func(kernel)(actual_dst, src, count, scalar);
+
+                    test_assert_eq(loc(), actual, expect);
+                    test_assert(loc(), memcmp(actual_dst, expect_dst, sizeof(dst)) == 0);
+                }
+            }
+        }
+
+        // NOTE(rune): Other threads keep the detected isa, while a test overrides it.
+        test_scope("isa override is per thread") {
+            dk_bulk_select_isa(DK_BULK_ISA_SCALAR);
+
+            dk_bulk_isa other_isa = DK_BULK_ISA_COUNT;
+            os_handle thread = os_thread_create(dk_test_selected_isa_proc, &other_isa);
+            os_thread_join(thread);
+
+            test_assert_eq(loc(), dk_bulk_selected_isa(), DK_BULK_ISA_SCALAR);
+            test_assert_eq(loc(), other_isa, max_isa);
+        }
+
+        dk_bulk_select_isa(restore_isa);
+    }
+}
+
+static void dk_run_test_map(void) {
+    test_ctx ctx = { 0 };
+    ctx.name = str("Hash map");
+    test_ctx(&ctx) {
+        test_scope("random put and remove") {
+            // NOTE(rune): Random puts and removes on a small key range, so keys collide, are removed and reinserted often,
+            // and probe chains are shifted back many times. A plain array is the reference.
+            enum { key_count = 300, op_count = 20000 };
+            u64  expect_vals[key_count] = { 0 };
+            bool expect_has[key_count]  = { 0 };
+            u64  expect_count = 0;
+
+            dk_map_list list = { 0 };
+            dk_map *map = dk_map_create(&list);
+
+            u64 seed = 0x2545f4914f6cdd1d;
+            for_n (i64, i, op_count) {
+                seed = seed * 6364136223846793005 + 1442695040888963407;
+                u64 key = (seed >> 33) % key_count;
+                u64 val = seed >> 11;
+
+                if ((seed >> 20) % 3 == 0) {
+                    bool removed = dk_map_remove(map, key);
+                    test_assert_eq(loc(), removed, expect_has[key]);
+                    expect_count -= expect_has[key];
+                    expect_has[key] = false;
+                } else {
+                    dk_map_put(map, key, val);
+                    expect_count += !expect_has[key];
+                    expect_has[key]  = true;
+                    expect_vals[key] = val;
+                }
+            }
+
+            test_assert_eq(loc(), dk_map_count(map), expect_count);
+            for_n (u64, key, key_count) {
+                u64 val = 0;
+                bool found = dk_map_get(map, key, &val);
+                test_assert_eq(loc(), found, expect_has[key]);
+                if (found) {
+                    test_assert_eq(loc(), val, expect_vals[key]);
+                }
+            }
+
+            // NOTE(rune): Maps left alive are freed by dk_map_destroy_all.
+            dk_map_create(&list);
+            dk_map_destroy_all(&list);
+            test_assert(loc(), list.first == null && list.last == null);
+        }
+    }
+}
+
+static void dk_run_test_input(void) {
+    test_ctx ctx = { 0 };
+    ctx.name = str("Input parsing");
+    test_ctx(&ctx) {
+        typedef struct test_case test_case;
+        struct test_case {
+            str input;
+            bool int_ok;
+            i64 expect_int;
+            bool float_ok;
+            f64 expect_float;
+        };
+
+        static readonly test_case test_cases[] = {
+            { STR("0"),                         true,  0,           true,  0.0                     },
+            { STR("-42"),                       true,  -42,         true,  -42.0                   },
+            { STR("+7"),                        true,  7,           true,  7.0                     },
+            { STR("9223372036854775807"),       true,  I64_MAX,     true,  9223372036854775807.0   },
+            { STR("-9223372036854775808"),      true,  I64_MIN,     true,  -9223372036854775808.0  },
+            { STR("9223372036854775808"),       false, 0,           true,  9223372036854775808.0   },
+            { STR("3,25"),                      false, 0,           true,  3.25                    },
+            { STR("-0,1"),                      false, 0,           true,  -0.1                    },
+            { STR("0,000001"),                  false, 0,           true,  0.000001                },
+            { STR("123456789012345678901,5"),   false, 0,           true,  123456789012345678901.5 },
+            { STR("1,"),                        false, 0,           false, 0.0                     },
+            { STR(",5"),                        false, 0,           false, 0.0                     },
+            { STR("1,2,3"),                     false, 0,           false, 0.0                     },
+            { STR("1.5"),                       false, 0,           false, 0.0                     },
+            { STR("-"),                         false, 0,           false, 0.0                     },
+            { STR("12a"),                       false, 0,           false, 0.0                     },
+        };
+
+        for_sarray (test_case, it, test_cases) {
+            test_scope("%" ANSI_RESET, it->input) {
+                i64 actual_int = 0;
+                bool int_ok = dk_parse_int(it->input, &actual_int);
+                test_assert_eq(loc(), int_ok, it->int_ok);
+                if (int_ok) {
+                    test_assert_eq(loc(), actual_int, it->expect_int);
+                }
+
+                f64 actual_float = 0;
+                bool float_ok = dk_parse_float(it->input, &actual_float);
+                test_assert_eq(loc(), float_ok, it->float_ok);
+                if (float_ok) {
+                    test_assert(loc(), actual_float == it->expect_float);
+                }
+            }
+        }
+
+        // NOTE(rune): Reading from a stream must give the same tokens as reading from memory, also when tokens cross
+        // the end of a block.
+        test_scope("stream tokens") {
+            str_list list = { 0 };
+            u64 seed = 0x853c49e6748fea9b;
+            for_n (i64, i, 100000) {
+                seed = seed * 6364136223846793005 + 1442695040888963407;
+                str_list_push_fmt(&list, test_arena(), "% ", i64(seed >> 32) - I32_MAX);
+            }
+            str data = str_list_concat(&list, test_arena());
+
+            FILE *f = tmpfile();
+            fwrite(data.v, 1, data.len, f);
+            rewind(f);
+
+            dk_input from_str    = dk_input_from_str(data);
+            dk_input from_stream = dk_input_from_stream(f);
+            i64 token_count = 0;
+            bool all_eq = true;
+            while (dk_input_has_more(&from_str)) {
+                str a = dk_input_next_token(&from_str);
+                str b = dk_input_next_token(&from_stream);
+                all_eq &= str_eq(a, b);
+                token_count += 1;
+            }
+
+            test_assert_eq(loc(), token_count, 100000);
+            test_assert(loc(), all_eq);
+            test_assert(loc(), !dk_input_has_more(&from_stream));
+            dk_input_close(&from_stream);
+        }
+
+        test_scope("stream lines") {
+            str data = str("1 2\r\n\n3 4\n56");
+            FILE *f = tmpfile();
+            fwrite(data.v, 1, data.len, f);
+            rewind(f);
+
+            static readonly str expect[] = { STR("1 2"), STR(""), STR("3 4"), STR("56") };
+            dk_input from_str    = dk_input_from_str(data);
+            dk_input from_stream = dk_input_from_stream(f);
+            for_n (i64, i, countof(expect)) {
+                str a = { 0 };
+                str b = { 0 };
+                test_assert(loc(), dk_input_next_line(&from_str, &a));
+                test_assert(loc(), dk_input_next_line(&from_stream, &b));
+                test_assert_eq(loc(), a, expect[i]);
+                test_assert_eq(loc(), b, expect[i]);
+            }
+
+            str line = { 0 };
+            test_assert(loc(), !dk_input_next_line(&from_str, &line));
+            test_assert(loc(), !dk_input_next_line(&from_stream, &line));
+            dk_input_close(&from_stream);
+        }
+
+        // NOTE(rune): The last token of a stream is not followed by whitespace.
+        test_scope("stream last token") {
+            FILE *f = tmpfile();
+            fwrite("12 345", 1, 6, f);
+            rewind(f);
+
+            dk_input input = dk_input_from_stream(f);
+            test_assert_eq(loc(), dk_input_next_token(&input), str("12"));
+            test_assert_eq(loc(), dk_input_next_token(&input), str("345"));
+            test_assert(loc(), !dk_input_has_more(&input));
+            dk_input_close(&input);
+        }
+    }
+}
+
+// NOTE(rune): Number of instructions with the given opcode in the body of a program.
+static i64 dk_test_count_opcode(dk_program *program, dk_bc_opcode opcode) {
+    dk_buffer *body = &program->body;
+    i64 ret = 0;
+    i64 pos = 0;
+    while (pos < body->size) {
+        u64 operand = 0;
+        dk_bc_opcode it = dk_lanes_read_inst(body, &pos, &operand);
+        ret += it == opcode;
+
+        // rune: Skip data following the instruction.
+        if (it == DK_BC_OPCODE_SWITCH) {
+            pos += isizeof(dk_bc_switch_header) + i64(operand) * isizeof(dk_bc_switch_entry);
+        }
+        if (it == DK_BC_OPCODE_PFOR) {
+            dk_bc_pfor_header *header = dk_buffer_read_struct(body, &pos, dk_bc_pfor_header);
+            pos += i64(header->reduction_count) * isizeof(dk_bc_pfor_reduction);
+        }
+    }
+    return ret;
+}
+
+static void dk_run_test_build_modes(void) {
+    test_ctx ctx = { 0 };
+    ctx.name = str("Build modes");
+    test_ctx(&ctx) {
+        typedef struct test_case test_case;
+        struct test_case {
+            char *name;
+            str program;
+            str expect_checked;
+            str expect_unchecked; // NOTE(rune): Empty when the unchecked result is undefined.
+        };
+
+        #define DK_TEST_MAIN(body) STR("Offentlig Funktion Hovedsagelig tilbagegiver heltal.\nGoddag.\n" body "Farvel.\n")
+
+        // NOTE(rune): Unchecked integer division only faults on x64. On e.g. arm64 it gives a result instead.
+#if defined(__x86_64__) || defined(_M_X64)
+        #define DK_TEST_DIV_FAULT(expect) STR(expect)
+#else
+        #define DK_TEST_DIV_FAULT(expect) STR("")
+#endif
+
+        static readonly test_case test_cases[] = {
+            {
+                "add overflow",
+                DK_TEST_MAIN("    Lad A være et heltal.\n"
+                             "    Gem 9223372036854775807 i A.\n"
+                             "    Læg A sammen med 1, og print det.\n"),
+                STR("Runtime error: Integer overflow at line 5, column 5."),
+                STR("-9223372036854775808"),
+            },
+            {
+                "sub overflow",
+                DK_TEST_MAIN("    Lad A være et heltal.\n"
+                             "    Gem 9223372036854775807 i A.\n"
+                             "    Træk 0 fra A, træk det fra 2, og print det.\n"),
+                STR("Runtime error: Integer overflow at line 5, column 20."),
+                STR("9223372036854775807"),
+            },
+            {
+                "mul overflow",
+                DK_TEST_MAIN("    Lad A være et heltal.\n"
+                             "    Gem 4611686018427387904 i A.\n"
+                             "    Gang A med 2, og print det.\n"),
+                STR("Runtime error: Integer overflow at line 5, column 5."),
+                STR("-9223372036854775808"),
+            },
+            {
+                "folded overflow",
+                DK_TEST_MAIN("    Læg 9223372036854775807 sammen med 1, og print det.\n"),
+                STR("Runtime error: Integer overflow at line 3, column 5."),
+                STR("-9223372036854775808"),
+            },
+            {
+                "division by zero",
+                DK_TEST_MAIN("    Lad A være et heltal.\n"
+                             "    Del 10 med A, og print det.\n"),
+                STR("Runtime error: Division by zero at line 4, column 5."),
+                DK_TEST_DIV_FAULT("Runtime error: Integer division by zero or overflow.\n    in Hovedsagelig (line 1)"),
+            },
+            {
+                "remainder by zero",
+                DK_TEST_MAIN("    Lad A være et heltal.\n"
+                             "    Rest af 10 delt med A, og print det.\n"),
+                STR("Runtime error: Division by zero at line 4, column 5."),
+                DK_TEST_DIV_FAULT("Runtime error: Integer division by zero or overflow.\n    in Hovedsagelig (line 1)"),
+            },
+            {
+                "division overflow",
+                DK_TEST_MAIN("    Lad A være et heltal.\n"
+                             "    Lad B være et heltal.\n"
+                             "    Gem 9223372036854775807 i A.\n"
+                             "    Træk 0 fra A, træk det fra 1, og gem det i A.\n"
+                             "    Træk 0 fra 1, og gem det i B.\n"
+                             "    Del A med B, og print det.\n"),
+                STR("Runtime error: Integer overflow at line 8, column 5."),
+                DK_TEST_DIV_FAULT("Runtime error: Integer division by zero or overflow.\n    in Hovedsagelig (line 1)"),
+            },
+            {
+                "division by zero in called function",
+                STR("Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+                    "Goddag.\n"
+                    "    Print (halver 0).\n"
+                    "Farvel.\n"
+                    "\n"
+                    "Offentlig Funktion Halver (X som heltal) tilbagegiver heltal.\n"
+                    "Goddag.\n"
+                    "    Lad A være et heltal.\n"
+                    "    Del X med A, og gem det i A.\n"
+                    "    Tilbagegiv A.\n"
+                    "Farvel.\n"),
+                STR("Runtime error: Division by zero at line 9, column 5."),
+                DK_TEST_DIV_FAULT("Runtime error: Integer division by zero or overflow.\n"
+                                  "    in Halver (line 6)\n"
+                                  "    in Hovedsagelig (line 1)"),
+            },
+            {
+                "no overflow",
+                DK_TEST_MAIN("    Lad A være et heltal.\n"
+                             "    Gem 9223372036854775806 i A.\n"
+                             "    Læg A sammen med 1, og print det.\n"
+                             "    Rest af A delt med 10, og print det.\n"),
+                STR("9223372036854775807\n6"),
+                STR("9223372036854775807\n6"),
+            },
+            {
+                // NOTE(rune): K wraps around to -2, so the increment may not be trusted as a lower bound on K.
+                "wrapped list index",
+                DK_TEST_MAIN("    Lad K være et heltal.\n"
+                             "    Lad L være en liste af 4 heltal.\n"
+                             "    Læg K sammen med 9223372036854775807, og gem det i K.\n"
+                             "    Læg K sammen med 9223372036854775807, og gem det i K.\n"
+                             "    Imens K er mindre end 4.\n"
+                             "    Goddag.\n"
+                             "        Gem 12345 på plads K i L.\n"
+                             "        Læg K sammen med 1, og gem det i K.\n"
+                             "    Farvel.\n"),
+                STR("Runtime error: Integer overflow at line 6, column 5."),
+                STR("Runtime error: Index -2 is out of bounds for list of length 4."),
+            },
+            {
+                "wrapped field index",
+                STR("Offentlig type Punkt.\n"
+                    "Goddag.\n"
+                    "    Lad X være et heltal.\n"
+                    "Farvel.\n"
+                    "\n"
+                    "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+                    "Goddag.\n"
+                    "    Lad K være et heltal.\n"
+                    "    Lad L være en liste af 4 Punkt.\n"
+                    "    Læg K sammen med 9223372036854775807, og gem det i K.\n"
+                    "    Læg K sammen med 9223372036854775807, og gem det i K.\n"
+                    "    Imens K er mindre end 4.\n"
+                    "    Goddag.\n"
+                    "        Gem 12345 i X af L på plads K.\n"
+                    "        Læg K sammen med 1, og gem det i K.\n"
+                    "    Farvel.\n"
+                    "Farvel.\n"),
+                STR("Runtime error: Integer overflow at line 11, column 5."),
+                STR("Runtime error: Index -2 is out of bounds for list of length 4."),
+            },
+            {
+                // NOTE(rune): K wraps around from 127 to -128, before the loop condition stops it.
+                "wrapped narrow list index",
+                DK_TEST_MAIN("    Lad K være et småtal.\n"
+                             "    Lad L være en liste af 200 heltal.\n"
+                             "    Imens K er mindre end 200.\n"
+                             "    Goddag.\n"
+                             "        Gem 777 på plads K i L.\n"
+                             "        Læg K sammen med 1, og gem det i K.\n"
+                             "    Farvel.\n"),
+                STR("Runtime error: Index -128 is out of bounds for list of length 200."),
+                STR("Runtime error: Index -128 is out of bounds for list of length 200."),
+            },
+            {
+                "bulk sum overflow",
+                DK_TEST_MAIN("    Lad A være en liste af 2 heltal.\n"
+                             "    Gem 9223372036854775807 på plads 0 i A.\n"
+                             "    Gem 1 på plads 1 i A.\n"
+                             "    Summen af A, og print det.\n"),
+                STR("Runtime error: Integer overflow at line 6, column 5."),
+                STR("-9223372036854775808"),
+            },
+            {
+                "bulk scale overflow",
+                DK_TEST_MAIN("    Lad A være en liste af 3 heltal.\n"
+                             "    Gem 1 på plads 0 i A.\n"
+                             "    Gem 4611686018427387904 på plads 1 i A.\n"
+                             "    Skaler A med 2.\n"
+                             "    Print (A på plads 0).\n"),
+                STR("Runtime error: Integer overflow at line 6, column 5."),
+                STR("2"),
+            },
+            {
+                "literal too large",
+                DK_TEST_MAIN("    Print 9223372036854775808.\n"),
+                STR("Integer literal is too large."),
+                STR("Integer literal is too large."),
+            },
+        };
+
+        #undef DK_TEST_MAIN
+        #undef DK_TEST_DIV_FAULT
+
+        for_n (i64, i, countof(test_cases)) {
+            test_case t = test_cases[i];
+            test_scope(t.name) {
+                for_n (i64, mode, 2) {
+                    str expect = mode ? t.expect_unchecked : t.expect_checked;
+                    if (expect.len == 0) {
+                        continue;
+                    }
+
+                    str actual = { 0 };
+                    dk_err_sink err_sink = { 0 };
+                    dk_ctx dk = { &err_sink, test_arena() };
+                    dk_program program = dk_program_from_str(t.program, mode ? DK_BUILD_FLAG_UNCHECKED : 0, &dk);
+                    if (err_sink.err_list.count > 0) {
+                        actual = err_sink.err_list.first->msg;
+                    } else {
+                        dk_input input = dk_input_from_str(str(""));
+                        actual = dk_run_program(program, &input, null, test_arena());
+                    }
+
+                    test_assert_eq(loc(), str_trim(actual), expect);
+                }
+            }
+        }
+
+        // rune: Bounds check elimination
+        typedef struct bounds_case bounds_case;
+        struct bounds_case {
+            char *name;
+            char *index_type;
+            i64 bound;
+            bool expect_unchecked;
+        };
+
+        static readonly bounds_case bounds_cases[] = {
+            { "counting loop",              "heltal", 10,  true  },
+            { "narrow counting loop",       "småtal", 10,  true  },
+            { "narrow loop past its range", "småtal", 200, false },
+        };
+
+        for_n (i64, i, countof(bounds_cases)) {
+            bounds_case t = bounds_cases[i];
+            for_n (i64, mode, 2) {
+                test_scope("% %", mode ? "unchecked" : "checked", t.name) {
+                    str src = arena_print(test_arena(),
+                                          "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+                                          "Goddag.\n"
+                                          "    Lad K være et %.\n"
+                                          "    Lad L være en liste af 200 heltal.\n"
+                                          "    Imens K er mindre end %.\n"
+                                          "    Goddag.\n"
+                                          "        Gem 777 på plads K i L.\n"
+                                          "        Læg K sammen med 1, og gem det i K.\n"
+                                          "    Farvel.\n"
+                                          "Farvel.\n",
+                                          t.index_type, t.bound);
+
+                    dk_err_sink err_sink = { 0 };
+                    dk_ctx dk = { &err_sink, test_arena() };
+                    dk_program program = dk_program_from_str(src, mode ? DK_BUILD_FLAG_UNCHECKED : 0, &dk);
+                    test_assert_eq(loc(), err_sink.err_list.count, 0);
+                    test_assert_eq(loc(), dk_test_count_opcode(&program, DK_BC_OPCODE_STXU), i64(t.expect_unchecked));
+                    test_assert_eq(loc(), dk_test_count_opcode(&program, DK_BC_OPCODE_STX), i64(!t.expect_unchecked));
+                }
+            }
+        }
+    }
+}
+
+typedef struct dk_test_job_param dk_test_job_param;
+struct dk_test_job_param {
+    job_system *system;
+    volatile i64 *sum;
+    i64 value;
+};
+
+static void dk_test_job_add(void *param) {
+    dk_test_job_param *p = param;
+    atomic_add_i64(p->sum, p->value);
+}
+
+// NOTE(rune): Pushes a nested group from inside a job, and waits on it.
+static void dk_test_job_fan_out(void *param) {
+    dk_test_job_param *p = param;
+    dk_test_job_param children[16];
+    job_group group = { 0 };
+    for_n (i64, i, countof(children)) {
+        children[i] = *p;
+        job_push(p->system, &group, dk_test_job_add, &children[i]);
+    }
+    job_wait(p->system, &group);
+}
+
+static void dk_run_test_jobs(void) {
+    test_ctx ctx = { 0 };
+    ctx.name = str("jobs");
+    test_ctx(&ctx) {
+        job_system *system = job_system_create(4);
+
+        test_scope("many jobs") {
+            volatile i64 sum = 0;
+            job_group group = { 0 };
+            i64 count = 10000;
+            dk_test_job_param *params = arena_push_array_nozero(test_arena(), dk_test_job_param, count);
+            for_n (i64, i, count) {
+                params[i] = (dk_test_job_param) { system, &sum, i + 1 };
+                job_push(system, &group, dk_test_job_add, &params[i]);
+            }
+            job_wait(system, &group);
+            test_assert_eq(loc(), sum, count * (count + 1) / 2);
+            test_assert_eq(loc(), group.pending, 0);
+        }
+
+        test_scope("nested jobs") {
+            volatile i64 sum = 0;
+            job_group group = { 0 };
+            dk_test_job_param params[64];
+            for_n (i64, i, countof(params)) {
+                params[i] = (dk_test_job_param) { system, &sum, 1 };
+                job_push(system, &group, dk_test_job_fan_out, &params[i]);
+            }
+            job_wait(system, &group);
+            test_assert_eq(loc(), sum, 64 * 16);
+        }
+
+        test_scope("wait on empty group") {
+            job_group group = { 0 };
+            job_wait(system, &group);
+            test_assert_eq(loc(), group.pending, 0);
+        }
+
+        job_system_destroy(system);
+    }
+}
+
+// NOTE(rune): Function names are made from consonants only, so they never collide with keywords such as "og".
+static str dk_test_func_name(i64 idx, arena *arena) {
+    static readonly char consonants[] = "bcdfghjklmnpqrstvwxz";
+    i64 n = countof(consonants) - 1;
+    str ret = arena_copy_str(arena, str("Trin xx"));
+    ret.v[5] = consonants[(idx / n) % n];
+    ret.v[6] = consonants[idx % n];
+    return ret;
+}
+
+// NOTE(rune): Programs with more functions than DK_FUNCS_PER_JOB, so bodies are checked and emitted by several jobs.
+static void dk_run_test_parallel_compile(job_system *jobs) {
+    test_ctx ctx = { 0 };
+    ctx.name = str("Parallel compilation");
+    test_ctx(&ctx) {
+        i64 func_count = DK_FUNCS_PER_JOB * 5 + 3;
+
+        test_scope("many functions") {
+            // rune: Each function loops, switches, and calls the next one, so jumps, switch tables and symbols
+            // in every batch must be moved when the batches are concatenated.
+            str_list list = { 0 };
+            str_list_push_fmt(&list, test_arena(), "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\nGoddag.\n");
+            str_list_push_fmt(&list, test_arena(), "    % 5, og print det.\nFarvel.\n\n", dk_test_func_name(0, test_arena()));
+
+            i64 expect = 5;
+            for_n (i64, i, func_count) {
+                str_list_push_fmt(&list, test_arena(), "Offentlig Funktion % (A som heltal) tilbagegiver heltal.\n", dk_test_func_name(i, test_arena()));
+                str_list_push_fmt(&list, test_arena(),
+                    "Goddag.\n"
+                    "    Lad K være et heltal.\n"
+                    "    Imens K er mindre end 3.\n"
+                    "    Goddag.\n"
+                    "        Læg A sammen med K, og gem det i A.\n"
+                    "        Læg K sammen med 1, og gem det i K.\n"
+                    "    Farvel.\n"
+                    "    Vælg rest af A delt med 3.\n"
+                    "    Goddag.\n"
+                    "        Tilfælde 0. Goddag. Læg A sammen med 10, og gem det i A. Farvel.\n"
+                    "        Tilfælde 1. Goddag. Læg A sammen med 20, og gem det i A. Farvel.\n"
+                    "        Ellers. Goddag. Læg A sammen med 30, og gem det i A. Farvel.\n"
+                    "    Farvel.\n");
+                if (i + 1 < func_count) {
+                    str_list_push_fmt(&list, test_arena(), "    % A, og gem det i A.\n", dk_test_func_name(i + 1, test_arena()));
+                }
+                str_list_push_fmt(&list, test_arena(), "    Tilbagegiv A.\nFarvel.\n\n");
+
+                expect += 3;
+                expect += expect % 3 == 0 ? 10 : expect % 3 == 1 ? 20 : 30;
+            }
+
+            str src = str_list_concat(&list, test_arena());
+            dk_err_sink err_sink = { 0 };
+            dk_ctx dk = { &err_sink, test_arena(), jobs };
+            dk_program program = dk_program_from_str(src, 0, &dk);
+            test_assert_eq(loc(), err_sink.err_list.count, 0);
+            if (err_sink.err_list.count == 0) {
+                dk_input input = dk_input_from_str(str(""));
+                str actual = dk_run_program(program, &input, null, test_arena());
+                test_assert_eq(loc(), str_trim(actual), arena_print(test_arena(), "%", expect));
+            }
+        }
+
+        test_scope("first error wins") {
+            // rune: Errors in several batches. Only the first function with an error is reported, like when
+            // checking serially.
+            str_list list = { 0 };
+            str_list_push_fmt(&list, test_arena(), "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\nGoddag.\nFarvel.\n\n");
+            for_n (i64, i, func_count) {
+                str_list_push_fmt(&list, test_arena(), "Offentlig Funktion % tilbagegiver heltal.\nGoddag.\n", dk_test_func_name(i, test_arena()));
+                if (i == DK_FUNCS_PER_JOB * 2 + 1) {
+                    str_list_push_fmt(&list, test_arena(), "    Lad A være konstant 1.\n    Lad A være konstant 2.\n");
+                }
+                if (i == DK_FUNCS_PER_JOB * 4) {
+                    str_list_push_fmt(&list, test_arena(), "    Lad B være konstant 1.\n    Gem 2 i B.\n");
+                }
+                str_list_push_fmt(&list, test_arena(), "Farvel.\n\n");
+            }
+
+            str src = str_list_concat(&list, test_arena());
+            dk_err_sink err_sink = { 0 };
+            dk_ctx dk = { &err_sink, test_arena(), jobs };
+            dk_program_from_str(src, 0, &dk);
+            test_assert_eq(loc(), err_sink.err_list.count, 1);
+            if (err_sink.err_list.count > 0) {
+                test_assert_eq(loc(), err_sink.err_list.first->msg, str("A is already declared."));
+            }
+        }
+
+        // NOTE(rune): dansk run creates a job system for every compilation, which must not start workers for
+        // programs that fit in a single batch.
+        test_scope("small program starts no workers") {
+            job_system *fresh = job_system_create(2);
+            dk_err_sink err_sink = { 0 };
+            dk_ctx dk = { &err_sink, test_arena(), fresh };
+            dk_program_from_str(str("Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+                                    "Goddag.\n"
+                                    "    Lad K være et heltal.\n"
+                                    "    Imens K er mindre end 10.\n"
+                                    "    Goddag.\n"
+                                    "        Læg K sammen med 1, og gem det i K.\n"
+                                    "    Farvel.\n"
+                                    "Farvel.\n"), 0, &dk);
+            test_assert_eq(loc(), err_sink.err_list.count, 0);
+            test_assert_eq(loc(), fresh->started, 0);
+            job_system_destroy(fresh);
+        }
+    }
+}
+
+static void dk_run_test_embedding(void) {
+    static char *src =
+        "Lad G være et heltal.\n"
+        "\n"
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Print 1.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Sæt (A som heltal) i anden tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Læg G sammen med 1, og gem det i G.\n"
+        "    Print G.\n"
+        "    Tilbagegiv Gang A med A.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Fordel (A som heltal) blandt (B som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Tilbagegiv Del A med B.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Læg (A som byte) til (B som småtal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Tilbagegiv Læg A sammen med B.\n"
+        "Farvel.\n";
+
+    test_ctx ctx = { 0 };
+    ctx.name = str("Embedding");
+    test_ctx(&ctx) {
+        dk_lib_program *program = dk_lib_compile(str_from_cstr(src), 0, null);
+        dk_vm *vm = dk_lib_vm_create();
+
+        test_scope("compile") {
+            test_assert_eq(loc(), program->err, str(""));
+        }
+
+        test_scope("call many times") {
+            dk_bc_symbol *func = dk_lib_find_func(program, str("sæt <heltal> i anden"));
+            test_assert(loc(), func != null);
+            for_n (i64, i, 100) {
+                u64 args[] = { u64(i) };
+                dk_lib_result result = dk_lib_call(vm, program, func, args, countof(args), null, test_arena());
+                test_assert(loc(), result.ok);
+                test_assert_eq(loc(), result.value_count, 1);
+                test_assert_eq(loc(), i64(result.values[0]), i * i);
+
+                // NOTE(rune): Globals start over on each call.
+                test_assert_eq(loc(), result.output, str("1\n"));
+            }
+        }
+
+        test_scope("two arguments") {
+            dk_bc_symbol *func = dk_lib_find_func(program, str("Fordel <heltal> blandt <heltal>"));
+            u64 args[] = { 84, 2 };
+            dk_lib_result result = dk_lib_call(vm, program, func, args, countof(args), null, test_arena());
+            test_assert(loc(), result.ok);
+            test_assert_eq(loc(), i64(result.values[0]), 42);
+        }
+
+        test_scope("runtime error") {
+            dk_bc_symbol *func = dk_lib_find_func(program, str("Fordel <heltal> blandt <heltal>"));
+            u64 args[] = { 1, 0 };
+            dk_lib_result result = dk_lib_call(vm, program, func, args, countof(args), null, test_arena());
+            test_assert(loc(), !result.ok);
+            test_assert(loc(), str_starts_with_str(result.output, str("Runtime error")));
+
+            // NOTE(rune): The vm can be used again after an error.
+            u64 args_ok[] = { 9, 3 };
+            result = dk_lib_call(vm, program, func, args_ok, countof(args_ok), null, test_arena());
+            test_assert(loc(), result.ok);
+            test_assert_eq(loc(), i64(result.values[0]), 3);
+        }
+
+        test_scope("wrong argument count") {
+            dk_bc_symbol *func = dk_lib_find_func(program, str("Fordel <heltal> blandt <heltal>"));
+            u64 args[] = { 1 };
+            dk_lib_result result = dk_lib_call(vm, program, func, args, countof(args), null, test_arena());
+            test_assert(loc(), !result.ok);
+        }
+
+        test_scope("arguments from text") {
+            dk_bc_symbol *func = dk_lib_find_func(program, str("Fordel <heltal> blandt <heltal>"));
+            u64 args[4];
+            i64 arg_count = 0;
+            test_assert(loc(), dk_lib_args_from_str(func, str(" 84  -2 "), args, countof(args), &arg_count));
+            test_assert_eq(loc(), arg_count, 2);
+            test_assert_eq(loc(), i64(args[1]), -2);
+
+            dk_lib_result result = dk_lib_call(vm, program, func, args, arg_count, null, test_arena());
+            test_assert_eq(loc(), dk_lib_str_from_values(func, result.values, result.value_count, test_arena()), str("-42"));
+
+            test_assert(loc(), !dk_lib_args_from_str(func, str("84"), args, countof(args), &arg_count));
+            test_assert(loc(), !dk_lib_args_from_str(func, str("84 2 1"), args, countof(args), &arg_count));
+            test_assert(loc(), !dk_lib_args_from_str(func, str("84 2,5"), args, countof(args), &arg_count));
+        }
+
+        test_scope("narrow arguments from text") {
+            dk_bc_symbol *func = dk_lib_find_func(program, str("Læg <byte> til <småtal>"));
+            test_assert(loc(), func != null);
+            u64 args[4];
+            i64 arg_count = 0;
+            test_assert(loc(), dk_lib_args_from_str(func, str("255 -128"), args, countof(args), &arg_count));
+            test_assert_eq(loc(), arg_count, 2);
+
+            dk_lib_result result = dk_lib_call(vm, program, func, args, arg_count, null, test_arena());
+            test_assert_eq(loc(), dk_lib_str_from_values(func, result.values, result.value_count, test_arena()), str("127"));
+
+            // NOTE(rune): Would wrap around to e.g. 232 for a byte.
+            test_assert(loc(), !dk_lib_args_from_str(func, str("1000 0"), args, countof(args), &arg_count));
+            test_assert(loc(), !dk_lib_args_from_str(func, str("256 0"), args, countof(args), &arg_count));
+            test_assert(loc(), !dk_lib_args_from_str(func, str("-1 0"), args, countof(args), &arg_count));
+            test_assert(loc(), !dk_lib_args_from_str(func, str("0 128"), args, countof(args), &arg_count));
+            test_assert(loc(), !dk_lib_args_from_str(func, str("0 -129"), args, countof(args), &arg_count));
+        }
+
+        test_scope("unknown function") {
+            test_assert(loc(), dk_lib_find_func(program, str("Fordel <flyder> blandt <heltal>")) == null);
+        }
+
+        test_scope("compilation error") {
+            dk_lib_program *bad = dk_lib_compile(str("Offentlig Funktion"), 0, null);
+            test_assert(loc(), bad->err.len > 0);
+            test_assert(loc(), dk_lib_find_func(bad, str("Hovedsagelig")) == null);
+            dk_lib_program_destroy(bad);
+        }
+
+        dk_lib_vm_destroy(vm);
+        dk_lib_program_destroy(program);
+    }
+}
+
+static void dk_run_test_lanes(void) {
+    static char *src =
+        "Lad G være et heltal.\n"
+        "\n"
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Tilbagegiv 0.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Collatz (N som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad S være et heltal.\n"
+        "    Imens N er større end 1.\n"
+        "    Goddag.\n"
+        "        Hvis (rest af N delt med 2) er lig med 0.\n"
+        "        Goddag.\n"
+        "            Del N med 2, og gem det i N.\n"
+        "        Farvel.\n"
+        "        Ellers.\n"
+        "        Goddag.\n"
+        "            Gang N med 3, og gem det i N.\n"
+        "            Læg N sammen med 1, og gem det i N.\n"
+        "        Farvel.\n"
+        "        Læg S sammen med 1, og gem det i S.\n"
+        "    Farvel.\n"
+        "    Læg G sammen med 1, og gem det i G.\n"
+        "    Tilbagegiv Læg S sammen med G.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Fib (N som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Hvis N er mindre end 2.\n"
+        "    Goddag.\n"
+        "        Tilbagegiv N.\n"
+        "    Farvel.\n"
+        "    Tilbagegiv Læg (Fib (Træk N fra 1)) sammen med (Fib (Træk N fra 2)).\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Klassificer (N som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad R være et heltal.\n"
+        "    Vælg N.\n"
+        "    Goddag.\n"
+        "        Tilfælde 1.\n"
+        "        Goddag.\n"
+        "            Gem 10 i R.\n"
+        "        Farvel.\n"
+        "        Tilfælde 2.\n"
+        "        Goddag.\n"
+        "            Gem 20 i R.\n"
+        "        Farvel.\n"
+        "        Tilfælde 7.\n"
+        "        Goddag.\n"
+        "            Gem (Fib N) i R.\n"
+        "        Farvel.\n"
+        "        Ellers.\n"
+        "        Goddag.\n"
+        "            Træk 0 fra 1, og gem det i R.\n"
+        "        Farvel.\n"
+        "    Farvel.\n"
+        "    Tilbagegiv R.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Pak (N som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad A være en byte.\n"
+        "    Lad B være et småtal.\n"
+        "    Gem N i A.\n"
+        "    Gem N i B.\n"
+        "    Tilbagegiv Læg A sammen med B.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Summer (N som heltal) gange tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad L være en liste af 5 heltal.\n"
+        "    Lad K være et heltal.\n"
+        "    Lad S være et heltal.\n"
+        "    Imens K er mindre end 5.\n"
+        "    Goddag.\n"
+        "        Gang K med N, og gem det på plads K i L.\n"
+        "        Læg K sammen med 1, og gem det i K.\n"
+        "    Farvel.\n"
+        "    Gem 0 i K.\n"
+        "    Imens K er mindre end N.\n"
+        "    Goddag.\n"
+        "        Læg (L på plads K) sammen med S, og gem det i S.\n"
+        "        Læg K sammen med 1, og gem det i K.\n"
+        "    Farvel.\n"
+        "    Tilbagegiv S.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Kvadrer (N som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Tilbagegiv Gang N med N.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Fordel (A som heltal) blandt (B som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Tilbagegiv Del A med B.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Rod (X som flyder) tilbagegiver flyder.\n"
+        "Goddag.\n"
+        "    Hvis X er mindre end 0,0.\n"
+        "    Goddag.\n"
+        "        Tilbagegiv 0,0.\n"
+        "    Farvel.\n"
+        "    Tilbagegiv Læg (kvadratroden af X) sammen med (Del X med 3,0).\n"
+        "Farvel.\n";
+
+    typedef struct dk_lanes_case dk_lanes_case;
+    struct dk_lanes_case {
+        char *signature;
+        i64 lo[2];
+        i64 hi[2];
+        bool is_float;
+    };
+
+    // NOTE(rune): Ranges are picked so lanes of the same batch take different branches, and some of them fail.
+    static dk_lanes_case cases[] = {
+        { "Collatz <heltal>",               { 1 },              { 60 }              },
+        { "Fib <heltal>",                   { 0 },              { 15 }              },
+        { "Klassificer <heltal>",           { 0 },              { 8 }               },
+        { "Pak <heltal>",                   { -1000 },          { 1000 }            },
+        { "Summer <heltal> gange",          { 0 },              { 6 }               },
+        { "Kvadrer <heltal>",               { -4000000000 },    { 4000000000 }      },
+        { "Fordel <heltal> blandt <heltal>",{ -1000, -1 },      { 1000, 1 }         },
+        { "Rod <flyder>",                   { -10 },            { 100 },    true    },
+    };
+
+    test_ctx ctx = { 0 };
+    ctx.name = str("Lockstep");
+    test_ctx(&ctx) {
+        dk_bulk_isa restore_isa = dk_bulk_selected_isa();
+        dk_bulk_isa max_isa     = dk_bulk_detect_isa();
+
+        dk_lanes lanes = { 0 };
+        dk_lanes_init(&lanes);
+        dk_vm *vm = dk_lib_vm_create();
+
+        for (dk_build_flags flags = 0; flags <= DK_BUILD_FLAG_UNCHECKED; flags++) {
+            dk_lib_program *program = dk_lib_compile(str_from_cstr(src), flags, null);
+            test_scope("% supported", flags ? "unchecked" : "checked") {
+                test_assert_eq(loc(), program->err, str(""));
+                test_assert(loc(), program->lockstep);
+            }
+
+            for (dk_bulk_isa isa = DK_BULK_ISA_SCALAR; isa <= max_isa; isa++) {
+                dk_bulk_select_isa(isa);
+                for_sarray (dk_lanes_case, it, cases) {
+                    test_scope("% % %", flags ? "unchecked" : "checked", dk_bulk_isa_names[isa], it->signature) {
+                        dk_bc_symbol *func = dk_lib_find_func(program, str_from_cstr(it->signature));
+                        test_assert(loc(), func != null);
+
+                        u64 seed = 0x9e3779b97f4a7c15;
+                        for_n (i64, batch, 20) {
+                            i64 lane_count = batch % 4 == 3 ? batch % DK_LANES_MAX + 1 : DK_LANES_MAX;
+                            u64 args[DK_LANES_MAX * 2] = { 0 };
+                            for_n (i64, i, lane_count * func->arg_slots) {
+                                seed = seed * 6364136223846793005 + 1442695040888963407;
+                                i64 arg = i % func->arg_slots;
+                                i64 value = it->lo[arg] + i64((seed >> 16) % u64(it->hi[arg] - it->lo[arg] + 1));
+                                args[i] = it->is_float ? u64_from_f64(f64(value) * 0.5) : u64(value);
+                            }
+
+                            dk_lib_result results[DK_LANES_MAX];
+                            dk_lanes_call(&lanes, program, func, args, func->arg_slots, lane_count, results, test_arena());
+
+                            for_n (i64, lane, lane_count) {
+                                dk_lib_result expect = dk_lib_call(vm, program, func, args + lane * func->arg_slots, func->arg_slots, null, test_arena());
+                                test_assert_eq(loc(), results[lane].ok, expect.ok);
+                                test_assert_eq(loc(), results[lane].output, expect.output);
+                                test_assert_eq(loc(), results[lane].value_count, expect.value_count);
+                                if (results[lane].ok && expect.ok) {
+                                    test_assert_eq(loc(), results[lane].values[0], expect.values[0]);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            test_scope("% division overflow", flags ? "unchecked" : "checked") {
+                dk_bc_symbol *func = dk_lib_find_func(program, str("Fordel <heltal> blandt <heltal>"));
+                u64 args[] = { u64(I64_MIN), u64(-1), 10, 5 };
+                dk_lib_result results[2];
+                dk_lanes_call(&lanes, program, func, args, 2, 2, results, test_arena());
+                test_assert(loc(), !results[0].ok);
+                test_assert(loc(), str_starts_with_str(results[0].output, str("Runtime error")));
+                test_assert(loc(), results[1].ok);
+                test_assert_eq(loc(), i64(results[1].values[0]), 2);
+            }
+
+            dk_lib_program_destroy(program);
+        }
+
+        test_scope("fallback") {
+            dk_lib_program *program = dk_lib_compile(str("Offentlig Funktion Vis (N som heltal) tilbagegiver heltal.\n"
+                                                         "Goddag.\n"
+                                                         "    Print N.\n"
+                                                         "    Tilbagegiv Gang N med 2.\n"
+                                                         "Farvel.\n"), 0, null);
+            test_assert(loc(), !program->lockstep);
+
+            dk_bc_symbol *func = dk_lib_find_func(program, str("Vis <heltal>"));
+            u64 args[] = { 1, 2, 3 };
+            dk_lib_result results[3];
+            dk_lanes_call(&lanes, program, func, args, 1, 3, results, test_arena());
+            for_n (i64, lane, 3) {
+                test_assert(loc(), results[lane].ok);
+                test_assert_eq(loc(), results[lane].output, arena_print(test_arena(), "%\n", lane + 1));
+                test_assert_eq(loc(), i64(results[lane].values[0]), (lane + 1) * 2);
+            }
+
+            // NOTE(rune): Wrong argument counts are reported like dk_lib_call() does.
+            dk_lanes_call(&lanes, program, func, args, 2, 1, results, test_arena());
+            test_assert(loc(), !results[0].ok);
+            dk_lib_program_destroy(program);
+        }
+
+        dk_lib_vm_destroy(vm);
+        dk_lanes_destroy(&lanes);
+        dk_bulk_select_isa(restore_isa);
+    }
+}
+
+static void dk_run_test_sched(job_system *jobs) {
+    static char *counting_src =
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad A være et heltal.\n"
+        "    Lad S være et heltal.\n"
+        "    Imens A er mindre end 1000.\n"
+        "    Goddag.\n"
+        "        Læg A sammen med 1, og gem det i A.\n"
+        "        Vælg A.\n"
+        "        Goddag.\n"
+        "            Tilfælde 1.\n"
+        "            Goddag.\n"
+        "                Print 1.\n"
+        "            Farvel.\n"
+        "            Tilfælde 2.\n"
+        "            Goddag.\n"
+        "                Læg S sammen med 2, og gem det i S.\n"
+        "            Farvel.\n"
+        "        Farvel.\n"
+        "        Læg (Kvadrer A) sammen med S, og gem det i S.\n"
+        "    Farvel.\n"
+        "    Print S.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Kvadrer (A som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Tilbagegiv Gang A med A.\n"
+        "Farvel.\n";
+
+    static char *forever_src =
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad A være et heltal.\n"
+        "    Imens sand.\n"
+        "    Goddag.\n"
+        "        Læg A sammen med 1, og gem det i A.\n"
+        "    Farvel.\n"
+        "Farvel.\n";
+
+    static char *pfor_src =
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad S være et heltal.\n"
+        "    Samtidig for hver J fra 1 til 100.\n"
+        "    Goddag.\n"
+        "        Lad K være et heltal.\n"
+        "        Imens K er mindre end J.\n"
+        "        Goddag.\n"
+        "            Læg K sammen med 1, og gem det i K.\n"
+        "        Farvel.\n"
+        "        Print K.\n"
+        "        Læg S sammen med K, og gem det i S.\n"
+        "    Farvel.\n"
+        "    Print S.\n"
+        "Farvel.\n";
+
+    static char *forever_pfor_src =
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Samtidig for hver J fra 1 til 8.\n"
+        "    Goddag.\n"
+        "        Lad K være et heltal.\n"
+        "        Imens sand.\n"
+        "        Goddag.\n"
+        "            Læg K sammen med 1, og gem det i K.\n"
+        "        Farvel.\n"
+        "    Farvel.\n"
+        "Farvel.\n";
+
+    static char *recursive_src =
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Dyk 1.\n"
+        "Farvel.\n"
+        "\n"
+        "Offentlig Funktion Dyk (A som heltal) tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad L være en liste af 100 heltal.\n"
+        "    Dyk A.\n"
+        "Farvel.\n";
+
+    test_ctx ctx = { 0 };
+    ctx.name = str("Scheduler");
+    test_ctx(&ctx) {
+        dk_lib_program *counting     = dk_lib_compile(str_from_cstr(counting_src), 0, null);
+        dk_lib_program *forever      = dk_lib_compile(str_from_cstr(forever_src), 0, null);
+        dk_lib_program *recursive    = dk_lib_compile(str_from_cstr(recursive_src), 0, null);
+        dk_lib_program *pfor         = dk_lib_compile(str_from_cstr(pfor_src), 0, null);
+        dk_lib_program *forever_pfor = dk_lib_compile(str_from_cstr(forever_pfor_src), 0, null);
+        dk_input no_input            = dk_input_from_str(str(""));
+        str expect_output            = dk_run_program(counting->program, &no_input, null, test_arena());
+
+        // NOTE(rune): Slicing must not change what a program does.
+        test_scope("many instances round-robin") {
+            dk_sched sched = { 0 };
+            dk_sched_init(&sched, 50);
+
+            dk_sched_instance *instances[200];
+            for_n (i64, i, countof(instances)) {
+                instances[i] = dk_sched_spawn(&sched, &counting->program, dk_lib_entry_func(counting), null, 0, no_input);
+            }
+            dk_sched_run(&sched, jobs);
+
+            bool all_eq = true;
+            bool all_sliced = true;
+            for_n (i64, i, countof(instances)) {
+                all_eq     &= instances[i]->vm.status == DK_VM_STATUS_DONE && str_eq(instances[i]->output, expect_output);
+                all_sliced &= instances[i]->slice_count > 1;
+            }
+            test_assert(loc(), all_eq);
+            test_assert(loc(), all_sliced);
+            test_assert_eq(loc(), sched.unfinished, 0);
+            dk_sched_destroy(&sched);
+        }
+
+        test_scope("fuel quota") {
+            dk_sched sched = { 0 };
+            dk_sched_init(&sched, 0);
+
+            dk_sched_instance *runaway = dk_sched_spawn(&sched, &forever->program, dk_lib_entry_func(forever), null, 0, no_input);
+            dk_sched_instance *normal  = dk_sched_spawn(&sched, &counting->program, dk_lib_entry_func(counting), null, 0, no_input);
+            runaway->fuel_quota = 100000;
+            dk_sched_run(&sched, jobs);
+
+            test_assert_eq(loc(), runaway->vm.status, DK_VM_STATUS_ERROR);
+            test_assert_eq(loc(), runaway->fuel_used, 100000);
+            test_assert_eq(loc(), runaway->output, str("Runtime error: Fuel quota of 100000 exceeded.\n"));
+            test_assert_eq(loc(), normal->vm.status, DK_VM_STATUS_DONE);
+            test_assert_eq(loc(), normal->output, expect_output);
+            dk_sched_destroy(&sched);
+        }
+
+        test_scope("memory quota") {
+            dk_sched sched = { 0 };
+            dk_sched_init(&sched, 0);
+
+            dk_sched_instance *instance = dk_sched_spawn(&sched, &recursive->program, dk_lib_entry_func(recursive), null, 0, no_input);
+            instance->memory_quota = megabytes(1);
+            dk_sched_run(&sched, jobs);
+
+            test_assert_eq(loc(), instance->vm.status, DK_VM_STATUS_ERROR);
+            test_assert_eq(loc(), instance->output, str("Runtime error: Memory quota of 1048576 bytes exceeded.\n"));
+            dk_sched_destroy(&sched);
+        }
+
+        test_scope("resume") {
+            dk_vm vm = { 0 };
+            str_list output = { 0 };
+            dk_vm_start(&vm, &counting->program, dk_lib_entry_func(counting), null, 0);
+
+            i64 slices = 0;
+            while (dk_vm_resume(&vm, 1, &no_input, &output, test_arena()) == DK_VM_STATUS_RUNNING) {
+                slices++;
+            }
+            test_assert_eq(loc(), vm.status, DK_VM_STATUS_DONE);
+            test_assert_eq(loc(), str_list_concat(&output, test_arena()), expect_output);
+            test_assert(loc(), slices > 1000);
+            dk_vm_destroy(&vm);
+        }
+
+        // NOTE(rune): The chunks of a Samtidig loop run on the fuel of the caller, so the loop is paused with it.
+        test_scope("resume samtidig") {
+            dk_vm vm = { 0 };
+            vm.jobs = jobs;
+            str_list output = { 0 };
+            dk_vm_start(&vm, &pfor->program, dk_lib_entry_func(pfor), null, 0);
+
+            i64 slices = 0;
+            while (dk_vm_resume(&vm, 10, &no_input, &output, test_arena()) == DK_VM_STATUS_RUNNING) {
+                slices++;
+            }
+            test_assert_eq(loc(), vm.status, DK_VM_STATUS_DONE);
+            test_assert_eq(loc(), str_list_concat(&output, test_arena()), dk_run_program(pfor->program, &no_input, null, test_arena()));
+            test_assert(loc(), slices > 100);
+            dk_vm_destroy(&vm);
+        }
+
+        test_scope("fuel quota samtidig") {
+            dk_sched sched = { 0 };
+            dk_sched_init(&sched, 0);
+
+            dk_sched_instance *runaway = dk_sched_spawn(&sched, &forever_pfor->program, dk_lib_entry_func(forever_pfor), null, 0, no_input);
+            runaway->fuel_quota = 100000;
+            dk_sched_run(&sched, jobs);
+
+            test_assert_eq(loc(), runaway->vm.status, DK_VM_STATUS_ERROR);
+            test_assert_eq(loc(), runaway->fuel_used, 100000);
+            test_assert_eq(loc(), runaway->output, str("Runtime error: Fuel quota of 100000 exceeded.\n"));
+            dk_sched_destroy(&sched);
+        }
+
+        dk_lib_program_destroy(counting);
+        dk_lib_program_destroy(forever);
+        dk_lib_program_destroy(recursive);
+        dk_lib_program_destroy(pfor);
+        dk_lib_program_destroy(forever_pfor);
+    }
+}
+
+static void dk_test_serve_thread_proc(void *param) {
+    dk_serve_run(param);
+}
+
+static void dk_run_test_serve(job_system *jobs) {
+#if !_WIN32
+    static char *sum_src =
+        "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Læg (læs heltal) sammen med (læs heltal), og print det.\n"
+        "Farvel.\n";
+
+    test_ctx ctx = { 0 };
+    ctx.name = str("Job server");
+    test_ctx(&ctx) {
+        str socket_path = arena_print(test_arena(), "/tmp/dansk_test_%.sock", i64(getpid()));
+        dk_serve_server server = { 0 };
+        bool started = dk_serve_start(&server, socket_path, jobs);
+        os_handle thread = { 0 };
+        if (started) {
+            thread = os_thread_create(dk_test_serve_thread_proc, &server);
+        }
+
+        test_scope("start") {
+            test_assert(loc(), started);
+        }
+
+        if (started) {
+            test_scope("run and cache") {
+                for_n (i64, i, 3) {
+                    dk_serve_response_header response = { 0 };
+                    str output = { 0 };
+                    str input  = arena_print(test_arena(), "% 2", i);
+                    bool ok = dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_RUN, 0, str_from_cstr(sum_src), input, &response, &output, test_arena());
+                    test_assert(loc(), ok);
+                    test_assert_eq(loc(), response.status, DK_SERVE_STATUS_OK);
+                    test_assert_eq(loc(), response.cached, u32(i > 0));
+                    test_assert_eq(loc(), output, arena_print(test_arena(), "%\n", i + 2));
+                }
+            }
+
+            test_scope("build flags are part of the key") {
+                dk_serve_response_header response = { 0 };
+                str output = { 0 };
+                dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_RUN, DK_BUILD_FLAG_UNCHECKED, str_from_cstr(sum_src), str("1 1"), &response, &output, test_arena());
+                test_assert_eq(loc(), response.cached, 0);
+                test_assert_eq(loc(), output, str("2\n"));
+            }
+
+            test_scope("compilation error") {
+                for_n (i64, i, 2) {
+                    dk_serve_response_header response = { 0 };
+                    str output = { 0 };
+                    dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_RUN, 0, str("Offentlig Funktion"), str(""), &response, &output, test_arena());
+                    test_assert_eq(loc(), response.status, DK_SERVE_STATUS_COMPILE_ERROR);
+                    test_assert_eq(loc(), response.cached, 0);
+                    test_assert(loc(), output.len > 0);
+                }
+            }
+
+            test_scope("runtime error") {
+                dk_serve_response_header response = { 0 };
+                str output = { 0 };
+                dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_RUN, 0, str_from_cstr(sum_src), str("1"), &response, &output, test_arena());
+                test_assert_eq(loc(), response.status, DK_SERVE_STATUS_RUNTIME_ERROR);
+                test_assert_eq(loc(), output, str("Runtime error: No more input.\n"));
+            }
+
+            test_scope("cache is bounded") {
+                os_mutex_scope(server.mutex) {
+                    server.cache_capacity = 1;
+                }
+
+                static char *double_src =
+                    "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+                    "Goddag.\n"
+                    "    Gang (læs heltal) med 2, og print det.\n"
+                    "Farvel.\n";
+
+                str srcs[]    = { str_from_cstr(double_src), str_from_cstr(sum_src), str_from_cstr(sum_src) };
+                str inputs[]  = { str("4"), str("1 2"), str("2 2") };
+                str outputs[] = { str("8\n"), str("3\n"), str("4\n") };
+                u32 cached[]  = { 0, 0, 1 };
+                for_n (i64, i, countof(srcs)) {
+                    dk_serve_response_header response = { 0 };
+                    str output = { 0 };
+                    dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_RUN, 0, srcs[i], inputs[i], &response, &output, test_arena());
+                    test_assert_eq(loc(), response.cached, cached[i]);
+                    test_assert_eq(loc(), output, outputs[i]);
+                }
+
+                os_mutex_scope(server.mutex) {
+                    test_assert_eq(loc(), server.cache_count, 1);
+                }
+            }
+
+            // NOTE(rune): Lengths which only fit in a u64 when they wrap around must be rejected as too large.
+            test_scope("malformed header") {
+                struct sockaddr_un addr = { 0 };
+                addr.sun_family = AF_UNIX;
+                memcpy(addr.sun_path, socket_path.v, socket_path.len);
+
+                int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+                test_assert(loc(), connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+                dk_serve_request_header request = { 0 };
+                request.kind      = DK_SERVE_REQUEST_KIND_RUN;
+                request.src_len   = U64_MAX;
+                request.input_len = 1;
+                test_assert(loc(), dk_serve_write_all(fd, &request, sizeof(request)));
+
+                dk_serve_response_header response = { 0 };
+                test_assert(loc(), dk_serve_read_all(fd, &response, sizeof(response)));
+                test_assert_eq(loc(), response.status, DK_SERVE_STATUS_BAD_REQUEST);
+                test_assert_eq(loc(), response.output_len, 0);
+                close(fd);
+            }
+
+            test_scope("stop") {
+                dk_serve_response_header response = { 0 };
+                str output = { 0 };
+                test_assert(loc(), dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_STOP, 0, str(""), str(""), &response, &output, test_arena()));
+                os_thread_join(thread);
+                test_assert_eq(loc(), server.request_count, 10);
+                test_assert_eq(loc(), server.cache_hit_count, 4);
+            }
+        }
+
+        dk_serve_destroy(&server);
+    }
+#else
+    unused(jobs);
+#endif
+}
+
+static void dk_run_tests(i64 thread_count) {
+    // NOTE(rune): Sections of test files only run in parallel when more than one thread is requested, but the
+    // parallel compilation tests always use the job system.
+    job_system *jobs = job_system_create(thread_count > 1 ? thread_count : 0);
+
     dk_run_test_numbers();
-    dk_run_test_file(str("dk_tests.dk"), str(""));
+    dk_run_test_bulk_kernels();
+    dk_run_test_map();
+    dk_run_test_input();
+    dk_run_test_build_modes();
+    dk_run_test_jobs();
+    dk_run_test_parallel_compile(jobs);
+    dk_run_test_embedding();
+    dk_run_test_lanes();
+    dk_run_test_sched(jobs);
+    dk_run_test_serve(jobs);
+    dk_run_test_file(str("dk_tests.dk"), str(""), thread_count > 1 ? jobs : null);
+
+    job_system_destroy(jobs);
+}
+
+////////////////////////////////////////////////////////////////
+// rune: Benchmarks
+
+static f64 dk_bench_program(str src, str *output, arena *arena) {
+    dk_err_sink err = { 0 };
+    dk_ctx ctx = { &err, arena };
+    dk_program program = dk_program_from_str(src, DK_BUILD_FLAG_UNCHECKED, &ctx);
+    if (err.err_list.count > 0) {
+        dk_print_err(err.err_list.first, arena);
+        return 0;
+    }
+
+    u64 t_begin = os_get_performance_timestamp();
+    dk_input input = dk_input_from_str(str(""));
+    *output = str_trim(dk_run_program(program, &input, null, arena));
+    u64 t_end = os_get_performance_timestamp();
+    return os_get_millis_between(t_begin, t_end);
+}
+
+static void dk_run_bench(void) {
+    // NOTE(rune): Compares an interpreted "Imens" loop against the equivalent bulk operation, with each kernel isa.
+    // Both programs fill the lists with the same interpreted loop first, so the time of a program which only
+    // fills the lists is subtracted from both timings.
+    typedef struct dk_bench dk_bench;
+    struct dk_bench {
+        char *name;
+        char *loop;
+        char *bulk;
+    };
+
+    static char *prelude =
+        "Offentlig funktion hovedsagelig tilbagegiver heltal.\n"
+        "Goddag.\n"
+        "    Lad A være en liste af 10000 heltal.\n"
+        "    Lad F være en liste af 10000 flyder.\n"
+        "    Lad K være et heltal.\n"
+        "    Lad R være et heltal.\n"
+        "    Lad S være et heltal.\n"
+        "    Lad X være en flyder.\n"
+        "    Imens K er mindre end 10000.\n"
+        "    Goddag.\n"
+        "        Gem K på plads K i A.\n"
+        "        Støb K som flyder, og gem det på plads K i F.\n"
+        "        Læg K sammen med 1, og gem det i K.\n"
+        "    Farvel.\n"
+        "    Imens R er mindre end 100.\n"
+        "    Goddag.\n";
+
+    static char *postlude =
+        "        Læg R sammen med 1, og gem det i R.\n"
+        "    Farvel.\n"
+        "    Print S.\n"
+        "    Print X.\n"
+        "Farvel.\n";
+
+    static readonly dk_bench benches[] = {
+        {
+            "sum heltal",
+            "        Gem 0 i K.\n"
+            "        Imens K er mindre end 10000.\n"
+            "        Goddag.\n"
+            "            Læg (A på plads K) sammen med S, og gem det i S.\n"
+            "            Læg K sammen med 1, og gem det i K.\n"
+            "        Farvel.\n",
+            "        Læg (summen af A) sammen med S, og gem det i S.\n",
+        },
+        {
+            "dot flyder",
+            "        Gem 0 i K.\n"
+            "        Imens K er mindre end 10000.\n"
+            "        Goddag.\n"
+            "            Gang (F på plads K) med (F på plads K), og læg det sammen med X, og gem det i X.\n"
+            "            Læg K sammen med 1, og gem det i K.\n"
+            "        Farvel.\n",
+            "        Læg (prikproduktet af F og F) sammen med X, og gem det i X.\n",
+        },
+        {
+            "scale flyder",
+            "        Gem 0 i K.\n"
+            "        Imens K er mindre end 10000.\n"
+            "        Goddag.\n"
+            "            Gang (F på plads K) med 1,0, og gem det på plads K i F.\n"
+            "            Læg K sammen med 1, og gem det i K.\n"
+            "        Farvel.\n",
+            "        Skaler F med 1,0.\n",
+        },
+    };
+
+    arena *arena = arena_create_default();
+    dk_bulk_isa max_isa = dk_bulk_detect_isa();
+
+    str base_src    = arena_print(arena, "%%", prelude, postlude);
+    str base_output = { 0 };
+    f64 base_ms     = dk_bench_program(base_src, &base_output, arena);
+
+    println("Bulk operations, 100 x 10000 elements (detected isa: %, baseline % ms)", dk_bulk_isa_names[max_isa], base_ms);
+    for_sarray (dk_bench, bench, benches) {
+        str loop_src = arena_print(arena, "%%%", prelude, bench->loop, postlude);
+        str bulk_src = arena_print(arena, "%%%", prelude, bench->bulk, postlude);
+
+        str loop_output = { 0 };
+        f64 loop_ms = dk_bench_program(loop_src, &loop_output, arena) - base_ms;
+        println("    %\tloop     \t% ms", bench->name, loop_ms);
+
+        for (dk_bulk_isa isa = DK_BULK_ISA_SCALAR; isa <= max_isa; isa++) {
+            dk_bulk_select_isa(isa);
+
+            str bulk_output = { 0 };
+            f64 bulk_ms = max(dk_bench_program(bulk_src, &bulk_output, arena) - base_ms, 0.001);
+            println("    %\tbulk %\t% ms\t(%x)%",
+                    bench->name, dk_bulk_isa_names[isa], bulk_ms, loop_ms / bulk_ms,
+                    str_eq(loop_output, bulk_output) ? "" : "  OUTPUT MISMATCH");
+        }
+    }
+
+    dk_bulk_select_isa(max_isa);
+
+    // NOTE(rune): Compares calling a function once per argument with dk_lib_call(), against calling it for
+    // DK_LANES_MAX arguments at a time in lockstep, with each kernel isa.
+    {
+        static char *lanes_src =
+            "Offentlig Funktion Hovedsagelig tilbagegiver heltal.\n"
+            "Goddag.\n"
+            "    Tilbagegiv 0.\n"
+            "Farvel.\n"
+            "\n"
+            "Offentlig Funktion Polynomium (X som heltal) tilbagegiver heltal.\n"
+            "Goddag.\n"
+            "    Lad K være et heltal.\n"
+            "    Lad S være et heltal.\n"
+            "    Imens K er mindre end 64.\n"
+            "    Goddag.\n"
+            "        Gang S med X, og gem det i S.\n"
+            "        Læg S sammen med K, og gem det i S.\n"
+            "        Bitvis S eksklusivt eller (skub S til højre med 7), og gem det i S.\n"
+            "        Læg K sammen med 1, og gem det i K.\n"
+            "    Farvel.\n"
+            "    Tilbagegiv S.\n"
+            "Farvel.\n";
+
+        i64 call_count = 80000;
+        dk_lib_program *program = dk_lib_compile(str_from_cstr(lanes_src), DK_BUILD_FLAG_UNCHECKED, null);
+        dk_bc_symbol *func      = dk_lib_find_func(program, str("Polynomium <heltal>"));
+        dk_vm *vm               = dk_lib_vm_create();
+        struct arena *call_arena = arena_create_default();
+
+        u64 expect_sum = 0;
+        u64 t_begin = os_get_performance_timestamp();
+        for_n (i64, i, call_count) {
+            u64 args[] = { u64(i) };
+            dk_lib_result result = dk_lib_call(vm, program, func, args, 1, null, call_arena);
+            expect_sum += result.values[0];
+            arena_reset(call_arena);
+        }
+        f64 scalar_ms = os_get_millis_between(t_begin, os_get_performance_timestamp());
+        println("Lockstep, % calls", call_count);
+        println("    one at a time\t% ms", scalar_ms);
+
+        dk_lanes lanes = { 0 };
+        dk_lanes_init(&lanes);
+        for (dk_bulk_isa isa = DK_BULK_ISA_SCALAR; isa <= max_isa; isa++) {
+            dk_bulk_select_isa(isa);
+
+            u64 actual_sum = 0;
+            t_begin = os_get_performance_timestamp();
+            for (i64 i = 0; i < call_count; i += DK_LANES_MAX) {
+                u64 args[DK_LANES_MAX];
+                for_n (i64, lane, DK_LANES_MAX) {
+                    args[lane] = u64(i + lane);
+                }
+
+                dk_lib_result results[DK_LANES_MAX];
+                dk_lanes_call(&lanes, program, func, args, 1, DK_LANES_MAX, results, call_arena);
+                for_n (i64, lane, DK_LANES_MAX) {
+                    actual_sum += results[lane].values[0];
+                }
+                arena_reset(call_arena);
+            }
+            f64 lanes_ms = max(os_get_millis_between(t_begin, os_get_performance_timestamp()), 0.001);
+            println("    lockstep %\t% ms\t(%x)%", dk_bulk_isa_names[isa], lanes_ms, scalar_ms / lanes_ms,
+                    actual_sum == expect_sum ? "" : "  OUTPUT MISMATCH");
+        }
+
+        dk_bulk_select_isa(max_isa);
+        dk_lanes_destroy(&lanes);
+        arena_destroy(call_arena);
+        dk_lib_vm_destroy(vm);
+        dk_lib_program_destroy(program);
+    }
+
+    arena_destroy(arena);
 }
@@ -7,6 +7,7 @@ struct dk_test {
     str name;
     str input;
     str output;
+    str input_data; // NOTE(rune): Optional section after the expected output, which is read by the input intrinsics.
     dk_test *next;
 };
 
@@ -22,6 +23,34 @@ static dk_tests dk_tests_from_file(str file_path, arena *arena);
 ////////////////////////////////////////////////////////////////
 // rune: Runner
 
-static void dk_run_test_file(str file_name, str filter);
+// NOTE(rune): Tests run on the job system when one is given. Each test builds and runs its program in its own
+// arena, and results are reported in file order, when all tests are done.
+typedef struct dk_test_job dk_test_job;
+struct dk_test_job {
+    dk_test *test;
+    job_system *jobs;
+    str actual_output;
+    f64 duration;
+};
+
+static str  dk_run_test_program(dk_test *test, job_system *jobs, arena *arena);
+static void dk_test_job_proc(void *param);
+static void dk_run_test_file(str file_name, str filter, job_system *jobs);
 static void dk_run_test_numbers(void);
-static void dk_run_tests(void);
\ No newline at end of file
+static void dk_run_test_bulk_kernels(void);
+static void dk_run_test_map(void);
+static void dk_run_test_input(void);
+static void dk_run_test_build_modes(void);
+static void dk_run_test_jobs(void);
+static void dk_run_test_parallel_compile(job_system *jobs);
+static void dk_run_test_embedding(void);
+static void dk_run_test_lanes(void);
+static void dk_run_test_sched(job_system *jobs);
+static void dk_run_test_serve(job_system *jobs);
+static void dk_run_tests(i64 thread_count);
+
+////////////////////////////////////////////////////////////////
+// rune: Benchmarks
+
+static f64  dk_bench_program(str src, str *output, arena *arena);
+static void dk_run_bench(void);
\ No newline at end of file
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////
+// rune: Embedding api
+
+static dk_lib_program *dk_lib_compile(str src, dk_build_flags flags, job_system *jobs) {
+    arena *arena = arena_create_default();
+    dk_lib_program *program = arena_push_struct(arena, dk_lib_program);
+    program->arena = arena;
+
+    // NOTE(rune): Text literals and symbol names point into the source, so it must live as long as the program.
+    program->src = arena_copy_str(arena, src);
+
+    dk_err_sink err = { 0 };
+    dk_ctx ctx = { &err, arena, jobs };
+    program->program = dk_program_from_str(program->src, flags, &ctx);
+
+    if (err.err_list.count > 0) {
+        dk_err *first = err.err_list.first;
+        program->err = arena_print(arena, "Compilation error at line %, column %: %", first->loc.row + 1, first->loc.col + 1, first->msg);
+    } else {
+        // NOTE(rune): Checked once here, since the whole body is scanned, and the program is read-only afterwards.
+        program->lockstep = dk_lanes_supported(&program->program);
+    }
+
+    return program;
+}
+
+static void dk_lib_program_destroy(dk_lib_program *program) {
+    heap_free(program->program.head.data);
+    heap_free(program->program.body.data);
+    heap_free(program->program.data.data);
+    arena_destroy(program->arena);
+}
+
+static dk_bc_symbol *dk_lib_find_func(dk_lib_program *program, str signature) {
+    dk_bc_symbol *ret = null;
+    if (program->err.len == 0) {
+        dk_bc_symbol *symbols = (dk_bc_symbol *)program->program.head.data;
+        i64 symbol_count      = program->program.head.size / sizeof(dk_bc_symbol);
+        for_n (i64, i, symbol_count) {
+            if (str_eq_nocase(symbols[i].signature, signature)) {
+                ret = &symbols[i];
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
+static dk_bc_symbol *dk_lib_entry_func(dk_lib_program *program) {
+    dk_bc_symbol *ret = null;
+    if (program->err.len == 0) {
+        dk_bc_symbol *symbols = (dk_bc_symbol *)program->program.head.data;
+        i64 symbol_count      = program->program.head.size / sizeof(dk_bc_symbol);
+        for_n (i64, i, symbol_count) {
+            if (symbols[i].pos == 0) {
+                ret = &symbols[i];
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
+static dk_vm *dk_lib_vm_create(void) {
+    dk_vm *vm = heap_alloc(sizeof(dk_vm));
+    mem_zero_struct(vm);
+    return vm;
+}
+
+static void dk_lib_vm_destroy(dk_vm *vm) {
+    dk_vm_destroy(vm);
+    heap_free(vm);
+}
+
+static dk_lib_result dk_lib_call(dk_vm *vm, dk_lib_program *program, dk_bc_symbol *func, u64 *args, i64 arg_count,
+                                 dk_input *input, arena *output_arena) {
+    dk_lib_result result = { 0 };
+    str_list output_list = { 0 };
+
+    if (program->err.len > 0) {
+        str_list_push(&output_list, output_arena, program->err);
+    } else if (func == null) {
+        str_list_push(&output_list, output_arena, str("Runtime error: No function to call.\n"));
+    } else if (arg_count != func->arg_slots) {
+        str_list_push_fmt(&output_list, output_arena, "Runtime error: % takes % argument slots, but got %.\n", func->signature, func->arg_slots, arg_count);
+    } else {
+        dk_input empty_input = dk_input_from_str(str(""));
+        if (input == null) {
+            input = &empty_input;
+        }
+
+        result.ok = dk_vm_call(vm, &program->program, func, args, arg_count, input, &output_list, output_arena);
+        if (result.ok) {
+            result.values      = (u64 *)vm->data_stack.data;
+            result.value_count = vm->data_stack.size / 8;
+            if (result.value_count != func->ret_slots) {
+                str_list_push_fmt(&output_list, output_arena, "Invalid stack size on exit. Was % but expected %.", vm->data_stack.size, func->ret_slots * 8);
+                result.ok = false;
+            }
+        }
+    }
+
+    result.output = str_list_concat(&output_list, output_arena);
+    return result;
+}
+
+static bool dk_lib_args_from_str(dk_bc_symbol *func, str s, u64 *args, i64 arg_cap, i64 *arg_count) {
+    dk_input input = dk_input_from_str(s);
+    i64 count = 0;
+
+    for_n (i64, i, func->arg_count) {
+        dk_type *type = func->arg_types[i];
+        str token     = dk_input_next_token(&input);
+        if (token.len == 0 || count + 2 > arg_cap) {
+            return false;
+        }
+
+        if (dk_type_is_int(type)) {
+            // NOTE(rune): Narrow values would wrap around when stored, so e.g. 1000 for a byte is rejected.
+            i64 value = 0;
+            if (!dk_parse_int(token, &value)) return false;
+            if (value < dk_int_type_min(type) || value > dk_int_type_max(type)) return false;
+            args[count++] = u64(value);
+        } else if (str_eq(type->name, str("flyder"))) {
+            f64 value = 0;
+            if (!dk_parse_float(token, &value)) return false;
+            args[count++] = u64_from_f64(value);
+        } else if (str_eq(type->name, str("påstand"))) {
+            if      (str_eq_nocase(token, str("sand")) || str_eq_nocase(token, str("sandt"))) args[count++] = 1;
+            else if (str_eq_nocase(token, str("falsk")))                                     args[count++] = 0;
+            else return false;
+        } else if (str_eq(type->name, str("tekst"))) {
+            args[count++] = u64(token.v);
+            args[count++] = u64(token.len);
+        } else {
+            return false;
+        }
+    }
+
+    *arg_count = count;
+    return !dk_input_has_more(&input);
+}
+
+static str dk_lib_str_from_values(dk_bc_symbol *func, u64 *values, i64 value_count, arena *arena) {
+    str ret = { 0 };
+    if (value_count == 1 && str_eq(func->type_name, str("flyder"))) {
+        ret = arena_print(arena, "%", f64_from_u64(values[0]));
+    } else if (value_count == 1 && str_eq(func->type_name, str("påstand"))) {
+        ret = values[0] ? str("sand") : str("falsk");
+    } else if (value_count == 2 && str_eq(func->type_name, str("tekst"))) {
+        ret = str_make((u8 *)values[0], i64(values[1]));
+    } else {
+        // NOTE(rune): Integers, and one integer per slot for anything else.
+        str_list list = { 0 };
+        for_n (i64, i, value_count) {
+            str_list_push_fmt(&list, arena, "%", i64(values[i]));
+        }
+        ret = str_list_concat_sep(&list, arena, str(" "));
+    }
+    return ret;
+}
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////
+// rune: Embedding api
+
+// NOTE(rune): For hosts which run dk programs in-process. A program is compiled once, and is read-only
+// afterwards, so any number of threads can call functions in it. Each thread calls through its own dk_vm, which
+// keeps its stacks between calls, so once they have grown, a call is just execution.
+//
+//     dk_lib_program *program = dk_lib_compile(src, 0, null);
+//     dk_bc_symbol *func      = dk_lib_find_func(program, str("Sæt <heltal> i anden"));
+//     dk_vm *vm               = dk_lib_vm_create();
+//     u64 args[]              = { 42 };
+//     dk_lib_result result    = dk_lib_call(vm, program, func, args, countof(args), null, arena);
+//
+// Arguments and return values are passed as slots, like on the data stack of the vm, so a flyder is passed with
+// u64_from_f64(), a påstand as 0 or 1, and a tekst as two slots holding the pointer and the length.
+
+typedef struct dk_lib_program dk_lib_program;
+struct dk_lib_program {
+    arena *arena;       // NOTE(rune): Owns the source and strings, which the bytecode points into.
+    str src;
+    dk_program program;
+    str err;            // NOTE(rune): First compilation error, or empty.
+    bool lockstep;      // NOTE(rune): Whether dk_lanes_call() can run the program in lockstep.
+};
+
+typedef struct dk_lib_result dk_lib_result;
+struct dk_lib_result {
+    bool ok;
+    u64 *values;        // NOTE(rune): Return value slots. Points into the vm, so only valid until its next call.
+    i64 value_count;
+    str output;         // NOTE(rune): Printed output, followed by the runtime error if not ok.
+};
+
+// NOTE(rune): Always returns a program, which must be destroyed, even if it failed to compile.
+static dk_lib_program *dk_lib_compile(str src, dk_build_flags flags, job_system *jobs);
+static void            dk_lib_program_destroy(dk_lib_program *program);
+
+// NOTE(rune): Looks a user function up by its signature, where arguments are written as their type in angle
+// brackets e.g. "Ekko og inkrementer <heltal>". Case-insensitive like the language. Returns null if not found.
+static dk_bc_symbol *  dk_lib_find_func(dk_lib_program *program, str signature);
+static dk_bc_symbol *  dk_lib_entry_func(dk_lib_program *program);
+
+// NOTE(rune): Samtidig loops run their chunks on vm->jobs, which may be set by the host. If null, the chunks run
+// one after another on the calling thread.
+static dk_vm *         dk_lib_vm_create(void);
+static void            dk_lib_vm_destroy(dk_vm *vm);
+
+// NOTE(rune): Globals start out with their initial values on each call. Input is optional.
+static dk_lib_result   dk_lib_call(dk_vm *vm, dk_lib_program *program, dk_bc_symbol *func, u64 *args, i64 arg_count,
+                                   dk_input *input, arena *output_arena);
+
+// NOTE(rune): Conversion between text and slots, for hosts which read arguments from text, e.g. dansk batch.
+// Arguments are whitespace separated, and tekst arguments point into the given string. Only basic types are
+// supported, integers must fit in their type, and values are formatted like Print formats them.
+static bool            dk_lib_args_from_str(dk_bc_symbol *func, str s, u64 *args, i64 arg_cap, i64 *arg_count);
+static str             dk_lib_str_from_values(dk_bc_symbol *func, u64 *values, i64 value_count, arena *arena);
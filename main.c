@@ -2,8 +2,22 @@
 // rune: Source files
 
 #include "base/base.h"
+#include "dk_bulk.h"
+#include "dk_bulk.c"
+#include "dk_map.h"
+#include "dk_map.c"
+#include "dk_input.h"
+#include "dk_input.c"
 #include "dk.h"
 #include "dk.c"
+#include "libdansk.h"
+#include "dk_lanes.h"
+#include "libdansk.c"
+#include "dk_lanes.c"
+#include "dk_sched.h"
+#include "dk_sched.c"
+#include "dk_serve.h"
+#include "dk_serve.c"
 #include "dk_tests.h"
 #include "dk_tests.c"
 
@@ -36,7 +50,8 @@ static char *dk_cmdline_pop(dk_cmdline *cmd) {
 
 static bool dk_cmdline_subcommand(dk_cmdline *cmd, char *look_for) {
     bool ret = false;
-    if (strcmp(dk_cmdline_peek(cmd), look_for) == 0) {
+    char *arg = dk_cmdline_peek(cmd);
+    if (arg && strcmp(arg, look_for) == 0) {
         dk_cmdline_pop(cmd);
         ret = true;
     }
@@ -62,6 +77,129 @@ static bool dk_cmdline_read_file(dk_cmdline *cmd, str *file_name, str *file_data
     return ret;
 }
 
+////////////////////////////////////////////////////////////////
+// rune: Batch mode
+
+#define DK_BATCH_OUTPUT_SIZE kilobytes(256)
+#define DK_BATCH_MAX_ARGS    64
+
+static void dk_batch_write(buf *out, str s) {
+    if (out->len + s.len > out->cap) {
+        fwrite(out->v, 1, out->len, stdout);
+        buf_reset(out);
+    }
+
+    if (s.len > out->cap) {
+        fwrite(s.v, 1, s.len, stdout);
+    } else {
+        buf_append_str(out, s);
+    }
+}
+
+// NOTE(rune): Calls the entry function for up to DK_LANES_MAX pending records, and writes their results in order.
+static void dk_batch_flush(dk_lanes *lanes, dk_lib_program *program, dk_bc_symbol *func, u64 *args, i64 arg_count,
+                           i64 pending_count, buf *out, i64 *failed_count, arena *arena) {
+    dk_lib_result results[DK_LANES_MAX];
+    dk_lanes_call(lanes, program, func, args, arg_count, pending_count, results, arena);
+    for_n (i64, i, pending_count) {
+        dk_batch_write(out, results[i].output);
+        if (results[i].ok) {
+            dk_batch_write(out, dk_lib_str_from_values(func, results[i].values, results[i].value_count, arena));
+            dk_batch_write(out, str("\n"));
+        } else {
+            *failed_count += 1;
+        }
+    }
+}
+
+// NOTE(rune): Compiles the program once, and calls its entry function once per line of input, with the arguments
+// parsed from the line. Blank lines are skipped. Each record writes the output of the program, followed by the
+// return value on its own line. Records are run DK_LANES_MAX at a time in lockstep, and share one arena, which
+// is reset between groups of records.
+static void dk_run_batch(str src, dk_build_flags flags, char *records_file, arena *arena) {
+    job_system *jobs        = job_system_create(0);
+    dk_lib_program *program = dk_lib_compile(src, flags, jobs);
+    job_system_destroy(jobs);
+
+    dk_bc_symbol *func = dk_lib_entry_func(program);
+    if (program->err.len > 0) {
+        println("%", program->err);
+    } else if (func == null) {
+        println("Program has no entry function.");
+    } else {
+        dk_input input = dk_input_from_stream(stdin);
+        if (records_file && !dk_input_open_file(&input, str_from_cstr(records_file))) {
+            println("Could not read file: %", str_from_cstr(records_file));
+        } else {
+            struct arena *record_arena = arena_create_default();
+            buf out              = arena_push_buf(arena, DK_BATCH_OUTPUT_SIZE);
+            i64 record_count     = 0;
+            i64 failed_count     = 0;
+            u64 timestamp_begin  = os_get_performance_timestamp();
+
+            dk_lanes lanes = { 0 };
+            dk_lanes_init(&lanes);
+
+            // rune: Arguments of the records which have not been run yet.
+            u64 args[DK_LANES_MAX * DK_BATCH_MAX_ARGS];
+            i64 arg_count     = 0;
+            i64 pending_count = 0;
+
+            str line = { 0 };
+            while (dk_input_next_line(&input, &line)) {
+                if (str_trim(line).len == 0) {
+                    continue;
+                }
+
+                // NOTE(rune): Text arguments point into the line, which is only valid until the next line is read.
+                if (pending_count == 0) {
+                    arena_reset(record_arena);
+                }
+                line = arena_copy_str(record_arena, line);
+                record_count++;
+
+                u64 *record_args = args + pending_count * func->arg_slots;
+                if (!dk_lib_args_from_str(func, line, record_args, DK_BATCH_MAX_ARGS, &arg_count)) {
+                    // NOTE(rune): Records before this one are written first, so output stays in order.
+                    if (pending_count > 0) {
+                        dk_batch_flush(&lanes, program, func, args, func->arg_slots, pending_count, &out, &failed_count, record_arena);
+                        pending_count = 0;
+                    }
+                    dk_batch_write(&out, arena_print(record_arena, "Invalid record %. Expected arguments for %.\n", record_count, func->signature));
+                    failed_count++;
+                    continue;
+                }
+
+                pending_count++;
+                if (pending_count == DK_LANES_MAX) {
+                    dk_batch_flush(&lanes, program, func, args, func->arg_slots, pending_count, &out, &failed_count, record_arena);
+                    pending_count = 0;
+                }
+            }
+
+            if (pending_count > 0) {
+                dk_batch_flush(&lanes, program, func, args, func->arg_slots, pending_count, &out, &failed_count, record_arena);
+            }
+
+            fwrite(out.v, 1, out.len, stdout);
+            fflush(stdout);
+
+            // NOTE(rune): Reported on stderr, so it can't be mixed up with the results.
+            u64 timestamp_end = os_get_performance_timestamp();
+            f64 millis        = os_get_millis_between(timestamp_begin, timestamp_end);
+            str report        = arena_print(arena, "% records (% failed) in % ms, % records/sec\n",
+                                            record_count, failed_count, millis, f64(record_count) / max(millis, 0.001) * 1000.0);
+            fwrite(report.v, 1, report.len, stderr);
+
+            arena_destroy(record_arena);
+            dk_lanes_destroy(&lanes);
+        }
+        dk_input_close(&input);
+    }
+
+    dk_lib_program_destroy(program);
+}
+
 int main(int argc, char **argv) {
 #if _WIN32
     SetConsoleOutputCP(65001); // NOTE(rune): UTF8 codepage
@@ -71,10 +209,23 @@ int main(int argc, char **argv) {
         "Usage:                                                                    \n"
         "    dansk help                    Print this message                      \n"
         "    dansk run <program.dk>        Build program.dk and run in interpreter \n"
-        "    dansk test                    Run tests                               \n";
+        "    dansk run <program.dk> <file> Same, but with input read from file     \n"
+        "    dansk batch <program.dk>      Call entry function once per stdin line \n"
+        "    dansk batch <program.dk> <file> Same, but with lines read from file   \n"
+        "    dansk serve [--socket <path>] Run programs sent to a unix socket      \n"
+        "    dansk client [--socket <path>] <program.dk> [<file>]                  \n"
+        "                                  Run program.dk on a dansk serve         \n"
+        "    dansk client [--socket <path>] --stop                                 \n"
+        "                                  Stop a dansk serve                      \n"
+        "    dansk test                    Run tests                               \n"
+        "    dansk test -j <n>             Run tests on n threads (0 = all cores)  \n"
+        "    dansk bench                   Run microbenchmarks                     \n"
+        "                                                                          \n"
+        "Build options, given before <program.dk>:                                 \n"
+        "    --checked                     Trap on integer overflow (default)      \n"
+        "    --unchecked                   Integer arithmetic wraps around         \n";
 
     arena *arena = arena_create_default();
-    temp_arena = arena_create_default();
 
     if (argc == 1) {
         println("%", usage);
@@ -89,23 +240,140 @@ int main(int argc, char **argv) {
 
         // rune: run subcommand
         else if (dk_cmdline_subcommand(&cmd, "run")) {
+            dk_build_flags flags = 0;
+            while (1) {
+                if      (dk_cmdline_subcommand(&cmd, "--checked"))   flags &= ~DK_BUILD_FLAG_UNCHECKED;
+                else if (dk_cmdline_subcommand(&cmd, "--unchecked")) flags |= DK_BUILD_FLAG_UNCHECKED;
+                else break;
+            }
+
             str file_name = { 0 };
             str file_data = { 0 };
             if (dk_cmdline_read_file(&cmd, &file_name, &file_data, arena)) {
+                // NOTE(rune): Worker threads are only started if the program is large enough to be checked in parallel,
+                // or runs a Samtidig loop.
                 dk_err_sink err = { 0 };
-                dk_program program = dk_program_from_str(file_data, &err, arena);
+                dk_ctx ctx = { &err, arena, job_system_create(0) };
+                dk_program program = dk_program_from_str(file_data, flags, &ctx);
+
                 if (err.err_list.count == 0) {
-                    str output = dk_run_program(program, arena);
-                    print(output);
+                    // NOTE(rune): Input is read from the file after the program if given, or else stdin.
+                    dk_input input = dk_input_from_stream(stdin);
+                    char *input_arg = dk_cmdline_pop(&cmd);
+                    if (input_arg && !dk_input_open_file(&input, str_from_cstr(input_arg))) {
+                        println("Could not read file: %", str_from_cstr(input_arg));
+                    } else {
+                        str output = dk_run_program(program, &input, ctx.jobs, arena);
+                        print(output);
+                    }
+                    dk_input_close(&input);
                 } else {
                     dk_print_err(err.err_list.first, arena);
                 }
+
+                job_system_destroy(ctx.jobs);
+            }
+        }
+
+        // rune: batch subcommand
+        else if (dk_cmdline_subcommand(&cmd, "batch")) {
+            dk_build_flags flags = 0;
+            while (1) {
+                if      (dk_cmdline_subcommand(&cmd, "--checked"))   flags &= ~DK_BUILD_FLAG_UNCHECKED;
+                else if (dk_cmdline_subcommand(&cmd, "--unchecked")) flags |= DK_BUILD_FLAG_UNCHECKED;
+                else break;
+            }
+
+            str file_name = { 0 };
+            str file_data = { 0 };
+            if (dk_cmdline_read_file(&cmd, &file_name, &file_data, arena)) {
+                dk_run_batch(file_data, flags, dk_cmdline_pop(&cmd), arena);
+            }
+        }
+
+        // rune: serve subcommand
+        else if (dk_cmdline_subcommand(&cmd, "serve")) {
+            str socket_path = str(DK_SERVE_DEFAULT_SOCKET);
+            if (dk_cmdline_subcommand(&cmd, "--socket")) {
+                char *arg = dk_cmdline_pop(&cmd);
+                socket_path = arg ? str_from_cstr(arg) : str("");
+            }
+
+            job_system *jobs = job_system_create(0);
+            dk_serve_server server = { 0 };
+            if (dk_serve_start(&server, socket_path, jobs)) {
+                println("Listening on %", socket_path);
+                dk_serve_run(&server);
+                println("Served % requests (% cached)", server.request_count, server.cache_hit_count);
+            } else {
+                println("Could not listen on %", socket_path);
+            }
+            dk_serve_destroy(&server);
+            job_system_destroy(jobs);
+        }
+
+        // rune: client subcommand
+        else if (dk_cmdline_subcommand(&cmd, "client")) {
+            str socket_path = str(DK_SERVE_DEFAULT_SOCKET);
+            if (dk_cmdline_subcommand(&cmd, "--socket")) {
+                char *arg = dk_cmdline_pop(&cmd);
+                socket_path = arg ? str_from_cstr(arg) : str("");
+            }
+
+            dk_serve_response_header response = { 0 };
+            str output = { 0 };
+            if (dk_cmdline_subcommand(&cmd, "--stop")) {
+                if (!dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_STOP, 0, str(""), str(""), &response, &output, arena)) {
+                    println("Could not connect to %", socket_path);
+                }
+            } else {
+                dk_build_flags flags = 0;
+                while (1) {
+                    if      (dk_cmdline_subcommand(&cmd, "--checked"))   flags &= ~DK_BUILD_FLAG_UNCHECKED;
+                    else if (dk_cmdline_subcommand(&cmd, "--unchecked")) flags |= DK_BUILD_FLAG_UNCHECKED;
+                    else break;
+                }
+
+                str file_name = { 0 };
+                str file_data = { 0 };
+                if (dk_cmdline_read_file(&cmd, &file_name, &file_data, arena)) {
+                    str input = { 0 };
+                    char *input_arg = dk_cmdline_pop(&cmd);
+                    if (input_arg) {
+                        input = os_read_entire_file(str_from_cstr(input_arg), arena, null);
+                    }
+
+                    if (dk_serve_request(socket_path, DK_SERVE_REQUEST_KIND_RUN, flags, file_data, input, &response, &output, arena)) {
+                        fwrite(output.v, 1, output.len, stdout);
+                    } else {
+                        println("Could not connect to %", socket_path);
+                    }
+                }
             }
         }
 
         // rune: test subcommand
         else if (dk_cmdline_subcommand(&cmd, "test")) {
-            dk_run_tests();
+            i64 thread_count = 1;
+            bool ok = true;
+            if (dk_cmdline_subcommand(&cmd, "-j")) {
+                char *arg = dk_cmdline_pop(&cmd);
+                ok = arg && dk_parse_int(str_from_cstr(arg), &thread_count) && thread_count >= 0;
+                if (thread_count == 0) {
+                    thread_count = os_get_processor_count();
+                }
+            }
+
+            if (ok) {
+                dk_run_tests(thread_count);
+            } else {
+                println("Invalid thread count. Expected a number after -j.");
+            }
+        }
+
+        // rune: bench subcommand
+        else if (dk_cmdline_subcommand(&cmd, "bench")) {
+            dk_run_bench();
         }
 
         else {